@@ -1,7 +1,7 @@
 @echo off
 
 set includes=/I dependencies\Glad\include /I dependencies\GLFW\include /I src /I dependencies\stb\include
-set libs=dependencies\GLFW\lib\glfw3.lib dependencies\Glad\lib\glad.lib Shell32.lib User32.lib Gdi32.lib OpenGL32.lib msvcrt.lib
+set libs=dependencies\GLFW\lib\glfw3.lib dependencies\Glad\lib\glad.lib Shell32.lib User32.lib Gdi32.lib OpenGL32.lib Ws2_32.lib msvcrt.lib
 
 rem Libraries
 cl /Ox /EHsc /c dependencies\stb\src\*.cpp  /I dependencies\stb\include
@@ -15,14 +15,35 @@ cl /MT /Ox /EHsc /c src/engine/*.cpp %includes%
 cl /MT /Ox /EHsc /c src/platform/*.cpp %includes%
 
 cl /MT /Ox /EHsc /c src/game/*.cpp %includes%
+cl /MT /Ox /EHsc /c src/net/*.cpp %includes%
+
+rem Everything except the entry points goes in a library so the headless
+rem tools only pull in what they use (no window or OpenGL code)
+lib *.obj /OUT:ttt.lib
+del *.obj
 
 cl /MT /Ox /EHsc /c src/main.cpp %includes%
 
 rem Resources
 rc resources.rc
 
-link *.obj *.res %libs% /OUT:ttt.exe /NODEFAULTLIB:LIBCMT /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup
+link main.obj *.res ttt.lib %libs% /OUT:ttt.exe /NODEFAULTLIB:LIBCMT /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup
+del main.obj
+
+rem Headless tools
+cl /MT /Ox /EHsc /c src/tools/*.cpp %includes%
+cl /MT /Ox /EHsc /c src/cli.cpp %includes%
+
+link *.obj ttt.lib msvcrt.lib Ws2_32.lib /OUT:tttcli.exe /NODEFAULTLIB:LIBCMT /SUBSYSTEM:CONSOLE
+del *.obj
+
+rem C API for other programs, ttt_api.lib is its import library
+cl /MT /Ox /EHsc /c /DTTT_BUILD_DLL src/capi/*.cpp %includes%
+
+link /DLL ttt_api.obj ttt.lib msvcrt.lib /OUT:ttt_api.dll /NODEFAULTLIB:LIBCMT
+del ttt_api.exp
 
 rem Delete intermediate files
 del *.obj
-del *.res
\ No newline at end of file
+del *.res
+del ttt.lib
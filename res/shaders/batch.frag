@@ -0,0 +1,18 @@
+#version 330 core
+
+in vec2 v_texCoord;
+in vec4 v_color;
+
+uniform sampler2D u_atlas;
+uniform int u_textured;
+uniform float u_layer;
+
+out vec4 color;
+
+void main()
+{
+    if (u_textured != 0)
+        color = v_color * texture(u_atlas, v_texCoord);
+    else
+        color = v_color;
+}
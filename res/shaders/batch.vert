@@ -0,0 +1,32 @@
+#version 330 core
+
+layout (location = 0) in vec4 a_rect;
+layout (location = 1) in vec4 a_uvs;
+layout (location = 2) in vec4 a_color;
+
+uniform sampler2D u_atlas;
+uniform int u_textured;
+uniform float u_layer;
+
+out vec2 v_texCoord;
+out vec4 v_color;
+
+void main()
+{
+    // Same corners as rect.vert, drawn as a strip
+    vec2 vertices[] = vec2[](
+        vec2(0, 0),
+        vec2(0, 1),
+        vec2(1, 0),
+        vec2(1, 1)
+    );
+
+    vec2 corner = vertices[gl_VertexID];
+    vec4 position = vec4(corner * a_rect.zw, u_layer, 1);
+    position.y *= -1;
+    position.xy += a_rect.xy;
+
+    gl_Position = position;
+    v_texCoord  = mix(a_uvs.xy, a_uvs.zw, corner);
+    v_color     = a_color;
+}
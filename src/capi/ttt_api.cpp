@@ -0,0 +1,254 @@
+#include "ttt_api.h"
+
+#include <new>
+#include "universal/types.h"
+#include "game/board.h"
+#include "game/match.h"
+#include "game/search.h"
+
+// Everything a handle needs is made in ttt_create. The board vectors are
+// sized once there, so play, search and batches only reuse them.
+struct ttt_game
+{
+    Match match;
+    Board scratch;      // Batch positions go through here
+    Searcher searcher;
+    TranspositionTable table;
+};
+
+static const s32 DEFAULT_HASH_LOG2 = 16;
+static const s32 MAX_HASH_LOG2     = 30;
+
+// The byte values in the header are the CellElement values, so caller
+// buffers are read as layouts directly once they've been checked
+static_assert(TTT_CROSS == (s32) CellElement::CROSS && TTT_CIRCLE == (s32) CellElement::CIRCLE &&
+              TTT_EMPTY == (s32) CellElement::EMPTY && sizeof(CellElement) == 1, "Cell values differ");
+static_assert(TTT_WIN_SCORE == WIN_SCORE, "Win scores differ");
+
+static bool IsValidLayout(const uint8_t cells[], s32 numCells)
+{
+    for (s32 i = 0; i < numCells; i++)
+    {
+        if (cells[i] > TTT_EMPTY)
+            return false;
+    }
+
+    return true;
+}
+
+// Only the player who moved last can have a line, and only through one of their elements
+static MatchStatus GetStatus(const Board& board)
+{
+    CellElement last = (CellElement) (1 - board.playerIndex);
+    for (s32 cell = 0; cell < board.numCells; cell++)
+    {
+        if (board.cells[cell] == last && board.WonThrough(cell))
+            return last == CellElement::CROSS ? MatchStatus::CROSS_WON : MatchStatus::CIRCLE_WON;
+    }
+
+    return board.IsFull() ? MatchStatus::DRAW : MatchStatus::PLAYING;
+}
+
+static SearchLimits ToLimits(const ttt_limits* limits)
+{
+    SearchLimits out = {};
+    if (limits)
+    {
+        out.depth = limits->depth > 0 ? limits->depth : 0;
+        out.nodes = limits->nodes;
+        out.time  = limits->seconds > 0.0 ? limits->seconds : 0.0;
+    }
+
+    return out;
+}
+
+static void Search(ttt_game* game, Board& board, const SearchLimits& limits, ttt_result* result)
+{
+    SearchResult found = game->searcher.Search(board, limits);
+    result->move     = found.move;
+    result->score    = found.score;
+    result->depth    = found.depth;
+    result->reserved = 0;
+    result->nodes    = found.nodes;
+}
+
+static void SetOver(ttt_result* result)
+{
+    result->move     = -1;
+    result->score    = 0;
+    result->depth    = 0;
+    result->reserved = 0;
+    result->nodes    = 0;
+}
+
+uint32_t ttt_version(void)
+{
+    return TTT_VERSION;
+}
+
+ttt_game* ttt_create(int32_t size, int32_t win_length, int32_t hash_log2)
+{
+    if (size < 1 || size > Board::MAX_SIZE || win_length < 1 || win_length > size ||
+        hash_log2 < 0 || hash_log2 > MAX_HASH_LOG2)
+        return nullptr;
+
+    // No C++ exceptions across the boundary
+    try
+    {
+        ttt_game* game = new ttt_game {};
+        game->match.Start(size, win_length);
+        game->scratch.Init(size, win_length);
+        game->table.Init(hash_log2 ? hash_log2 : DEFAULT_HASH_LOG2);
+        game->searcher.table = &game->table;
+        return game;
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void ttt_destroy(ttt_game* game)
+{
+    delete game;
+}
+
+int32_t ttt_reset(ttt_game* game, int32_t first_player)
+{
+    if (!game || (first_player != TTT_CROSS && first_player != TTT_CIRCLE))
+        return TTT_INVALID;
+
+    Match& match = game->match;
+    match.Start(match.board.size, match.board.winLength, first_player);
+    return TTT_OK;
+}
+
+int32_t ttt_set_position(ttt_game* game, const uint8_t* cells, int32_t player_to_move)
+{
+    if (!game || !cells || (player_to_move != TTT_CROSS && player_to_move != TTT_CIRCLE) ||
+        !IsValidLayout(cells, game->match.board.numCells))
+        return TTT_INVALID;
+
+    Match& match = game->match;
+    match.SetPosition((const CellElement*) cells, player_to_move);
+    match.status = GetStatus(match.board);
+    return TTT_OK;
+}
+
+int32_t ttt_play(ttt_game* game, int32_t cell)
+{
+    if (!game)
+        return TTT_INVALID;
+
+    Match& match = game->match;
+    if (match.IsOver())
+        return TTT_GAME_OVER;
+
+    return match.Play(cell) ? TTT_OK : TTT_ILLEGAL_MOVE;
+}
+
+int32_t ttt_status(const ttt_game* game)
+{
+    return game ? (int32_t) game->match.status : TTT_INVALID;
+}
+
+int32_t ttt_player_to_move(const ttt_game* game)
+{
+    return game ? game->match.board.playerIndex : TTT_INVALID;
+}
+
+int32_t ttt_move_count(const ttt_game* game)
+{
+    return game ? game->match.board.moveCount : TTT_INVALID;
+}
+
+int32_t ttt_size(const ttt_game* game)
+{
+    return game ? game->match.board.size : TTT_INVALID;
+}
+
+int32_t ttt_get_cells(const ttt_game* game, uint8_t* cells)
+{
+    if (!game || !cells)
+        return TTT_INVALID;
+
+    const Board& board = game->match.board;
+    for (s32 i = 0; i < board.numCells; i++)
+        cells[i] = (uint8_t) board.cells[i];
+
+    return TTT_OK;
+}
+
+int32_t ttt_search(ttt_game* game, const ttt_limits* limits, ttt_result* result)
+{
+    if (!game || !result)
+        return TTT_INVALID;
+
+    if (game->match.IsOver())
+    {
+        SetOver(result);
+        return TTT_GAME_OVER;
+    }
+
+    // Searches make and undo moves, the match's board ends up as it was
+    Search(game, game->match.board, ToLimits(limits), result);
+    return TTT_OK;
+}
+
+int32_t ttt_clear_hash(ttt_game* game)
+{
+    if (!game)
+        return TTT_INVALID;
+
+    game->table.Clear();
+    return TTT_OK;
+}
+
+int32_t ttt_search_batch(ttt_game* game, const uint8_t* cells, const uint8_t* players,
+                         int64_t count, const ttt_limits* limits, ttt_result* results)
+{
+    if (!game || count < 0 || (count > 0 && (!cells || !results)))
+        return TTT_INVALID;
+
+    Board& board = game->scratch;
+    SearchLimits searchLimits = ToLimits(limits);
+    s32 numCells = board.numCells;
+
+    for (s64 i = 0; i < count; i++)
+    {
+        const uint8_t* layout = cells + i * numCells;
+        if (!IsValidLayout(layout, numCells))
+        {
+            SetOver(&results[i]);
+            continue;
+        }
+
+        s32 player;
+        if (players)
+            player = players[i];
+        else
+        {
+            s32 crosses = 0, circles = 0;
+            for (s32 c = 0; c < numCells; c++)
+            {
+                crosses += layout[c] == TTT_CROSS;
+                circles += layout[c] == TTT_CIRCLE;
+            }
+            player = crosses > circles ? TTT_CIRCLE : TTT_CROSS;
+        }
+
+        if (player != TTT_CROSS && player != TTT_CIRCLE)
+        {
+            SetOver(&results[i]);
+            continue;
+        }
+
+        board.SetPosition((const CellElement*) layout, player);
+        if (GetStatus(board) != MatchStatus::PLAYING)
+            SetOver(&results[i]);
+        else
+            Search(game, board, searchLimits, &results[i]);
+    }
+
+    return TTT_OK;
+}
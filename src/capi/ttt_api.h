@@ -0,0 +1,120 @@
+#ifndef TTT_API_H
+#define TTT_API_H
+
+/*
+ * C interface to the rules and computer player, built as ttt_api.dll by
+ * build.bat so other programs can use them in process. Plain C with fixed
+ * width types and an opaque handle, so it stays the same whatever happens
+ * to the C++ behind it. ttt_version goes up when something is added.
+ *
+ * Cells are numbered row by row from 0 and hold TTT_CROSS, TTT_CIRCLE or
+ * TTT_EMPTY, one byte each. A handle isn't thread safe, use one per thread.
+ * Nothing here allocates after ttt_create, batch calls read and write
+ * straight from and into the caller's buffers.
+ */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+    #ifdef TTT_BUILD_DLL
+        #define TTT_API __declspec(dllexport)
+    #else
+        #define TTT_API __declspec(dllimport)
+    #endif
+#else
+    #define TTT_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TTT_VERSION 1
+
+/* Cell contents, also the players */
+#define TTT_CROSS  0
+#define TTT_CIRCLE 1
+#define TTT_EMPTY  2
+
+/* ttt_status */
+#define TTT_PLAYING     0
+#define TTT_CROSS_WON   1
+#define TTT_CIRCLE_WON  2
+#define TTT_DRAW        3
+
+/* Return codes, everything that can fail returns one */
+#define TTT_OK              0
+#define TTT_INVALID        -1   /* Bad handle, size or buffer */
+#define TTT_ILLEGAL_MOVE   -2
+#define TTT_GAME_OVER      -3
+
+/* Scores at or beyond these are forced wins or losses, TTT_WIN_SCORE - n
+   being a win n plies from the position */
+#define TTT_WIN_SCORE 100000000
+
+typedef struct ttt_game ttt_game;
+
+/* 0 means no limit for any of them. A time limit makes results depend on
+   machine speed, depth and node limits always give the same move. */
+typedef struct ttt_limits
+{
+    int32_t depth;
+    int32_t reserved;
+    uint64_t nodes;
+    double seconds;
+} ttt_limits;
+
+typedef struct ttt_result
+{
+    int32_t move;       /* -1 if the game is over */
+    int32_t score;      /* For the player to move */
+    int32_t depth;      /* Deepest iteration finished */
+    int32_t reserved;
+    uint64_t nodes;
+} ttt_result;
+
+TTT_API uint32_t ttt_version(void);
+
+/* size from 1 to 19, win_length from 1 to size. hash_log2 sizes the
+   computer's table, 2^hash_log2 entries of 16 bytes, 0 for the default.
+   NULL if the arguments are out of range or memory ran out. */
+TTT_API ttt_game* ttt_create(int32_t size, int32_t win_length, int32_t hash_log2);
+TTT_API void ttt_destroy(ttt_game* game);
+
+/* Empty board with first_player to move */
+TTT_API int32_t ttt_reset(ttt_game* game, int32_t first_player);
+
+/* cells has size * size entries. The status is worked out from the
+   position, counting a line for the player who moved last. */
+TTT_API int32_t ttt_set_position(ttt_game* game, const uint8_t* cells, int32_t player_to_move);
+
+TTT_API int32_t ttt_play(ttt_game* game, int32_t cell);
+
+TTT_API int32_t ttt_status(const ttt_game* game);
+TTT_API int32_t ttt_player_to_move(const ttt_game* game);
+TTT_API int32_t ttt_move_count(const ttt_game* game);
+TTT_API int32_t ttt_size(const ttt_game* game);
+
+/* Copies the board into cells, which needs size * size bytes */
+TTT_API int32_t ttt_get_cells(const ttt_game* game, uint8_t* cells);
+
+/* The computer's move for the current position. The table is kept
+   between searches, ttt_clear_hash makes a search independent of earlier
+   ones. */
+TTT_API int32_t ttt_search(ttt_game* game, const ttt_limits* limits, ttt_result* result);
+TTT_API int32_t ttt_clear_hash(ttt_game* game);
+
+/* Searches count positions of the game's size one after the other.
+   cells holds them back to back, size * size bytes each, and players the
+   player to move in each, or NULL to take it from the counts with cross
+   moving first. results[i] is filled for position i, a position that's
+   over or doesn't make sense gets move -1. The game's own position isn't
+   touched. */
+TTT_API int32_t ttt_search_batch(ttt_game* game, const uint8_t* cells, const uint8_t* players,
+                                 int64_t count, const ttt_limits* limits, ttt_result* results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+#include <cstring>
+#include <iostream>
+#include "tools/tools.h"
+
+static const Tool tools[] = {
+    { "perft", "perft [-size 3] [-win 3] [-depth 9] [-threads N] [-split 2] [-fixed] [-unique]", RunPerft },
+    { "bench", "bench [-repeat 3]   (Board against FixedBoard perft on the small variants)", RunBench },
+    { "selfplay", "selfplay [-size 3] [-win 3] [-games 10000] [-nodes 10000] [-depth 0] [-random 2] [-shard 65536] [-queue 8] [-check] [-out selfplay] [-net file] [-threads N]", RunSelfPlay },
+    { "tournament", "tournament [-players search,random] [-gauntlet] [-pairs 50] [-opening 2] [-size 3] [-win 3] [-elo0 0] [-elo1 10] [-alpha 0.05] [-beta 0.05] [-net file] [-threads N]", RunTournament },
+    { "calibrate", "calibrate [-reference random] [-pairs 200] [-opening 1] [-size 3] [-win 3] [-threads N]", RunCalibrate },
+    { "puzzles", "puzzles [-size 3] [-win 3] [-min 2] [-max 3] [-count 1000] [-positions 1000000] [-random 50] [-out puzzles.ttp] [-threads N]", RunPuzzles },
+    { "connect4", "connect4 [-moves 4453] [-bench 100] [-plies 20] [-weak] [-hash 22] [-seed 1]", RunConnectFour },
+    { "infinite", "infinite [-moves 100000] [-win 5] [-jump 1] [-spread 1000] [-seed 1]", RunInfinite },
+    { "engine", "engine [-hash 20] [-net file]   (protocol on stdin/stdout, see src/tools/engine.cpp)", RunEngine },
+    { "server", "server [-port 7474] [-local] [-matches 4096] [-seconds 0] [-journal prefix] [-snapshot 10] [-net file] [-threads N]   (protocol in src/net/protocol.h)", RunServer },
+    { "loadgen", "loadgen [-host 127.0.0.1] [-port 7474] [-players 1000] [-think exp:100] [-agent random] [-level 0] [-seconds 10] [-size 3] [-win 3] [-report file] [-serve] [-workers 2] [-threads N]", RunLoadGen },
+    { "matchmaking", "matchmaking [-players 200000] [-rate 0] [-variants 3] [-controls 4] [-spread 3] [-widen 200] [-capacity 12] [-threads N]", RunMatchmaking },
+    { "journal", "journal [-matches 100000] [-size 3] [-win 3] [-moves 6] [-path journal_check]", RunJournal },
+    { "spectate", "spectate [-matches 8] [-viewers 2000] [-late 0.5] [-size 15] [-win 5] [-interval 20] [-seconds 60] [-workers 2] [-threads N]", RunSpectate },
+    { "clocks", "clocks [-games 256] [-tc 2+0.02] [-agent search:nodes=0] [-size 7] [-win 5] [-seed 1]", RunClocks },
+    { "replays", "replays [-games 1000000] [-size 3] [-win 3] [-seeks 100000] [-path replay_check.ttr] [-seed 1]", RunReplays },
+    { "annotate", "annotate [-in positions.txt] [-out results.txt] [-nodes 100000] [-depth 0] [-threads N] [-hash 22] [-batch 4096] [-net file] [-check]   (format in src/game/annotate.h)", RunAnnotate },
+    { "nnue", "nnue [-networks 20] [-positions 5000] [-size 15] [-seed 1]   (SSE2/AVX2 network code against plain loops)", RunNetworkCheck },
+};
+
+int main(int argc, const char* argv[])
+{
+    if (argc >= 2)
+    {
+        for (const Tool& tool : tools)
+        {
+            if (strcmp(argv[1], tool.name) == 0)
+                return tool.Run(argc - 2, argv + 2);
+        }
+
+        std::cout << "Command '" << argv[1] << "' not recognised" << std::endl;
+    }
+
+    std::cout << "Usage: tttcli <command> [flags]\n";
+    for (const Tool& tool : tools)
+        std::cout << "    " << tool.usage << "\n";
+
+    return 1;
+}
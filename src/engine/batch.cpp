@@ -0,0 +1,120 @@
+#include "batch.h"
+
+#include <vector>
+#include <glad/glad.h>
+#include "universal/types.h"
+#include "platform/application.h"
+#include "shader.h"
+#include "sprite.h"
+#include "ui.h"
+
+// Shared by every batch, loaded by the first Init
+static Shader batchShader;
+
+void QuadBatch::Init()
+{
+    static bool initialized = false;
+
+    if (!initialized)
+    {
+        batchShader.LoadShader("res/shaders/batch.vert", Shader::Type::VERTEX_SHADER);
+        batchShader.LoadShader("res/shaders/batch.frag", Shader::Type::FRAGMENT_SHADER);
+        batchShader.Compile();
+        initialized = true;
+    }
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    // One Quad per instance, the corners come from gl_VertexID
+    for (u32 i = 0; i < 3; i++)
+    {
+        glEnableVertexAttribArray(i);
+        glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*) (i * sizeof(Vec4)));
+        glVertexAttribDivisor(i, 1);
+    }
+
+    glBindVertexArray(0);
+
+    capacity = 0;
+    quads.clear();
+}
+
+void QuadBatch::Free()
+{
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void QuadBatch::Clear()
+{
+    quads.clear();
+}
+
+// Reference pixels to the clip space rect the shader wants
+static Vec4 ToClipSpace(Application* app, const UI::Rect& rect)
+{
+    Vec4 clip;
+    clip.x = 2.0f * (rect.topLeft.x / app->refScreenWidth) - 1.0f;
+    clip.y = 1.0f - 2.0f * (rect.topLeft.y / app->refScreenHeight);
+    clip.z = 2.0f * (rect.size.x / app->refScreenWidth);
+    clip.w = 2.0f * (rect.size.y / app->refScreenHeight);
+    return clip;
+}
+
+void QuadBatch::AddRect(Application* app, const UI::Rect& rect, Vec4 color)
+{
+    Quad quad;
+    quad.rect  = ToClipSpace(app, rect);
+    quad.uvs   = { 0.0f, 0.0f, 0.0f, 0.0f };
+    quad.color = color;
+
+    quads.push_back(quad);
+}
+
+void QuadBatch::AddSprite(Application* app, const UI::Rect& rect, const Sprite& sprite)
+{
+    Quad quad;
+    quad.rect = ToClipSpace(app, rect);
+
+    // The same corners Sprite::Set gives its vertices
+    quad.uvs   = { sprite.uvs.t, sprite.uvs.s, sprite.uvs.u, sprite.uvs.v };
+    quad.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    quads.push_back(quad);
+}
+
+void QuadBatch::Draw(SpriteAtlas* atlas, f32 layer)
+{
+    if (quads.empty())
+        return;
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    // Grows to the biggest frame and is then only ever overwritten
+    u32 bytes = (u32) (quads.size() * sizeof(Quad));
+    if (quads.size() > capacity)
+    {
+        glBufferData(GL_ARRAY_BUFFER, bytes, quads.data(), GL_STREAM_DRAW);
+        capacity = (u32) quads.size();
+    }
+    else
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, quads.data());
+    }
+
+    if (atlas)
+        atlas->Bind(0);
+
+    batchShader.Bind();
+    batchShader.SetUniform1i("u_atlas", 0);
+    batchShader.SetUniform1i("u_textured", atlas ? 1 : 0);
+    batchShader.SetUniform1f("u_layer", layer);
+
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) quads.size());
+    glBindVertexArray(0);
+}
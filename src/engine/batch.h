@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include "platform/application.h"
+#include "universal/types.h"
+#include "sprite.h"
+#include "ui.h"
+
+// Any number of rects or sprites drawn with one instanced draw call. Quads
+// are added in reference pixels like UI::RenderRect and only go to the GPU
+// in Draw, as one buffer upload for the lot.
+struct QuadBatch
+{
+    struct Quad
+    {
+        Vec4 rect;      // Left, top, width and height in clip space
+        Vec4 uvs;       // Left, top, right and bottom texture coordinates
+        Vec4 color;     // Multiplies the texture, or the whole colour untextured
+    };
+
+    std::vector<Quad> quads;
+    u32 vao, instanceVBO;
+    u32 capacity;       // Quads the buffer has room for
+
+    void Init();
+    void Free();
+
+    void Clear();
+    void AddRect(Application* app, const UI::Rect& rect, Vec4 color);
+
+    // Fills rect with the sprite's part of its atlas
+    void AddSprite(Application* app, const UI::Rect& rect, const Sprite& sprite);
+
+    // Everything added since Clear, atlas is null if there are only rects
+    void Draw(SpriteAtlas* atlas, f32 layer);
+};
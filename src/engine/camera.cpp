@@ -0,0 +1,109 @@
+#include "camera.h"
+
+#include <cmath>
+#include "platform/application.h"
+#include "universal/types.h"
+#include "ui.h"
+
+void Camera::Fit(s32 columns, s32 rows)
+{
+    f32 across = (f32) (columns > rows ? columns : rows);
+
+    center   = { columns / 2.0f, rows / 2.0f };
+    cellSize = viewport.size.x < viewport.size.y ? viewport.size.x / across : viewport.size.y / across;
+    dragging = false;
+}
+
+Vec2 Camera::CellToScreen(f32 x, f32 y) const
+{
+    return {
+        viewport.topLeft.x + viewport.size.x / 2.0f + (x - center.x) * cellSize,
+        viewport.topLeft.y + viewport.size.y / 2.0f - (y - center.y) * cellSize,
+    };
+}
+
+Vec2 Camera::ScreenToGrid(Vec2 screen) const
+{
+    return {
+        center.x + (screen.x - viewport.topLeft.x - viewport.size.x / 2.0f) / cellSize,
+        center.y - (screen.y - viewport.topLeft.y - viewport.size.y / 2.0f) / cellSize,
+    };
+}
+
+bool Camera::Contains(Vec2 screen) const
+{
+    return screen.x >= viewport.topLeft.x && screen.x < viewport.topLeft.x + viewport.size.x &&
+           screen.y >= viewport.topLeft.y && screen.y < viewport.topLeft.y + viewport.size.y;
+}
+
+void Camera::GetVisibleCells(s32& minX, s32& minY, s32& maxX, s32& maxY) const
+{
+    Vec2 topLeft     = ScreenToGrid(viewport.topLeft);
+    Vec2 bottomRight = ScreenToGrid(viewport.topLeft + viewport.size);
+
+    minX = (s32) floorf(topLeft.x);
+    maxY = (s32) floorf(topLeft.y);
+    maxX = (s32) floorf(bottomRight.x);
+    minY = (s32) floorf(bottomRight.y);
+}
+
+void Camera::Pan(Vec2 pixels)
+{
+    center.x -= pixels.x / cellSize;
+    center.y += pixels.y / cellSize;
+}
+
+void Camera::ZoomAt(Vec2 screen, f32 factor)
+{
+    Vec2 before = ScreenToGrid(screen);
+
+    cellSize *= factor;
+    if (cellSize < minCellSize)
+        cellSize = minCellSize;
+    if (cellSize > maxCellSize)
+        cellSize = maxCellSize;
+
+    // Shift so the same grid position ends up under screen again
+    Vec2 after = ScreenToGrid(screen);
+    center.x += before.x - after.x;
+    center.y += before.y - after.y;
+}
+
+void Camera::Update(Application* app)
+{
+    // Three quarters of the viewport per second
+    f32 speed = viewport.size.y * 0.75f * (f32) app->deltaTime;
+
+    if (app->GetKey(KEY(LEFT))  || app->GetKey(KEY(A)))
+        Pan({ speed, 0.0f });
+    if (app->GetKey(KEY(RIGHT)) || app->GetKey(KEY(D)))
+        Pan({ -speed, 0.0f });
+    if (app->GetKey(KEY(UP))    || app->GetKey(KEY(W)))
+        Pan({ 0.0f, speed });
+    if (app->GetKey(KEY(DOWN))  || app->GetKey(KEY(S)))
+        Pan({ 0.0f, -speed });
+
+    Vec2 middle = viewport.topLeft + viewport.size * 0.5f;
+    if (app->GetKey(KEY(EQUAL)) || app->GetKey(KEY(KP_ADD)))
+        ZoomAt(middle, 1.0f + 1.5f * (f32) app->deltaTime);
+    if (app->GetKey(KEY(MINUS)) || app->GetKey(KEY(KP_SUBTRACT)))
+        ZoomAt(middle, 1.0f / (1.0f + 1.5f * (f32) app->deltaTime));
+
+    Vec2 mouse = { (f32) app->mouseX, (f32) app->mouseY };
+    if (app->scrollY != 0.0 && Contains(mouse))
+        ZoomAt(mouse, powf(1.15f, (f32) app->scrollY));
+
+    if (app->GetMouseButton(MOUSE(2)))
+    {
+        if (dragging)
+            Pan(mouse - dragFrom);
+        else
+            dragging = Contains(mouse);
+
+        dragFrom = mouse;
+    }
+    else
+    {
+        dragging = false;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "platform/application.h"
+#include "universal/types.h"
+#include "ui.h"
+
+// Looks at a grid of square cells through a rectangle on the screen. Cell
+// (x, y) covers [x, x + 1) by [y, y + 1) with y going up, while screen
+// positions are in reference pixels with y going down like the rest of UI.
+struct Camera
+{
+    UI::Rect viewport;      // Where on the screen the grid is drawn
+    Vec2 center;            // Grid position in the middle of the viewport
+    f32 cellSize;           // Reference pixels per cell
+    f32 minCellSize;
+    f32 maxCellSize;
+
+    bool dragging;
+    Vec2 dragFrom;
+
+    // Shows columns by rows cells, as big as fit
+    void Fit(s32 columns, s32 rows);
+
+    Vec2 CellToScreen(f32 x, f32 y) const;     // Grid position to screen
+    Vec2 ScreenToGrid(Vec2 screen) const;
+
+    bool Contains(Vec2 screen) const;
+
+    // Cells at least partly inside the viewport, inclusive
+    void GetVisibleCells(s32& minX, s32& minY, s32& maxX, s32& maxY) const;
+
+    // Moves the grid along with the screen by pixels
+    void Pan(Vec2 pixels);
+
+    // Scales by factor keeping the grid position under screen in place
+    void ZoomAt(Vec2 screen, f32 factor);
+
+    // Arrow keys or WASD to pan, +/- or the mouse wheel to zoom,
+    // dragging with the right mouse button to pan
+    void Update(Application* app);
+};
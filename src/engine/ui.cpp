@@ -196,6 +196,23 @@ void RenderRect(Application* app, const Rect& rect, Vec4 color, f32 layer)
     glBindVertexArray(0);
 }
 
+void SetClipRect(Application* app, const Rect& rect)
+{
+    // Scissor works in window pixels with y going up
+    f32 scaleX = (f32) app->screenWidth  / app->refScreenWidth;
+    f32 scaleY = (f32) app->screenHeight / app->refScreenHeight;
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor((GLint) (rect.topLeft.x * scaleX),
+              (GLint) (app->screenHeight - (rect.topLeft.y + rect.size.y) * scaleY),
+              (GLsizei) (rect.size.x * scaleX), (GLsizei) (rect.size.y * scaleY));
+}
+
+void ClearClipRect()
+{
+    glDisable(GL_SCISSOR_TEST);
+}
+
 bool RenderButton(Application* app, ID id, const Rect& rect, Vec4 defaultColor,
                   Vec4 hoverColor, Vec4 pressedColor, f32 layer)
 {
@@ -235,6 +252,42 @@ bool RenderButton(Application* app, ID id, const Rect& rect, Vec4 defaultColor,
     return result;
 }
 
+bool RenderSlider(Application* app, ID id, const Rect& rect, f32& value, f32 layer)
+{
+    bool inside = app->mouseX >= rect.topLeft.x && app->mouseX <= rect.topLeft.x + rect.size.x &&
+                  app->mouseY >= rect.topLeft.y && app->mouseY <= rect.topLeft.y + rect.size.y;
+
+    if (inside && app->GetMouseButtonDown(MOUSE(1)))
+        data.active = id;
+
+    if (data.active == id && !app->GetMouseButton(MOUSE(1)))
+        data.active = UIInvalid();
+
+    // Keeps following the mouse when it's dragged off the slider
+    f32 previous = value;
+    if (data.active == id)
+    {
+        f32 t = (f32) (app->mouseX - rect.topLeft.x) / rect.size.x;
+        value = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    }
+
+    Vec4 trackColor = { 0.5f, 0.5f, 0.5f, 1.0f };
+    Vec4 handleColor = data.active == id ? Vec4 { 0.6f, 0.6f, 0.6f, 1.0f } :
+                       (inside ? Vec4 { 1.0f, 1.0f, 1.0f, 1.0f } : Vec4 { 0.8f, 0.8f, 0.8f, 1.0f });
+
+    Rect track;
+    track.topLeft = rect.topLeft + Vec2 { 0.0f, rect.size.y * 0.35f };
+    track.size    = { rect.size.x, rect.size.y * 0.3f };
+    RenderRect(app, track, trackColor, layer + 0.01f);
+
+    Rect handle;
+    handle.size    = { rect.size.y, rect.size.y };
+    handle.topLeft = rect.topLeft + Vec2 { value * rect.size.x - handle.size.x / 2.0f, 0.0f };
+    RenderRect(app, handle, handleColor, layer);
+
+    return value != previous;
+}
+
 bool RenderTextButton(Application* app, ID id, const std::string& text, const Font& font,
                     Vec2 padding, Vec2 topLeft, f32 layer)
 {
@@ -47,9 +47,17 @@ Vec2 GetRenderedTextSize(const std::string& text, const Font& font);
 void RenderText(Application* app, const std::string& text, const Font& font,
                 Vec4 color, Vec2 topLeft, f32 layer);
 void RenderRect(Application* app, const Rect& rect, Vec4 color, f32 layer);
+
+// Nothing outside rect gets drawn until ClearClipRect
+void SetClipRect(Application* app, const Rect& rect);
+void ClearClipRect();
 bool RenderButton(Application* app, ID id, const Rect& rect, Vec4 defaultColor,
                   Vec4 hoverColor, Vec4 pressedColor, f32 layer);
 
+// value goes from 0 at the left to 1 at the right and follows the mouse
+// while it's held down on the slider. True on frames it moved.
+bool RenderSlider(Application* app, ID id, const Rect& rect, f32& value, f32 layer);
+
 // Using default colors
 bool RenderTextButton(Application* app, ID id, const std::string& text, const Font& font,
                     Vec2 padding, Vec2 topLeft, f32 layer);
@@ -0,0 +1,117 @@
+#include "analysis.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+#include "search.h"
+
+Analysis::~Analysis()
+{
+    Stop();
+}
+
+void Analysis::Start(const Board& current)
+{
+    Stop();
+
+    if (table.IsEmpty())
+        table.Init(18);
+
+    board = current;
+    stopSignal = false;
+    running = true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        scores.assign(board.numCells, 0);
+        depth = 0;
+        hash = board.hash;
+    }
+
+    if (board.IsFull())
+        return;
+
+    thread = std::thread([this]()
+    {
+        Board position = board;
+
+        searcher = {};
+        searcher.table = &table;
+        searcher.network = network;
+        searcher.stopSignal = &stopSignal;
+        searcher.Prepare(position, SearchLimits {});
+        table.Clear();
+
+        // Every move gets a full window so all scores are exact, not just the best one
+        std::vector<s32> local(position.numCells, 0);
+        s32 moves[Board::MAX_MOVES];
+        s32 numMoves = position.GenerateMoves(moves);
+        s32 maxDepth = position.numCells - position.moveCount;
+
+        for (s32 d = 1; d <= maxDepth; d++)
+        {
+            bool allDecided = true;
+
+            for (s32 i = 0; i < numMoves && !searcher.stopped; i++)
+            {
+                s32 move = moves[i];
+                searcher.MakeMove(position, move);
+
+                s32 score;
+                if (position.WonThrough(move))
+                    score = WIN_SCORE - 1;
+                else if (position.IsFull())
+                    score = 0;
+                else
+                    score = -searcher.Negamax(position, d - 1, -INFINITE_SCORE, INFINITE_SCORE, 1);
+
+                searcher.UndoMove(position, move);
+
+                local[move] = score;
+                allDecided = allDecided && (IsWinScore(score) || position.moveCount + d >= position.numCells);
+            }
+
+            if (searcher.stopped)
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                scores = local;
+                depth = d;
+            }
+
+            if (allDecided)
+                return;
+        }
+    });
+}
+
+void Analysis::Stop()
+{
+    if (!running)
+        return;
+
+    stopSignal = true;
+    if (thread.joinable())
+        thread.join();
+    running = false;
+}
+
+void Analysis::Follow(const Board& current)
+{
+    if (!running || current.hash != board.hash)
+        Start(current);
+}
+
+s32 Analysis::GetScores(const Board& current, std::vector<s32>& out)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!running || hash != current.hash || depth == 0)
+        return 0;
+
+    out = scores;
+    return depth;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+#include "search.h"
+#include "nnue.h"
+
+// Scores every empty cell for the player to move on a background thread,
+// one depth at a time, so hints get better the longer they're looked at.
+// Nothing here waits on the search, the render loop just shows the
+// deepest finished set of scores.
+struct Analysis
+{
+    std::thread thread;
+    std::atomic<bool> stopSignal;
+    bool running { false };
+
+    Board board;                // Position being analysed
+    const Network* network;
+    Searcher searcher;
+    TranspositionTable table;
+
+    std::mutex mutex;           // Guards the results below
+    std::vector<s32> scores;    // Per cell, only valid for empty cells
+    s32 depth;                  // 0 until the first depth is done
+    u64 hash;                   // Position the scores are for
+
+    ~Analysis();
+
+    void Start(const Board& current);
+    void Stop();
+
+    // Restarts if the position changed
+    void Follow(const Board& current);
+
+    // Copies out the latest scores if they're for current.
+    // Returns the depth they're from, 0 if there are none yet.
+    s32 GetScores(const Board& current, std::vector<s32>& out);
+};
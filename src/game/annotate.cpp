@@ -0,0 +1,236 @@
+#include "annotate.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+#include "search.h"
+#include "nnue.h"
+
+// Only the player who moved last can have a line, and only through one of their elements
+static bool IsGameOver(const Board& board)
+{
+    if (board.IsFull())
+        return true;
+
+    CellElement last = (CellElement) (1 - board.playerIndex);
+    for (s32 cell = 0; cell < board.numCells; cell++)
+    {
+        if (board.cells[cell] == last && board.WonThrough(cell))
+            return true;
+    }
+
+    return false;
+}
+
+static void AnalyseOne(Searcher& searcher, const TranspositionTable& table, const SearchLimits& limits,
+                       Board& board, Annotation& out)
+{
+    out.move = -1;
+    out.score = 0;
+    out.depth = 0;
+    out.nodes = 0;
+    out.pvLength = 0;
+
+    if (IsGameOver(board))
+        return;
+
+    SearchResult result = searcher.Search(board, limits);
+    out.move  = result.move;
+    out.score = result.score;
+    out.depth = result.depth;
+    out.nodes = result.nodes;
+
+    // The rest of the line is whatever the table has as best after each
+    // move. Another thread can have replaced an entry, so every move is
+    // checked and the line stops at the first that doesn't fit.
+    out.pv[out.pvLength++] = result.move;
+    board.MakeMove(result.move);
+
+    s32 last = result.move;
+    while (out.pvLength < Annotation::MAX_PV && out.pvLength < result.depth &&
+           !board.WonThrough(last) && !board.IsFull())
+    {
+        TTEntry entry;
+        if (!table.Probe(board.hash, entry) || entry.move < 0 || entry.move >= board.numCells ||
+            board.cells[entry.move] != CellElement::EMPTY)
+            break;
+
+        last = entry.move;
+        out.pv[out.pvLength++] = last;
+        board.MakeMove(last);
+    }
+
+    for (s32 i = out.pvLength - 1; i >= 0; i--)
+        board.UndoMove(out.pv[i]);
+}
+
+Annotator::~Annotator()
+{
+    Shutdown();
+}
+
+void Annotator::Init(s32 threadCount, s32 hashLog2, const SearchLimits& searchLimits, const Network* net)
+{
+    Shutdown();
+
+    table.Init(hashLog2);
+    network = net;
+    limits = searchLimits;
+    numThreads = threadCount > 0 ? threadCount : 1;
+
+    searchers.assign(numThreads, Searcher {});
+    generation = 0;
+    working = 0;
+    stopping = false;
+    count = 0;
+
+    for (s32 t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([this, t]()
+        {
+            Searcher& searcher = searchers[t];
+            searcher.table = &table;
+            searcher.network = network;
+
+            u64 seen = 0;
+            while (true)
+            {
+                {   // Sleeps between batches
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]() { return stopping || generation != seen; });
+                    if (stopping)
+                        return;
+
+                    seen = generation;
+                }
+
+                for (s64 i = next++; i < count; i = next++)
+                    AnalyseOne(searcher, table, limits, boards[i], results[i]);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--working == 0)
+                    done.notify_all();
+            }
+        });
+    }
+}
+
+void Annotator::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    threads.clear();
+}
+
+void Annotator::Analyse(Board batchBoards[], Annotation batchResults[], s64 batchCount)
+{
+    if (batchCount <= 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    boards  = batchBoards;
+    results = batchResults;
+    count   = batchCount;
+    next    = 0;
+    working = numThreads;
+    generation++;
+    wake.notify_all();
+
+    done.wait(lock, [&]() { return working == 0; });
+}
+
+std::string CellName(s32 index, s32 size)
+{
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%c%d", 'a' + index % size, index / size + 1);
+    return buffer;
+}
+
+s32 ParseCell(const char name[], s32 length, s32 size)
+{
+    if (length < 2 || name[0] < 'a')
+        return -1;
+
+    s32 col = name[0] - 'a';
+    s32 row = atoi(name + 1) - 1;
+    if (col >= size || row < 0 || row >= size)
+        return -1;
+
+    return row * size + col;
+}
+
+bool ParsePosition(const char line[], Board& board)
+{
+    s32 size, winLength, read;
+    if (sscanf(line, "%d %d%n", &size, &winLength, &read) != 2 ||
+        size < 1 || size > Board::MAX_SIZE || winLength < 1 || winLength > size)
+        return false;
+
+    if (board.cells.empty() || board.size != size || board.winLength != winLength)
+        board.Init(size, winLength);
+    else
+        board.Clear();
+
+    // Moves up to the end of the game, none after it
+    bool over = false;
+    const char* at = line + read;
+    while (true)
+    {
+        while (*at == ' ' || *at == '\t' || *at == '\r' || *at == '\n')
+            at++;
+        if (!*at)
+            return true;
+
+        s32 length = 0;
+        while (at[length] && at[length] != ' ' && at[length] != '\t' && at[length] != '\r' && at[length] != '\n')
+            length++;
+
+        s32 cell = ParseCell(at, length, size);
+        if (over || cell < 0 || board.cells[cell] != CellElement::EMPTY)
+            return false;
+
+        board.MakeMove(cell);
+        over = board.WonThrough(cell) || board.IsFull();
+        at += length;
+    }
+}
+
+void FormatAnnotation(const Annotation& annotation, s32 size, std::string& out)
+{
+    if (annotation.move < 0)
+    {
+        out = "bestmove none";
+        return;
+    }
+
+    char buffer[96];
+    s32 score = annotation.score;
+    if (score >= WIN_SCORE - Board::MAX_MOVES)
+        sprintf(buffer, "win %d", WIN_SCORE - score);
+    else if (score <= -(WIN_SCORE - Board::MAX_MOVES))
+        sprintf(buffer, "win -%d", WIN_SCORE + score);
+    else
+        sprintf(buffer, "cp %d", score);
+
+    out = "bestmove " + CellName(annotation.move, size) + " score " + buffer;
+
+    sprintf(buffer, " depth %d nodes %llu pv", annotation.depth, annotation.nodes);
+    out += buffer;
+
+    for (s32 i = 0; i < annotation.pvLength; i++)
+        out += " " + CellName(annotation.pv[i], size);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+#include "search.h"
+#include "nnue.h"
+
+// What the analysis of one position came out as
+struct Annotation
+{
+    static const s32 MAX_PV = 32;
+
+    s32 move;           // -1 if the game was already over
+    s32 score;          // For the player to move, as in search.h
+    s32 depth;
+    u64 nodes;
+    s32 pv[MAX_PV];     // Starts with move
+    s32 pvLength;
+};
+
+// Best move, score and principal variation for big batches of positions.
+// Worker threads take positions off a shared counter and search them with
+// one transposition table between them, so positions from the same game
+// help each other along. Threads, searchers and the table are set up once
+// in Init and reused for every batch.
+//
+// Sharing the table means results can depend on which thread got to a
+// position first, node counts even with node limits.
+struct Annotator
+{
+    TranspositionTable table;
+    const Network* network;     // Can be null
+    SearchLimits limits;
+    s32 numThreads;
+
+    std::vector<Searcher> searchers;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    u64 generation;             // Goes up for every batch
+    s32 working;                // Threads still on the current batch
+    bool stopping;
+
+    // The batch being worked on
+    Board* boards;
+    Annotation* results;
+    s64 count;
+    std::atomic<s64> next;
+
+    ~Annotator();
+
+    void Init(s32 threads, s32 hashLog2, const SearchLimits& searchLimits, const Network* net);
+    void Shutdown();
+
+    // Fills results[i] for boards[i], returns when all of them are done.
+    // The boards are searched in place and left as they were.
+    void Analyse(Board boards[], Annotation results[], s64 count);
+};
+
+// Cells as a column letter and row number, "a1" being the top left. Used
+// by the annotate tool and the engine protocol.
+std::string CellName(s32 index, s32 size);
+
+// -1 if the length characters at name aren't a cell on the board
+s32 ParseCell(const char name[], s32 length, s32 size);
+
+// Text form used by "tttcli annotate", one position a line:
+//
+//   <size> <winLength> [<cell> ...]      the moves from an empty board
+//
+// Reuses board when it's already that size.
+bool ParsePosition(const char line[], Board& board);
+
+// "bestmove <cell> score <cp N | win N> depth D nodes N pv <cell> ..."
+void FormatAnnotation(const Annotation& annotation, s32 size, std::string& out);
@@ -0,0 +1,204 @@
+#include "board.h"
+
+#include "universal/types.h"
+#include "universal/random.h"
+
+// One key per cell per element, plus one for the player to move.
+// Fixed seed so hashes are the same from run to run. Every size and win
+// length also starts from a key of its own, as the same cells mean a
+// different position on another variant and tables can be shared.
+static struct
+{
+    u64 cells[Board::MAX_MOVES][2];
+    u64 playerToMove;
+} zobrist;
+
+static void InitZobrist()
+{
+    // Local statics are only initialized once, even with several threads
+    static bool initialized = []()
+    {
+        Random random;
+        random.Seed(0x7474745A6F62ULL);
+
+        for (s32 i = 0; i < Board::MAX_MOVES; i++)
+        {
+            zobrist.cells[i][0] = random.Next();
+            zobrist.cells[i][1] = random.Next();
+        }
+        zobrist.playerToMove = random.Next();
+
+        return true;
+    }();
+
+    (void) initialized;
+}
+
+void Board::Init(s32 boardSize, s32 lineLength)
+{
+    size      = boardSize;
+    winLength = lineLength;
+    numCells  = size * size;
+
+    InitZobrist();
+
+    Random random;
+    random.Seed(0x7474745A6F62ULL ^ ((u64) (u32) size << 32 | (u32) winLength));
+    variantKey = random.Next();
+
+    cells.resize(numCells);
+    Clear();
+}
+
+void Board::Clear(s32 firstPlayer)
+{
+    for (s32 i = 0; i < numCells; i++)
+        cells[i] = CellElement::EMPTY;
+
+    moveCount   = 0;
+    playerIndex = firstPlayer;
+    hash        = variantKey ^ (playerIndex ? zobrist.playerToMove : 0);
+}
+
+bool Board::IsFull() const
+{
+    return moveCount == numCells;
+}
+
+bool Board::WonThrough(s32 index) const
+{
+    static const s32 directions[4][2] = {
+        { 0, 1 },   // Horizontal
+        { 1, 0 },   // Vertical
+        { 1, 1 },   // Diagonal
+        { 1, -1 },  // Anti-diagonal
+    };
+
+    CellElement elem = cells[index];
+    if (elem == CellElement::EMPTY)
+        return false;
+
+    s32 row = index / size;
+    s32 col = index % size;
+
+    for (int d = 0; d < 4; d++)
+    {
+        s32 dr = directions[d][0];
+        s32 dc = directions[d][1];
+        s32 count = 1;
+
+        // Walk both ways from the placed element
+        for (s32 r = row + dr, c = col + dc;
+             r >= 0 && r < size && c >= 0 && c < size && cells[r * size + c] == elem;
+             r += dr, c += dc)
+            count++;
+
+        for (s32 r = row - dr, c = col - dc;
+             r >= 0 && r < size && c >= 0 && c < size && cells[r * size + c] == elem;
+             r -= dr, c -= dc)
+            count++;
+
+        if (count >= winLength)
+            return true;
+    }
+
+    return false;
+}
+
+s32 Board::GenerateMoves(s32 moves[]) const
+{
+    s32 count = 0;
+    for (s32 i = 0; i < numCells; i++)
+    {
+        if (cells[i] == CellElement::EMPTY)
+            moves[count++] = i;
+    }
+
+    return count;
+}
+
+void Board::MakeMove(s32 index)
+{
+    cells[index] = (CellElement) playerIndex;
+    hash ^= zobrist.cells[index][playerIndex] ^ zobrist.playerToMove;
+    moveCount++;
+    playerIndex = 1 - playerIndex;
+}
+
+void Board::UndoMove(s32 index)
+{
+    playerIndex = 1 - playerIndex;
+    cells[index] = CellElement::EMPTY;
+    hash ^= zobrist.cells[index][playerIndex] ^ zobrist.playerToMove;
+    moveCount--;
+}
+
+
+void Board::SetPosition(const CellElement layout[], s32 player)
+{
+    playerIndex = player;
+    moveCount = 0;
+    hash = variantKey ^ (playerIndex ? zobrist.playerToMove : 0);
+
+    for (s32 i = 0; i < numCells; i++)
+    {
+        cells[i] = layout[i];
+        if (cells[i] != CellElement::EMPTY)
+        {
+            hash ^= zobrist.cells[i][(int) cells[i]];
+            moveCount++;
+        }
+    }
+}
+
+CellElement Board::GetCell(s32 index) const
+{
+    return cells[index];
+}
+
+s32 Board::Transform(s32 index, s32 symmetry) const
+{
+    s32 row = index / size;
+    s32 col = index % size;
+    s32 last = size - 1;
+
+    // Reflect first, then rotate a quarter turn at a time
+    if (symmetry & 4)
+        col = last - col;
+
+    for (s32 i = 0; i < (symmetry & 3); i++)
+    {
+        s32 oldRow = row;
+        row = col;
+        col = last - oldRow;
+    }
+
+    return row * size + col;
+}
+
+u64 Board::CanonicalHash(s32* symmetry) const
+{
+    u64 best = hash;
+    s32 bestSymmetry = 0;
+
+    for (s32 candidate = 1; candidate < 8; candidate++)
+    {
+        u64 transformed = variantKey ^ (playerIndex ? zobrist.playerToMove : 0);
+        for (s32 i = 0; i < numCells; i++)
+        {
+            if (cells[i] != CellElement::EMPTY)
+                transformed ^= zobrist.cells[Transform(i, candidate)][(int) cells[i]];
+        }
+
+        if (transformed < best)
+        {
+            best = transformed;
+            bestSymmetry = candidate;
+        }
+    }
+
+    if (symmetry)
+        *symmetry = bestSymmetry;
+
+    return best;
+}
\ No newline at end of file
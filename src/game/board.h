@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include "universal/types.h"
+
+enum class CellElement : u8
+{
+    CROSS,
+    CIRCLE,
+    EMPTY,
+};
+
+// Just the rules of the game, no rendering or window state, so the
+// computer player and the headless tools can use them too.
+struct Board
+{
+    static constexpr s32 MAX_SIZE  = 19;
+    static constexpr s32 MAX_MOVES = MAX_SIZE * MAX_SIZE;
+
+    std::vector<CellElement> cells;
+    s32 size;           // Cells per side
+    s32 winLength;      // Elements in a row needed to win
+    s32 numCells;
+    s32 moveCount;
+    s32 playerIndex;    // Player to move
+    u64 hash;           // Zobrist hash of the variant, cells and player to move
+    u64 variantKey;     // Where hash starts from for this size and win length
+
+    void Init(s32 boardSize, s32 lineLength);
+    void Clear(s32 firstPlayer = 0);
+
+    bool IsFull() const;
+
+    // Only checks the lines going through index, so call it right
+    // after placing an element there.
+    bool WonThrough(s32 index) const;
+
+    // Fills moves with the empty cells and returns how many there are.
+    // moves should have space for MAX_MOVES entries.
+    s32 GenerateMoves(s32 moves[]) const;
+
+    void MakeMove(s32 index);
+    void UndoMove(s32 index);
+
+    // Replaces the whole position, layout has numCells entries
+    void SetPosition(const CellElement layout[], s32 player);
+
+    CellElement GetCell(s32 index) const;
+
+    // Where index ends up under one of the 8 rotations and reflections
+    s32 Transform(s32 index, s32 symmetry) const;
+
+    // Same for every position that's a rotation or reflection of this one.
+    // symmetry gets the Transform that takes this position to the one the
+    // hash is of, when it isn't null.
+    u64 CanonicalHash(s32* symmetry = nullptr) const;
+};
+
+// Fills out with the cells of board turned to the orientation its canonical
+// hash is of and returns that hash. Works on Board and FixedBoard alike,
+// out needs numCells entries.
+template <typename BoardType>
+u64 CanonicalPosition(const BoardType& board, CellElement out[])
+{
+    s32 symmetry;
+    u64 hash = board.CanonicalHash(&symmetry);
+
+    for (s32 index = 0; index < board.numCells; index++)
+        out[board.Transform(index, symmetry)] = board.GetCell(index);
+
+    return hash;
+}
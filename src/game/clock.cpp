@@ -0,0 +1,141 @@
+#include "clock.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include "universal/types.h"
+
+// Never think right up to the flag, the move still has to get played
+static const f64 SAFETY_MARGIN = 0.01;
+
+f64 GetMonotonicTime()
+{
+    using namespace std::chrono;
+    return duration<f64>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool TimeControl::Parse(const char spec[])
+{
+    base = increment = perMove = 0.0;
+
+    if (strcmp(spec, "none") == 0)
+        return true;
+
+    char* end;
+    if (strncmp(spec, "move:", 5) == 0)
+    {
+        perMove = strtod(spec + 5, &end);
+        return *end == '\0' && perMove > 0.0;
+    }
+
+    base = strtod(spec, &end);
+    if (*end == '+')
+        increment = strtod(end + 1, &end);
+
+    return *end == '\0' && base > 0.0 && increment >= 0.0;
+}
+
+bool TimeControl::IsTimed() const
+{
+    return base > 0.0 || perMove > 0.0;
+}
+
+void GameClock::Start(const TimeControl& timeControl, s32 firstPlayer, f64 now)
+{
+    control = timeControl;
+
+    f64 start = control.perMove > 0.0 ? control.perMove : control.base;
+    remaining[0] = start;
+    remaining[1] = start;
+
+    turnStart = now;
+    running = firstPlayer;
+    flagged = -1;
+    paused = false;
+}
+
+bool GameClock::Press(f64 now)
+{
+    if (running < 0)
+        return false;
+
+    s32 side = running;
+    f64 left = GetRemaining(side, now);
+
+    if (left <= 0.0)
+    {
+        remaining[side] = 0.0;
+        running = -1;
+        flagged = side;
+        return false;
+    }
+
+    remaining[side] = control.perMove > 0.0 ? control.perMove : left + control.increment;
+    running = 1 - side;
+    turnStart = now;
+    return true;
+}
+
+void GameClock::Stop(f64 now)
+{
+    if (running < 0)
+        return;
+
+    remaining[running] = GetRemaining(running, now);
+    running = -1;
+}
+
+void GameClock::Pause(f64 now)
+{
+    if (running < 0 || paused)
+        return;
+
+    remaining[running] = GetRemaining(running, now);
+    paused = true;
+}
+
+void GameClock::Resume(f64 now)
+{
+    if (!paused)
+        return;
+
+    turnStart = now;
+    paused = false;
+}
+
+f64 GameClock::GetRemaining(s32 side, f64 now) const
+{
+    if (side == running && !paused)
+        return remaining[side] - (now - turnStart);
+
+    return remaining[side];
+}
+
+bool GameClock::HasRunOut(f64 now) const
+{
+    return running >= 0 && GetRemaining(running, now) <= 0.0;
+}
+
+f64 GameClock::GetBudget(f64 now, s32 movesLeft) const
+{
+    if (running < 0)
+        return 0.0;
+
+    f64 left = GetRemaining(running, now) - SAFETY_MARGIN;
+    f64 budget;
+
+    if (control.perMove > 0.0)
+    {
+        budget = left;
+    }
+    else
+    {
+        // An even share of what's left plus most of what the move gives back,
+        // never more than half of it on one move
+        budget = left / (movesLeft > 1 ? movesLeft : 1) + control.increment * 0.8;
+        budget = budget < left * 0.5 ? budget : left * 0.5;
+    }
+
+    // 0 would mean no limit at all to a search
+    return budget > 0.001 ? budget : 0.001;
+}
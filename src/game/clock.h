@@ -0,0 +1,49 @@
+#pragma once
+
+#include "universal/types.h"
+
+// Seconds from an arbitrary point, from the steady high resolution clock
+// (QueryPerformanceCounter on Windows). Never jumps when the wall clock is
+// changed, so it's what game clocks run on.
+f64 GetMonotonicTime();
+
+// Written "base+increment" in seconds like "60+1", "move:5" for a fixed
+// time every move, or "none".
+struct TimeControl
+{
+    f64 base;
+    f64 increment;
+    f64 perMove;        // Instead of base and increment when it isn't 0
+
+    bool Parse(const char spec[]);
+    bool IsTimed() const;
+};
+
+// A chess clock. Only the side to move's time runs, pressing it ends that
+// turn and starts the other side's at the same instant. Times are passed
+// in rather than read so nothing is lost between the two.
+struct GameClock
+{
+    TimeControl control;
+    f64 remaining[2];   // Not counting the turn that's running
+    f64 turnStart;
+    s32 running;        // Side whose time is running, -1 when stopped
+    s32 flagged;        // Side that ran out, -1 if neither
+    bool paused;
+
+    void Start(const TimeControl& timeControl, s32 firstPlayer, f64 now);
+
+    // Ends the running side's turn. False if it had already run out,
+    // the clock stops with that side flagged then.
+    bool Press(f64 now);
+    void Stop(f64 now);
+    void Pause(f64 now);
+    void Resume(f64 now);
+
+    f64  GetRemaining(s32 side, f64 now) const;
+    bool HasRunOut(f64 now) const;
+
+    // How long the side to move can think with movesLeft of its own moves
+    // still to make, leaving some time for the ones after
+    f64 GetBudget(f64 now, s32 movesLeft) const;
+};
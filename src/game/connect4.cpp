@@ -0,0 +1,408 @@
+#include "connect4.h"
+
+#include <cstring>
+#include <vector>
+#include "universal/types.h"
+#include "universal/bits.h"
+#include "board.h"
+
+static const s32 W = ConnectFour::WIDTH;
+static const s32 H = ConnectFour::HEIGHT;
+
+static constexpr u64 BottomMask()
+{
+    u64 bottom = 0;
+    for (s32 column = 0; column < W; column++)
+        bottom |= 1ULL << (column * (H + 1));
+
+    return bottom;
+}
+
+static const u64 BOTTOM_MASK = BottomMask();
+static const u64 BOARD_MASK  = BOTTOM_MASK * ((1ULL << H) - 1);
+
+static u64 TopMask(s32 column)
+{
+    return 1ULL << (H - 1 + column * (H + 1));
+}
+
+static u64 BottomMaskOf(s32 column)
+{
+    return 1ULL << (column * (H + 1));
+}
+
+static u64 ColumnMask(s32 column)
+{
+    return ((1ULL << H) - 1) << (column * (H + 1));
+}
+
+// Four in a row anywhere in discs, one shift per direction
+static bool HasFour(u64 discs)
+{
+    static const s32 shifts[4] = {
+        1,          // Vertical
+        H + 1,      // Horizontal
+        H,          // Diagonal going down to the right
+        H + 2,      // Diagonal going up to the right
+    };
+
+    for (s32 shift : shifts)
+    {
+        u64 pairs = discs & (discs >> shift);
+        if (pairs & (pairs >> (2 * shift)))
+            return true;
+    }
+
+    return false;
+}
+
+// Empty cells that would complete four for the owner of discs
+static u64 WinningCells(u64 discs, u64 mask)
+{
+    // Vertical, only ever on top of three
+    u64 r = (discs << 1) & (discs << 2) & (discs << 3);
+
+    for (s32 shift : { H + 1, H, H + 2 })
+    {
+        u64 p = (discs << shift) & (discs << (2 * shift));
+        r |= p & (discs << (3 * shift));
+        r |= p & (discs >> shift);
+
+        p = (discs >> shift) & (discs >> (2 * shift));
+        r |= p & (discs << shift);
+        r |= p & (discs >> (3 * shift));
+    }
+
+    return r & (BOARD_MASK ^ mask);
+}
+
+void ConnectFour::Clear(s32 firstPlayer)
+{
+    current = mask = 0;
+    moveCount = 0;
+    playerIndex = firstPlayer;
+}
+
+bool ConnectFour::IsFull() const
+{
+    return moveCount == NUM_CELLS;
+}
+
+bool ConnectFour::CanPlay(s32 column) const
+{
+    return column >= 0 && column < W && (mask & TopMask(column)) == 0;
+}
+
+s32 ConnectFour::LandingRow(s32 column) const
+{
+    return PopCount(mask & ColumnMask(column));
+}
+
+bool ConnectFour::IsWinningMove(s32 column) const
+{
+    return (WinningCells(current, mask) & (mask + BOTTOM_MASK) & ColumnMask(column)) != 0;
+}
+
+void ConnectFour::Play(s32 column)
+{
+    PlayMask((mask + BottomMaskOf(column)) & ColumnMask(column));
+}
+
+void ConnectFour::PlayMask(u64 move)
+{
+    current ^= mask;
+    mask |= move;
+    moveCount++;
+    playerIndex = 1 - playerIndex;
+}
+
+bool ConnectFour::LastMoveWon() const
+{
+    return HasFour(current ^ mask);
+}
+
+bool ConnectFour::PlaySequence(const char moves[])
+{
+    for (const char* c = moves; *c; c++)
+    {
+        s32 column = *c - '1';
+        if (!CanPlay(column) || IsWinningMove(column))
+            return false;
+
+        Play(column);
+    }
+
+    return true;
+}
+
+CellElement ConnectFour::GetCell(s32 row, s32 column) const
+{
+    u64 bit = 1ULL << (row + column * (H + 1));
+    if (!(mask & bit))
+        return CellElement::EMPTY;
+
+    // current holds the player to move's discs
+    s32 owner = (current & bit) ? playerIndex : 1 - playerIndex;
+    return (CellElement) owner;
+}
+
+u64 ConnectFour::Key() const
+{
+    return current + mask;
+}
+
+u64 ConnectFour::NonLosingMoves() const
+{
+    u64 possible = (mask + BOTTOM_MASK) & BOARD_MASK;
+    u64 opponentWins = WinningCells(current ^ mask, mask);
+
+    // Has to block, and can't block two at once
+    u64 forced = possible & opponentWins;
+    if (forced)
+    {
+        if (forced & (forced - 1))
+            return 0;
+
+        possible = forced;
+    }
+
+    // Never play right under a cell the opponent wins on
+    return possible & ~(opponentWins >> 1);
+}
+
+s32 ConnectFour::MoveScore(u64 move) const
+{
+    return PopCount(WinningCells(current | move, mask));
+}
+
+void ConnectFourSolver::Init(s32 sizeLog2)
+{
+    entries.assign((size_t) 1 << sizeLog2, 0);
+    mask = ((u64) 1 << sizeLog2) - 1;
+    nodeLimit = 0;
+}
+
+void ConnectFourSolver::Clear()
+{
+    memset(entries.data(), 0, entries.size() * sizeof(u64));
+}
+
+static const s32 MIN_SCORE = -(ConnectFour::NUM_CELLS / 2) + 3;
+
+// Middle columns first, they're part of more lines
+static const s32 columnOrder[W] = { 3, 2, 4, 1, 5, 0, 6 };
+
+s32 ConnectFourSolver::Negamax(const ConnectFour& position, s32 alpha, s32 beta)
+{
+    nodes++;
+    if (nodeLimit && nodes >= nodeLimit)
+    {
+        stopped = true;
+        return 0;
+    }
+
+    // Callers check for a win right away first, so here it's about not losing
+    u64 possible = position.NonLosingMoves();
+    if (possible == 0)
+        return -(ConnectFour::NUM_CELLS - position.moveCount) / 2;
+
+    if (position.moveCount >= ConnectFour::NUM_CELLS - 2)
+        return 0;
+
+    // The opponent can't win on their next move any more
+    s32 lowest = -(ConnectFour::NUM_CELLS - 2 - position.moveCount) / 2;
+    if (alpha < lowest)
+    {
+        alpha = lowest;
+        if (alpha >= beta)
+            return alpha;
+    }
+
+    // Can't win right away either, that was checked before getting here
+    s32 highest = (ConnectFour::NUM_CELLS - 1 - position.moveCount) / 2;
+
+    u64 key = position.Key();
+    u64 entry = entries[(key * 0x9E3779B97F4A7C15ULL >> 20) & mask];
+    if (entry && (entry >> 8) == key)
+        highest = (s32) (entry & 0xFF) + MIN_SCORE - 1;
+
+    if (beta > highest)
+    {
+        beta = highest;
+        if (alpha >= beta)
+            return beta;
+    }
+
+    // Moves that open the most threats first, ties go to the middle
+    u64 moves[W];
+    s32 scores[W];
+    s32 numMoves = 0;
+
+    for (s32 column : columnOrder)
+    {
+        u64 move = possible & ColumnMask(column);
+        if (!move)
+            continue;
+
+        s32 score = position.MoveScore(move);
+        s32 i = numMoves++;
+        for (; i > 0 && scores[i - 1] < score; i--)
+        {
+            moves[i] = moves[i - 1];
+            scores[i] = scores[i - 1];
+        }
+
+        moves[i] = move;
+        scores[i] = score;
+    }
+
+    for (s32 i = 0; i < numMoves; i++)
+    {
+        ConnectFour next = position;
+        next.PlayMask(moves[i]);
+
+        s32 score = -Negamax(next, -beta, -alpha);
+        if (stopped)
+            return 0;
+
+        if (score >= beta)
+            return score;
+
+        if (score > alpha)
+            alpha = score;
+    }
+
+    // Failed low or exact, either way alpha is an upper bound
+    entries[(key * 0x9E3779B97F4A7C15ULL >> 20) & mask] = (key << 8) | ((u64) (alpha - MIN_SCORE + 1) & 0xFF);
+    return alpha;
+}
+
+s32 ConnectFourSolver::Solve(const ConnectFour& position, bool weak)
+{
+    nodes = 0;
+    stopped = false;
+
+    for (s32 column = 0; column < W; column++)
+    {
+        if (position.CanPlay(column) && position.IsWinningMove(column))
+            return (ConnectFour::NUM_CELLS + 1 - position.moveCount) / 2;
+    }
+
+    s32 lowest  = -(ConnectFour::NUM_CELLS - position.moveCount) / 2;
+    s32 highest = (ConnectFour::NUM_CELLS + 1 - position.moveCount) / 2;
+    if (weak)
+    {
+        lowest = -1;
+        highest = 1;
+    }
+
+    // Null window searches narrowing in on the score, tried near 0 first
+    // since those are the cheapest to prove
+    while (lowest < highest)
+    {
+        s32 middle = lowest + (highest - lowest) / 2;
+        if (middle <= 0 && lowest / 2 < middle)
+            middle = lowest / 2;
+        else if (middle >= 0 && highest / 2 > middle)
+            middle = highest / 2;
+
+        s32 score = Negamax(position, middle, middle + 1);
+        if (stopped)
+            return 0;
+
+        if (score <= middle)
+            highest = score;
+        else
+            lowest = score;
+    }
+
+    return lowest;
+}
+
+s32 ConnectFourSolver::BestMove(const ConnectFour& position, s32* score)
+{
+    s32 bestColumn = -1;
+    s32 bestScore = -ConnectFour::NUM_CELLS;
+    u64 totalNodes = 0;
+
+    for (s32 column : columnOrder)
+    {
+        if (position.CanPlay(column) && position.IsWinningMove(column))
+        {
+            if (score)
+                *score = (ConnectFour::NUM_CELLS + 1 - position.moveCount) / 2;
+            return column;
+        }
+    }
+
+    u64 limit = nodeLimit;
+    for (s32 column : columnOrder)
+    {
+        if (!position.CanPlay(column))
+            continue;
+
+        ConnectFour next = position;
+        next.Play(column);
+
+        // Each child gets what's left of the budget
+        if (limit)
+        {
+            if (totalNodes >= limit)
+            {
+                stopped = true;
+                break;
+            }
+
+            nodeLimit = limit - totalNodes;
+        }
+
+        s32 childScore = next.IsFull() ? 0 : -Solve(next);
+        totalNodes += nodes;
+        if (stopped)
+            break;
+
+        if (bestColumn < 0 || childScore > bestScore)
+        {
+            bestColumn = column;
+            bestScore = childScore;
+        }
+    }
+
+    nodeLimit = limit;
+    nodes = totalNodes;
+
+    if (stopped)
+    {
+        // Only trust the partial result if nothing unsearched could beat it
+        u64 safe = position.NonLosingMoves();
+        if (bestColumn < 0 || bestScore < 0)
+        {
+            s32 bestMoveScore = -1;
+            for (s32 column : columnOrder)
+            {
+                u64 move = safe & ColumnMask(column);
+                if (!move)
+                    continue;
+
+                s32 moveScore = position.MoveScore(move);
+                if (moveScore > bestMoveScore)
+                {
+                    bestColumn = column;
+                    bestMoveScore = moveScore;
+                }
+            }
+        }
+
+        // Every move loses, any legal one will do
+        for (s32 i = 0; bestColumn < 0 && i < W; i++)
+        {
+            if (position.CanPlay(columnOrder[i]))
+                bestColumn = columnOrder[i];
+        }
+    }
+
+    if (score)
+        *score = bestScore;
+
+    return bestColumn;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+
+// Connect Four on the usual 7 columns by 6 rows. Each column takes
+// HEIGHT + 1 bits of a u64, bottom row first, and the extra bit on top
+// stays empty so shifted lines never wrap into the next column. Adding the
+// bottom bit of a column to mask carries into the first empty cell, which
+// is what makes dropping a disc a couple of integer operations.
+struct ConnectFour
+{
+    static constexpr s32 WIDTH     = 7;
+    static constexpr s32 HEIGHT    = 6;
+    static constexpr s32 NUM_CELLS = WIDTH * HEIGHT;
+
+    u64 current;        // Discs of the player to move
+    u64 mask;           // Every disc
+    s32 moveCount;
+    s32 playerIndex;    // Player to move, same numbering as Board
+
+    void Clear(s32 firstPlayer = 0);
+
+    bool IsFull() const;
+    bool CanPlay(s32 column) const;
+
+    // Row the next disc in column lands on
+    s32 LandingRow(s32 column) const;
+
+    // Would dropping a disc in column win right away
+    bool IsWinningMove(s32 column) const;
+
+    void Play(s32 column);
+
+    // Did the player who just moved win
+    bool LastMoveWon() const;
+
+    // Plays columns written as digits from 1, like "4453". Stops and
+    // returns false at the first move that isn't legal or ends the game.
+    bool PlaySequence(const char moves[]);
+
+    // Row 0 is the bottom one
+    CellElement GetCell(s32 row, s32 column) const;
+
+    // Unique for every position, fits in 49 bits
+    u64 Key() const;
+
+    // Bitmask of the cells each move lands on, without the ones that let
+    // the opponent win right after. 0 if every move loses.
+    u64 NonLosingMoves() const;
+
+    // How many new ways to win a move on cell bitmask opens up
+    s32 MoveScore(u64 move) const;
+
+    void PlayMask(u64 move);
+};
+
+// Scores are from the point of view of the player to move: a win with
+// the n-th disc of that player from now scores (NUM_CELLS + 1 - moves) / 2
+// with moves counted at the winning move, so quicker wins score more.
+// Losses are the same negated and draws are 0.
+struct ConnectFourSolver
+{
+    std::vector<u64> entries;   // Key << 8 | upper bound offset, 0 for empty
+    u64 mask;
+
+    u64 nodes;
+    u64 nodeLimit;              // 0 means no limit
+    bool stopped;
+
+    void Init(s32 sizeLog2);    // 2^sizeLog2 entries
+    void Clear();
+
+    // Exact score, or with weak just its sign. Check stopped afterwards,
+    // the result means nothing if the node limit was hit.
+    s32 Solve(const ConnectFour& position, bool weak = false);
+
+    // Best column and its score, fills in score if it's not null. Without
+    // a node limit this is perfect play. If the limit is hit it falls back
+    // to the best move found so far, or the most promising safe one.
+    s32 BestMove(const ConnectFour& position, s32* score = nullptr);
+
+    s32 Negamax(const ConnectFour& position, s32 alpha, s32 beta);
+};
@@ -0,0 +1,306 @@
+#pragma once
+
+#include "universal/types.h"
+#include "universal/bits.h"
+#include "board.h"
+
+// Does the line of K starting at (row, col) going in direction d
+// fit on an N by N board and cover cell
+template <s32 N, s32 K>
+constexpr bool FixedLineThrough(s32 row, s32 col, s32 d, s32 cell)
+{
+    const s32 dr = d == 0 ? 0 : 1;
+    const s32 dc = d == 0 ? 1 : (d == 3 ? -1 : (d == 2 ? 1 : 0));
+
+    s32 endRow = row + dr * (K - 1);
+    s32 endCol = col + dc * (K - 1);
+    if (endRow >= N || endCol < 0 || endCol >= N)
+        return false;
+
+    for (s32 i = 0; i < K; i++)
+    {
+        if ((row + dr * i) * N + col + dc * i == cell)
+            return true;
+    }
+
+    return false;
+}
+
+template <s32 N, s32 K>
+constexpr u32 FixedLineMask(s32 row, s32 col, s32 d)
+{
+    const s32 dr = d == 0 ? 0 : 1;
+    const s32 dc = d == 0 ? 1 : (d == 3 ? -1 : (d == 2 ? 1 : 0));
+
+    u32 mask = 0;
+    for (s32 i = 0; i < K; i++)
+        mask |= 1u << ((row + dr * i) * N + col + dc * i);
+
+    return mask;
+}
+
+template <s32 N, s32 K>
+constexpr s32 FixedMaxLinesPerCell()
+{
+    s32 most = 0;
+    for (s32 cell = 0; cell < N * N; cell++)
+    {
+        s32 count = 0;
+        for (s32 row = 0; row < N; row++)
+            for (s32 col = 0; col < N; col++)
+                for (s32 d = 0; d < 4; d++)
+                    count += FixedLineThrough<N, K>(row, col, d, cell) ? 1 : 0;
+
+        most = count > most ? count : most;
+    }
+
+    return most;
+}
+
+// splitmix64, good enough for hash keys and usable in constexpr code
+constexpr u64 FixedZobristKey(u64 index)
+{
+    u64 z = 0x7474745A6F62ULL + (index + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Everything FixedBoard<N, K> looks up, built at compile time
+template <s32 N, s32 K>
+struct FixedBoardTables
+{
+    static constexpr s32 NUM_CELLS      = N * N;
+    static constexpr s32 LINES_PER_CELL = FixedMaxLinesPerCell<N, K>();
+
+    // Bit 31 is never set, lines padded with it never match
+    static constexpr u32 NO_LINE = 1u << 31;
+
+    u32 lines[NUM_CELLS][LINES_PER_CELL];   // Every win line through a cell
+    u8  symmetries[8][NUM_CELLS];           // Same numbering as Board::Transform
+    u64 zobrist[NUM_CELLS][2];
+    u64 playerToMove;
+
+    static constexpr FixedBoardTables Make()
+    {
+        FixedBoardTables t = {};
+
+        for (s32 cell = 0; cell < NUM_CELLS; cell++)
+        {
+            s32 count = 0;
+            for (s32 row = 0; row < N; row++)
+                for (s32 col = 0; col < N; col++)
+                    for (s32 d = 0; d < 4; d++)
+                    {
+                        if (FixedLineThrough<N, K>(row, col, d, cell))
+                            t.lines[cell][count++] = FixedLineMask<N, K>(row, col, d);
+                    }
+
+            for (; count < LINES_PER_CELL; count++)
+                t.lines[cell][count] = NO_LINE;
+
+            t.zobrist[cell][0] = FixedZobristKey(2 * cell);
+            t.zobrist[cell][1] = FixedZobristKey(2 * cell + 1);
+        }
+        t.playerToMove = FixedZobristKey(2 * NUM_CELLS);
+
+        for (s32 symmetry = 0; symmetry < 8; symmetry++)
+        {
+            for (s32 cell = 0; cell < NUM_CELLS; cell++)
+            {
+                s32 row = cell / N;
+                s32 col = cell % N;
+
+                if (symmetry & 4)
+                    col = N - 1 - col;
+
+                for (s32 i = 0; i < (symmetry & 3); i++)
+                {
+                    s32 oldRow = row;
+                    row = col;
+                    col = N - 1 - oldRow;
+                }
+
+                t.symmetries[symmetry][cell] = (u8) (row * N + col);
+            }
+        }
+
+        return t;
+    }
+};
+
+// Same interface as Board for the small variants, with the size and win
+// length fixed at compile time. Each player's elements are a bitmask and
+// every table is built by constexpr code, so the compiler sees constant
+// loop counts everywhere and unrolls the win check completely. Engine code
+// written as a template over the board type works with either one, perft
+// and the puzzle solver are.
+template <s32 N, s32 K>
+struct FixedBoard
+{
+    static_assert(N >= 1 && N * N <= 31, "Elements of a player have to fit in 31 bits");
+    static_assert(K >= 1 && K <= N, "Win length has to fit on the board");
+
+    static constexpr s32 SIZE      = N;
+    static constexpr s32 NUM_CELLS = N * N;
+    static constexpr s32 MAX_MOVES = N * N;
+
+    // Board's is a field, templates read board.numCells on either one
+    static constexpr s32 numCells  = N * N;
+
+    static constexpr s32 LINES_PER_CELL = FixedBoardTables<N, K>::LINES_PER_CELL;
+    static constexpr u32 ALL_CELLS = (1u << NUM_CELLS) - 1;
+
+    static constexpr FixedBoardTables<N, K> tables = FixedBoardTables<N, K>::Make();
+
+    u32 elements[2];
+    s32 moveCount;
+    s32 playerIndex;    // Player to move
+    u64 hash;           // Zobrist hash, not the same keys as Board's
+
+    void Clear(s32 firstPlayer = 0)
+    {
+        elements[0] = elements[1] = 0;
+        moveCount   = 0;
+        playerIndex = firstPlayer;
+        hash        = playerIndex ? tables.playerToMove : 0;
+    }
+
+    bool IsFull() const
+    {
+        return moveCount == NUM_CELLS;
+    }
+
+    bool WonThrough(s32 index) const
+    {
+        u32 mine = elements[(elements[1] >> index) & 1];
+        if (!((mine >> index) & 1))
+            return false;
+
+        bool won = false;
+        for (s32 i = 0; i < LINES_PER_CELL; i++)
+            won |= (mine & tables.lines[index][i]) == tables.lines[index][i];
+
+        return won;
+    }
+
+    s32 GenerateMoves(s32 moves[]) const
+    {
+        u32 empty = ~(elements[0] | elements[1]) & ALL_CELLS;
+
+        s32 count = 0;
+        for (; empty; empty &= empty - 1)
+            moves[count++] = LowestBit(empty);
+
+        return count;
+    }
+
+    void MakeMove(s32 index)
+    {
+        elements[playerIndex] |= 1u << index;
+        hash ^= tables.zobrist[index][playerIndex] ^ tables.playerToMove;
+        moveCount++;
+        playerIndex = 1 - playerIndex;
+    }
+
+    void UndoMove(s32 index)
+    {
+        playerIndex = 1 - playerIndex;
+        elements[playerIndex] &= ~(1u << index);
+        hash ^= tables.zobrist[index][playerIndex] ^ tables.playerToMove;
+        moveCount--;
+    }
+
+    // Replaces the whole position, layout has NUM_CELLS entries
+    void SetPosition(const CellElement layout[], s32 player)
+    {
+        Clear(player);
+
+        for (s32 index = 0; index < NUM_CELLS; index++)
+        {
+            if (layout[index] == CellElement::EMPTY)
+                continue;
+
+            s32 owner = layout[index] == CellElement::CROSS ? 0 : 1;
+            elements[owner] |= 1u << index;
+            hash ^= tables.zobrist[index][owner];
+            moveCount++;
+        }
+    }
+
+    CellElement GetCell(s32 index) const
+    {
+        if ((elements[0] >> index) & 1)
+            return CellElement::CROSS;
+        if ((elements[1] >> index) & 1)
+            return CellElement::CIRCLE;
+
+        return CellElement::EMPTY;
+    }
+
+    s32 Transform(s32 index, s32 symmetry) const
+    {
+        return tables.symmetries[symmetry][index];
+    }
+
+    // Same for every position that's a rotation or reflection of this one.
+    // The hash keys aren't Board's, so neither is the symmetry picked.
+    u64 CanonicalHash(s32* symmetry = nullptr) const
+    {
+        u64 best = hash;
+        s32 bestSymmetry = 0;
+
+        for (s32 candidate = 1; candidate < 8; candidate++)
+        {
+            u64 transformed = playerIndex ? tables.playerToMove : 0;
+            for (s32 player = 0; player < 2; player++)
+            {
+                for (u32 bits = elements[player]; bits; bits &= bits - 1)
+                    transformed ^= tables.zobrist[tables.symmetries[candidate][LowestBit(bits)]][player];
+            }
+
+            if (transformed < best)
+            {
+                best = transformed;
+                bestSymmetry = candidate;
+            }
+        }
+
+        if (symmetry)
+            *symmetry = bestSymmetry;
+
+        return best;
+    }
+};
+
+template <s32 N, s32 K>
+constexpr FixedBoardTables<N, K> FixedBoard<N, K>::tables;
+
+template <s32 N, s32 K>
+constexpr s32 FixedBoard<N, K>::numCells;
+
+
+// Calls run with a cleared FixedBoard if size and winLength are one of the
+// variants compiled in, otherwise returns false without calling it
+template <typename Func>
+bool WithFixedBoard(s32 size, s32 winLength, Func run)
+{
+    #define FIXED_VARIANT(n, k)                                     \
+        if (size == n && winLength == k)                            \
+        {                                                           \
+            FixedBoard<n, k> board;                                 \
+            board.Clear();                                          \
+            run(board);                                             \
+            return true;                                            \
+        }
+
+    FIXED_VARIANT(3, 3)
+    FIXED_VARIANT(4, 3)
+    FIXED_VARIANT(4, 4)
+    FIXED_VARIANT(5, 4)
+    FIXED_VARIANT(5, 5)
+
+    #undef FIXED_VARIANT
+
+    return false;
+}
\ No newline at end of file
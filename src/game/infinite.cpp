@@ -0,0 +1,168 @@
+#include "infinite.h"
+
+#include <unordered_map>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+
+static u64 ChunkKey(s32 chunkX, s32 chunkY)
+{
+    return ((u64) (u32) chunkX << 32) | (u32) chunkY;
+}
+
+// Shifts round towards negative infinity, so -1 is in chunk -1
+static s32 ChunkOf(s32 coord)
+{
+    return coord >> InfiniteBoard::CHUNK_SHIFT;
+}
+
+static s32 CellInChunk(s32 x, s32 y)
+{
+    const s32 last = InfiniteBoard::CHUNK_SIZE - 1;
+    return (y & last) * InfiniteBoard::CHUNK_SIZE + (x & last);
+}
+
+void InfiniteBoard::Init(s32 lineLength)
+{
+    winLength = lineLength;
+    Clear();
+}
+
+void InfiniteBoard::Clear(s32 firstPlayer)
+{
+    chunks.clear();
+    moves.clear();
+    playerIndex = firstPlayer;
+}
+
+const InfiniteBoard::Chunk* InfiniteBoard::FindChunk(s32 chunkX, s32 chunkY) const
+{
+    auto found = chunks.find(ChunkKey(chunkX, chunkY));
+    return found != chunks.end() ? &found->second : nullptr;
+}
+
+CellElement InfiniteBoard::GetCell(s32 x, s32 y) const
+{
+    const Chunk* chunk = FindChunk(ChunkOf(x), ChunkOf(y));
+    return chunk ? chunk->cells[CellInChunk(x, y)] : CellElement::EMPTY;
+}
+
+bool InfiniteBoard::MakeMove(s32 x, s32 y)
+{
+    u64 key = ChunkKey(ChunkOf(x), ChunkOf(y));
+
+    auto found = chunks.find(key);
+    if (found == chunks.end())
+    {
+        Chunk empty;
+        for (CellElement& cell : empty.cells)
+            cell = CellElement::EMPTY;
+        empty.count = 0;
+
+        found = chunks.emplace(key, empty).first;
+    }
+
+    CellElement& cell = found->second.cells[CellInChunk(x, y)];
+    if (cell != CellElement::EMPTY)
+        return false;
+
+    cell = (CellElement) playerIndex;
+    found->second.count++;
+
+    moves.push_back({ x, y, cell });
+    playerIndex = 1 - playerIndex;
+    return true;
+}
+
+void InfiniteBoard::UndoMove()
+{
+    InfiniteElement last = moves.back();
+    moves.pop_back();
+
+    auto found = chunks.find(ChunkKey(ChunkOf(last.x), ChunkOf(last.y)));
+    found->second.cells[CellInChunk(last.x, last.y)] = CellElement::EMPTY;
+    if (--found->second.count == 0)
+        chunks.erase(found);
+
+    playerIndex = 1 - playerIndex;
+}
+
+bool InfiniteBoard::WonThrough(s32 x, s32 y) const
+{
+    static const s32 directions[4][2] = {
+        { 1, 0 },   // Horizontal
+        { 0, 1 },   // Vertical
+        { 1, 1 },   // Diagonal
+        { 1, -1 },  // Anti-diagonal
+    };
+
+    const Chunk* start = FindChunk(ChunkOf(x), ChunkOf(y));
+    if (!start)
+        return false;
+
+    CellElement elem = start->cells[CellInChunk(x, y)];
+    if (elem == CellElement::EMPTY)
+        return false;
+
+    for (int d = 0; d < 4; d++)
+    {
+        s32 count = 1;
+
+        // Walk both ways from the placed element, keeping hold of the
+        // chunk so a lookup only happens at chunk borders
+        for (s32 sign = 1; sign >= -1; sign -= 2)
+        {
+            s32 dx = directions[d][0] * sign;
+            s32 dy = directions[d][1] * sign;
+
+            const Chunk* chunk = start;
+            s32 chunkX = ChunkOf(x);
+            s32 chunkY = ChunkOf(y);
+
+            for (s32 step = 1; step < winLength; step++)
+            {
+                s32 cx = x + dx * step;
+                s32 cy = y + dy * step;
+
+                if (ChunkOf(cx) != chunkX || ChunkOf(cy) != chunkY)
+                {
+                    chunkX = ChunkOf(cx);
+                    chunkY = ChunkOf(cy);
+                    chunk = FindChunk(chunkX, chunkY);
+                }
+
+                if (!chunk || chunk->cells[CellInChunk(cx, cy)] != elem)
+                    break;
+
+                count++;
+            }
+        }
+
+        if (count >= winLength)
+            return true;
+    }
+
+    return false;
+}
+
+void InfiniteBoard::GetElementsIn(s32 minX, s32 minY, s32 maxX, s32 maxY, std::vector<InfiniteElement>& out) const
+{
+    for (s32 chunkY = ChunkOf(minY); chunkY <= ChunkOf(maxY); chunkY++)
+        for (s32 chunkX = ChunkOf(minX); chunkX <= ChunkOf(maxX); chunkX++)
+        {
+            const Chunk* chunk = FindChunk(chunkX, chunkY);
+            if (!chunk)
+                continue;
+
+            for (s32 i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++)
+            {
+                if (chunk->cells[i] == CellElement::EMPTY)
+                    continue;
+
+                s32 x = (chunkX << CHUNK_SHIFT) + i % CHUNK_SIZE;
+                s32 y = (chunkY << CHUNK_SHIFT) + i / CHUNK_SIZE;
+                if (x >= minX && x <= maxX && y >= minY && y <= maxY)
+                    out.push_back({ x, y, chunk->cells[i] });
+            }
+        }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+
+struct InfiniteElement
+{
+    s32 x, y;
+    CellElement element;
+};
+
+// A board without edges. Cells live in square chunks that are only
+// created once something is placed in them, so memory grows with the
+// number of elements and not with how far apart they are. y goes up.
+struct InfiniteBoard
+{
+    static constexpr s32 CHUNK_SHIFT = 4;
+    static constexpr s32 CHUNK_SIZE  = 1 << CHUNK_SHIFT;
+
+    struct Chunk
+    {
+        CellElement cells[CHUNK_SIZE * CHUNK_SIZE];
+        s32 count;      // Elements in it, it's removed again at 0
+    };
+
+    std::unordered_map<u64, Chunk> chunks;
+    std::vector<InfiniteElement> moves;     // In order, for undo
+    s32 winLength;
+    s32 playerIndex;    // Player to move
+
+    void Init(s32 lineLength);
+    void Clear(s32 firstPlayer = 0);
+
+    CellElement GetCell(s32 x, s32 y) const;
+
+    // False if the cell is taken
+    bool MakeMove(s32 x, s32 y);
+    void UndoMove();
+
+    // Only checks the lines through (x, y), looking up a chunk only when
+    // a line crosses into it
+    bool WonThrough(s32 x, s32 y) const;
+
+    // Appends every element with minX <= x <= maxX and minY <= y <= maxY,
+    // looking only at the chunks that overlap the rectangle
+    void GetElementsIn(s32 minX, s32 minY, s32 maxX, s32 maxY, std::vector<InfiniteElement>& out) const;
+
+    const Chunk* FindChunk(s32 chunkX, s32 chunkY) const;
+};
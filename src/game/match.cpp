@@ -0,0 +1,85 @@
+#include "match.h"
+
+#include "universal/types.h"
+#include "board.h"
+#include "clock.h"
+
+void Match::Start(s32 size, s32 winLength, s32 firstPlayer)
+{
+    if (board.size != size || board.winLength != winLength || board.cells.empty())
+        board.Init(size, winLength);
+
+    board.Clear(firstPlayer);
+    status = MatchStatus::PLAYING;
+    lastMove = -1;
+    timed = false;
+}
+
+void Match::SetPosition(const CellElement layout[], s32 player)
+{
+    board.SetPosition(layout, player);
+    status = MatchStatus::PLAYING;
+    lastMove = -1;
+    timed = false;
+}
+
+void Match::StartClock(const TimeControl& control)
+{
+    timed = control.IsTimed();
+    if (timed)
+        clock.Start(control, board.playerIndex, GetMonotonicTime());
+}
+
+bool Match::IsLegal(s32 index) const
+{
+    return status == MatchStatus::PLAYING && index >= 0 && index < board.numCells &&
+           board.cells[index] == CellElement::EMPTY;
+}
+
+bool Match::Play(s32 index)
+{
+    if (!IsLegal(index))
+        return false;
+
+    // One reading of the clock for both the flag and the press
+    f64 now = timed ? GetMonotonicTime() : 0.0;
+    s32 player = board.playerIndex;
+
+    if (timed && !clock.Press(now))
+    {
+        status = player == 0 ? MatchStatus::CIRCLE_WON : MatchStatus::CROSS_WON;
+        return false;
+    }
+
+    board.MakeMove(index);
+    lastMove = index;
+
+    if (board.WonThrough(index))
+        status = player == 0 ? MatchStatus::CROSS_WON : MatchStatus::CIRCLE_WON;
+    else if (board.IsFull())
+        status = MatchStatus::DRAW;
+
+    if (timed && status != MatchStatus::PLAYING)
+        clock.Stop(now);
+
+    return true;
+}
+
+bool Match::CheckTime()
+{
+    if (!timed || status != MatchStatus::PLAYING)
+        return false;
+
+    f64 now = GetMonotonicTime();
+    if (!clock.HasRunOut(now))
+        return false;
+
+    clock.Press(now);
+    status = clock.flagged == 0 ? MatchStatus::CIRCLE_WON : MatchStatus::CROSS_WON;
+    return true;
+}
+
+bool Match::IsOver() const
+{
+    return status != MatchStatus::PLAYING;
+}
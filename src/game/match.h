@@ -0,0 +1,46 @@
+#pragma once
+
+#include "universal/types.h"
+#include "board.h"
+#include "clock.h"
+
+enum class MatchStatus : u8
+{
+    PLAYING,
+    CROSS_WON,
+    CIRCLE_WON,
+    DRAW,
+};
+
+// The rules of one game and where it's at, with nothing about windows,
+// menus or sockets. The window and the server both play through this, so
+// any number of them can run side by side.
+struct Match
+{
+    Board board;
+    MatchStatus status;
+    s32 lastMove;       // -1 before the first move
+    bool timed;
+    GameClock clock;    // Only when timed
+
+    // Untimed until StartClock is called
+    void Start(s32 size, s32 winLength, s32 firstPlayer = 0);
+
+    // Starts from a position part way through a game
+    void SetPosition(const CellElement layout[], s32 player);
+
+    bool IsLegal(s32 index) const;
+
+    // Both sides' time counts from now, the side to move's running
+    void StartClock(const TimeControl& control);
+
+    // Places an element for the player to move and updates status.
+    // Returns false and changes nothing if the move isn't legal. A timed
+    // move that comes in after the flag fell loses instead and isn't played.
+    bool Play(s32 index);
+
+    // Ends the match if the side to move has run out of time, true if it has
+    bool CheckTime();
+
+    bool IsOver() const;
+};
@@ -0,0 +1,128 @@
+#include "monitor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "board.h"
+#include "match.h"
+#include "clock.h"
+#include "search.h"
+#include "player.h"
+
+// Passes a finished game stays on the screen before starting over
+static const s32 HOLD_PASSES = 4;
+
+GameMonitor::~GameMonitor()
+{
+    Stop();
+}
+
+void GameMonitor::Start(s32 games, s32 size, s32 winLength, const ComputerPlayer& computer, f64 passSeconds)
+{
+    Stop();
+
+    numGames = games;
+    numCells = size * size;
+    cells.assign((size_t) games * numCells, CellElement::EMPTY);
+    results.assign(games, MatchStatus::PLAYING);
+    gamesFinished = 0;
+
+    stopSignal = false;
+    running = true;
+
+    thread = std::thread([this, size, winLength, computer, passSeconds]()
+    {
+        TranspositionTable table;
+        table.Init(16);
+
+        Searcher searcher = {};
+        searcher.table = &table;
+        searcher.stopSignal = &stopSignal;
+
+        Random random;
+        random.Seed((u64) (GetMonotonicTime() * 1e6));
+
+        std::vector<Match> matches(numGames);
+        std::vector<s32> held(numGames, 0);
+        for (Match& match : matches)
+            match.Start(size, winLength);
+
+        while (!stopSignal)
+        {
+            f64 passStart = GetMonotonicTime();
+            u64 finished = 0;
+
+            for (s32 i = 0; i < numGames && !stopSignal; i++)
+            {
+                Match& match = matches[i];
+
+                if (match.IsOver())
+                {
+                    if (++held[i] < HOLD_PASSES)
+                        continue;
+
+                    match.Start(size, winLength, (s32) random.Range(2));
+                    held[i] = 0;
+                }
+
+                // Random openings, the computer alone would play the same game everywhere
+                s32 move;
+                if (match.board.moveCount == 0)
+                {
+                    s32 moves[Board::MAX_MOVES];
+                    s32 numMoves = match.board.GenerateMoves(moves);
+                    move = moves[random.Range(numMoves)];
+                }
+                else
+                {
+                    table.Clear();
+                    move = computer.ChooseMove(match.board, searcher, random);
+                }
+
+                if (stopSignal)
+                    break;
+
+                match.Play(move);
+                if (match.IsOver())
+                    finished++;
+            }
+
+            {   // Publish the pass
+                std::lock_guard<std::mutex> guard(lock);
+                for (s32 i = 0; i < numGames; i++)
+                {
+                    const Board& board = matches[i].board;
+                    std::copy(board.cells.begin(), board.cells.end(), cells.begin() + (size_t) i * numCells);
+                    results[i] = matches[i].status;
+                }
+                gamesFinished += finished;
+            }
+
+            // Sleep in short steps so Stop doesn't wait for a whole pass
+            while (!stopSignal && GetMonotonicTime() - passStart < passSeconds)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+}
+
+void GameMonitor::Stop()
+{
+    if (!running)
+        return;
+
+    stopSignal = true;
+    thread.join();
+    running = false;
+}
+
+u64 GameMonitor::Copy(std::vector<CellElement>& outCells, std::vector<MatchStatus>& outResults)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    outCells = cells;
+    outResults = results;
+    return gamesFinished;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+#include "match.h"
+#include "player.h"
+
+// Plays a grid of computer games on a background thread for the watch
+// view, every game one move further each pass. Finished games stay up for
+// a moment and then start over from a new random opening.
+struct GameMonitor
+{
+    std::thread thread;
+    std::atomic<bool> stopSignal;
+    bool running { false };
+
+    s32 numGames;
+    s32 numCells;
+
+    // What the view draws, the worker replaces it after every pass
+    std::mutex lock;
+    std::vector<CellElement> cells;     // numGames boards one after the other
+    std::vector<MatchStatus> results;
+    u64 gamesFinished;
+
+    ~GameMonitor();
+
+    // A pass takes at least passSeconds so the moves can be followed
+    void Start(s32 games, s32 size, s32 winLength, const ComputerPlayer& computer, f64 passSeconds);
+    void Stop();
+
+    // Copies the latest pass out, returns how many games have finished
+    u64 Copy(std::vector<CellElement>& outCells, std::vector<MatchStatus>& outResults);
+};
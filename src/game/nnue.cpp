@@ -0,0 +1,329 @@
+#include "nnue.h"
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "universal/types.h"
+#include "platform/fileio.h"
+#include "board.h"
+#include "search.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define NNUE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define NNUE_SSE2
+#endif
+
+static const u32 NETWORK_VERSION = 1;
+
+// Scale from network output to evaluation units
+static const s32 OUTPUT_SHIFT = 4;
+
+struct Reader
+{
+    const Byte* data;
+    size_t size;
+    size_t offset;
+
+    bool Has(size_t bytes) const { return offset + bytes <= size; }
+
+    s64 Read(int bytes, bool isSigned)
+    {
+        u64 value = 0;
+        for (int i = 0; i < bytes; i++)
+            value |= (u64) data[offset + i] << (8 * i);
+        offset += bytes;
+
+        if (isSigned && bytes < 8 && (value >> (8 * bytes - 1)) & 1)
+            value |= ~0ULL << (8 * bytes);
+
+        return (s64) value;
+    }
+};
+
+static s32 FeatureIndex(s32 index, s32 player, s32 perspective)
+{
+    return index * 2 + (player == perspective ? 0 : 1);
+}
+
+// Plain loops, always built so the vector versions can be checked against them
+struct ScalarKernels
+{
+    static void AddColumn(s16* values, const s16* column)
+    {
+        for (s32 i = 0; i < NNUE_HIDDEN; i++)
+            values[i] += column[i];
+    }
+
+    static void SubColumn(s16* values, const s16* column)
+    {
+        for (s32 i = 0; i < NNUE_HIDDEN; i++)
+            values[i] -= column[i];
+    }
+
+    // Sum of a[i] * b[i] over the hidden layer
+    static s32 Dot(const s16* a, const s16* b)
+    {
+        s32 sum = 0;
+        for (s32 i = 0; i < NNUE_HIDDEN; i++)
+            sum += a[i] * b[i];
+        return sum;
+    }
+
+    // Clamps the accumulator to [0, 127] for the next layer
+    static void ClippedReLU(const s16* in, s16* out)
+    {
+        for (s32 i = 0; i < NNUE_HIDDEN; i++)
+            out[i] = in[i] < 0 ? 0 : (in[i] > 127 ? 127 : in[i]);
+    }
+};
+
+// What the build's instruction set allows, the scalar ones without SSE2
+struct VectorKernels
+{
+    static void AddColumn(s16* values, const s16* column)
+    {
+#if defined(NNUE_AVX2)
+        for (s32 i = 0; i < NNUE_HIDDEN; i += 16)
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+            __m256i w = _mm256_loadu_si256((const __m256i*) (column + i));
+            _mm256_storeu_si256((__m256i*) (values + i), _mm256_add_epi16(v, w));
+        }
+#elif defined(NNUE_SSE2)
+        for (s32 i = 0; i < NNUE_HIDDEN; i += 8)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*) (values + i));
+            __m128i w = _mm_loadu_si128((const __m128i*) (column + i));
+            _mm_storeu_si128((__m128i*) (values + i), _mm_add_epi16(v, w));
+        }
+#else
+        ScalarKernels::AddColumn(values, column);
+#endif
+    }
+
+    static void SubColumn(s16* values, const s16* column)
+    {
+#if defined(NNUE_AVX2)
+        for (s32 i = 0; i < NNUE_HIDDEN; i += 16)
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+            __m256i w = _mm256_loadu_si256((const __m256i*) (column + i));
+            _mm256_storeu_si256((__m256i*) (values + i), _mm256_sub_epi16(v, w));
+        }
+#elif defined(NNUE_SSE2)
+        for (s32 i = 0; i < NNUE_HIDDEN; i += 8)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*) (values + i));
+            __m128i w = _mm_loadu_si128((const __m128i*) (column + i));
+            _mm_storeu_si128((__m128i*) (values + i), _mm_sub_epi16(v, w));
+        }
+#else
+        ScalarKernels::SubColumn(values, column);
+#endif
+    }
+
+    static s32 Dot(const s16* a, const s16* b)
+    {
+#if defined(NNUE_AVX2)
+        __m256i sum = _mm256_setzero_si256();
+        for (s32 i = 0; i < NNUE_HIDDEN; i += 16)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i*) (a + i));
+            __m256i y = _mm256_loadu_si256((const __m256i*) (b + i));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(x, y));
+        }
+
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(half);
+#elif defined(NNUE_SSE2)
+        __m128i sum = _mm_setzero_si128();
+        for (s32 i = 0; i < NNUE_HIDDEN; i += 8)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i*) (a + i));
+            __m128i y = _mm_loadu_si128((const __m128i*) (b + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(x, y));
+        }
+
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(sum);
+#else
+        return ScalarKernels::Dot(a, b);
+#endif
+    }
+
+    static void ClippedReLU(const s16* in, s16* out)
+    {
+#if defined(NNUE_AVX2)
+        __m256i zero = _mm256_setzero_si256();
+        __m256i top  = _mm256_set1_epi16(127);
+        for (s32 i = 0; i < NNUE_HIDDEN; i += 16)
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i*) (in + i));
+            v = _mm256_min_epi16(_mm256_max_epi16(v, zero), top);
+            _mm256_storeu_si256((__m256i*) (out + i), v);
+        }
+#elif defined(NNUE_SSE2)
+        __m128i zero = _mm_setzero_si128();
+        __m128i top  = _mm_set1_epi16(127);
+        for (s32 i = 0; i < NNUE_HIDDEN; i += 8)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*) (in + i));
+            v = _mm_min_epi16(_mm_max_epi16(v, zero), top);
+            _mm_storeu_si128((__m128i*) (out + i), v);
+        }
+#else
+        ScalarKernels::ClippedReLU(in, out);
+#endif
+    }
+};
+
+template <typename Kernels>
+static void RefreshWith(const Network& network, Accumulator& accumulator, const Board& board)
+{
+    for (s32 perspective = 0; perspective < 2; perspective++)
+        memcpy(accumulator.values[perspective], network.featureBias, sizeof(network.featureBias));
+
+    for (s32 i = 0; i < board.numCells; i++)
+    {
+        if (board.cells[i] == CellElement::EMPTY)
+            continue;
+
+        for (s32 perspective = 0; perspective < 2; perspective++)
+        {
+            size_t feature = (size_t) FeatureIndex(i, (s32) board.cells[i], perspective);
+            Kernels::AddColumn(accumulator.values[perspective], &network.featureWeights[feature * NNUE_HIDDEN]);
+        }
+    }
+}
+
+template <typename Kernels>
+static s32 EvaluateWith(const Network& network, const Accumulator& accumulator, s32 player)
+{
+    s16 hidden[NNUE_HIDDEN];
+    Kernels::ClippedReLU(accumulator.values[player], hidden);
+
+    s32 output = network.l2Bias;
+    for (s32 o = 0; o < NNUE_L1; o++)
+    {
+        s32 value = (network.l1Bias[o] + Kernels::Dot(hidden, network.l1Weights[o])) >> 6;
+        value = value < 0 ? 0 : (value > 127 ? 127 : value);
+        output += value * network.l2Weights[o];
+    }
+
+    s32 score = output >> OUTPUT_SHIFT;
+    if (score > WIN_SCORE / 2)
+        return WIN_SCORE / 2;
+    if (score < -WIN_SCORE / 2)
+        return -WIN_SCORE / 2;
+
+    return score;
+}
+
+const char* GetNetworkKernels()
+{
+#if defined(NNUE_AVX2)
+    return "avx2";
+#elif defined(NNUE_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+bool Network::Load(const char filepath[])
+{
+    loaded = false;
+
+    std::vector<Byte> contents = LoadBinaryFile(filepath);
+    Reader reader = { contents.data(), contents.size(), 0 };
+
+    if (!reader.Has(14) || memcmp(contents.data(), "TTTN", 4) != 0)
+        return false;
+    reader.offset = 4;
+
+    u32 version = (u32) reader.Read(4, false);
+    s32 size    = (s32) reader.Read(2, false);
+    s32 hidden  = (s32) reader.Read(2, false);
+    s32 l1      = (s32) reader.Read(2, false);
+
+    if (version != NETWORK_VERSION || hidden != NNUE_HIDDEN || l1 != NNUE_L1 ||
+        size < 1 || size > Board::MAX_SIZE)
+        return false;
+
+    size_t numFeatures = (size_t) size * size * 2;
+    size_t expected = numFeatures * NNUE_HIDDEN * 2 + NNUE_HIDDEN * 2 +
+                      NNUE_L1 * NNUE_HIDDEN + NNUE_L1 * 4 + NNUE_L1 + 4;
+    if (!reader.Has(expected))
+        return false;
+
+    boardSize = size;
+    featureWeights.resize(numFeatures * NNUE_HIDDEN);
+
+    for (s16& weight : featureWeights)
+        weight = (s16) reader.Read(2, true);
+    for (s32 i = 0; i < NNUE_HIDDEN; i++)
+        featureBias[i] = (s16) reader.Read(2, true);
+
+    // Stored as int8, widened so the dot product can use madd
+    for (s32 o = 0; o < NNUE_L1; o++)
+        for (s32 i = 0; i < NNUE_HIDDEN; i++)
+            l1Weights[o][i] = (s16) reader.Read(1, true);
+    for (s32 o = 0; o < NNUE_L1; o++)
+        l1Bias[o] = (s32) reader.Read(4, true);
+
+    for (s32 o = 0; o < NNUE_L1; o++)
+        l2Weights[o] = (s32) reader.Read(1, true);
+    l2Bias = (s32) reader.Read(4, true);
+
+    loaded = true;
+    return true;
+}
+
+bool Network::Supports(const Board& board) const
+{
+    return loaded && board.size == boardSize;
+}
+
+void Network::Refresh(Accumulator& accumulator, const Board& board) const
+{
+    RefreshWith<VectorKernels>(*this, accumulator, board);
+}
+
+void Network::RefreshScalar(Accumulator& accumulator, const Board& board) const
+{
+    RefreshWith<ScalarKernels>(*this, accumulator, board);
+}
+
+void Network::AddElement(Accumulator& accumulator, s32 index, s32 player) const
+{
+    for (s32 perspective = 0; perspective < 2; perspective++)
+    {
+        const s16* column = &featureWeights[(size_t) FeatureIndex(index, player, perspective) * NNUE_HIDDEN];
+        VectorKernels::AddColumn(accumulator.values[perspective], column);
+    }
+}
+
+void Network::RemoveElement(Accumulator& accumulator, s32 index, s32 player) const
+{
+    for (s32 perspective = 0; perspective < 2; perspective++)
+    {
+        const s16* column = &featureWeights[(size_t) FeatureIndex(index, player, perspective) * NNUE_HIDDEN];
+        VectorKernels::SubColumn(accumulator.values[perspective], column);
+    }
+}
+
+s32 Network::Evaluate(const Accumulator& accumulator, s32 player) const
+{
+    return EvaluateWith<VectorKernels>(*this, accumulator, player);
+}
+
+s32 Network::EvaluateScalar(const Accumulator& accumulator, s32 player) const
+{
+    return EvaluateWith<ScalarKernels>(*this, accumulator, player);
+}
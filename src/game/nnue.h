@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+
+// Small quantized network for evaluating big boards (made for 15x15).
+//
+// Inputs are one feature per cell per element, seen from each player's side
+// ("mine" or "theirs"), so a position's first layer output can be kept up to
+// date by adding or removing a single weight column per move. That first
+// layer is the Accumulator. The rest is:
+//
+//   clamp(accumulator, 0, 127) -> HIDDEN x L1 (int16) -> clamp(>> 6, 0, 127) -> L1 x 1
+//
+// Weight file, all little endian:
+//
+//   "TTTN", u32 version, u16 boardSize, u16 hidden, u16 l1
+//   s16 featureWeights[boardSize * boardSize * 2][hidden]
+//   s16 featureBias[hidden]
+//   s8  l1Weights[l1][hidden]
+//   s32 l1Bias[l1]
+//   s8  l2Weights[l1]
+//   s32 l2Bias
+
+const s32 NNUE_HIDDEN = 128;
+const s32 NNUE_L1     = 32;
+
+struct Accumulator
+{
+    s16 values[2][NNUE_HIDDEN];     // One per player's point of view
+};
+
+struct Network
+{
+    s32 boardSize;
+    std::vector<s16> featureWeights;
+    s16 featureBias[NNUE_HIDDEN];
+    s16 l1Weights[NNUE_L1][NNUE_HIDDEN];
+    s32 l1Bias[NNUE_L1];
+    s32 l2Weights[NNUE_L1];
+    s32 l2Bias;
+    bool loaded;
+
+    bool Load(const char filepath[]);
+
+    // Works for the board it was trained on only
+    bool Supports(const Board& board) const;
+
+    // Build the accumulator from scratch
+    void Refresh(Accumulator& accumulator, const Board& board) const;
+
+    // Element of player placed at or removed from index
+    void AddElement(Accumulator& accumulator, s32 index, s32 player) const;
+    void RemoveElement(Accumulator& accumulator, s32 index, s32 player) const;
+
+    // Score for the player to move, in the same units as Evaluate
+    s32 Evaluate(const Accumulator& accumulator, s32 player) const;
+
+    // The same through plain loops instead of SSE2 or AVX2, so the vector
+    // code can be checked against them with "tttcli nnue"
+    void RefreshScalar(Accumulator& accumulator, const Board& board) const;
+    s32 EvaluateScalar(const Accumulator& accumulator, s32 player) const;
+};
+
+// "avx2", "sse2" or "scalar", whichever this build uses
+const char* GetNetworkKernels();
@@ -0,0 +1,158 @@
+#include "patterns.h"
+
+#include <mutex>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+#include "search.h"
+
+// Every window that only one player has elements in can still be won by
+// them. The more they have in it the better.
+static const s32 weights[] = { 0, 1, 8, 64, 512, 4096, 32768 };
+static const s32 maxWeight = sizeof(weights) / sizeof(weights[0]) - 1;
+
+static s32 WindowScore(u64 window, s32 length)
+{
+    s32 counts[4] = { 0, 0, 0, 0 };
+    for (s32 i = 0; i < length; i++)
+        counts[(window >> (2 * i)) & 3]++;
+
+    // 3 isn't a cell, those table entries are never looked up
+    if ((counts[1] && counts[2]) || counts[3])
+        return 0;
+    if (counts[1])
+        return weights[counts[1] < maxWeight ? counts[1] : maxWeight];
+    if (counts[2])
+        return -weights[counts[2] < maxWeight ? counts[2] : maxWeight];
+
+    return 0;
+}
+
+// Built the first time a window length is used, then shared by all threads
+static const s32* GetPatternTable(s32 length)
+{
+    static std::vector<s32> tables[PatternEvaluator::MAX_TABLE_SIZE + 1];
+    static std::once_flag built[PatternEvaluator::MAX_TABLE_SIZE + 1];
+
+    if (length > PatternEvaluator::MAX_TABLE_SIZE)
+        return nullptr;
+
+    std::call_once(built[length], [length]()
+    {
+        std::vector<s32>& table = tables[length];
+        table.resize((size_t) 1 << (2 * length));
+
+        for (u64 window = 0; window < table.size(); window++)
+            table[window] = WindowScore(window, length);
+    });
+
+    return tables[length].data();
+}
+
+void PatternEvaluator::Init(const Board& board)
+{
+    static const s32 directions[4][2] = {
+        { 0, 1 },
+        { 1, 0 },
+        { 1, 1 },
+        { 1, -1 },
+    };
+
+    size      = board.size;
+    winLength = board.winLength;
+    numLines  = 0;
+    total     = 0;
+    table     = GetPatternTable(winLength);
+
+    // Each line starts at a cell that has no neighbour before it in that direction
+    for (int d = 0; d < 4; d++)
+    {
+        s32 dr = directions[d][0];
+        s32 dc = directions[d][1];
+
+        for (s32 row = 0; row < size; row++)
+            for (s32 col = 0; col < size; col++)
+            {
+                s32 prevRow = row - dr;
+                s32 prevCol = col - dc;
+                if (prevRow >= 0 && prevRow < size && prevCol >= 0 && prevCol < size)
+                    continue;
+
+                s32 line = numLines++;
+                s32 length = 0;
+
+                for (s32 r = row, c = col; r >= 0 && r < size && c >= 0 && c < size; r += dr, c += dc)
+                {
+                    cellLines[r * size + c][d]   = (u16) line;
+                    cellOffsets[r * size + c][d] = (u8) length;
+                    length++;
+                }
+
+                lines[line] = 0;
+                lineLengths[line] = length;
+                lineScores[line] = 0;
+            }
+    }
+
+    for (s32 i = 0; i < board.numCells; i++)
+    {
+        if (board.cells[i] != CellElement::EMPTY)
+            AddElement(i, (s32) board.cells[i]);
+    }
+}
+
+void PatternEvaluator::AddElement(s32 index, s32 player)
+{
+    UpdateCell(index, (u64) player + 1);
+}
+
+void PatternEvaluator::RemoveElement(s32 index)
+{
+    UpdateCell(index, 0);
+}
+
+s32 PatternEvaluator::Score(s32 player) const
+{
+    s32 score = player == 0 ? total : -total;
+
+    // Never let a heuristic score look like a win
+    if (score > WIN_SCORE / 2)
+        return WIN_SCORE / 2;
+    if (score < -WIN_SCORE / 2)
+        return -WIN_SCORE / 2;
+
+    return score;
+}
+
+s32 PatternEvaluator::ScoreLine(s32 line) const
+{
+    if (lineLengths[line] < winLength)
+        return 0;
+
+    u64 code = lines[line];
+    u64 mask = ((u64) 1 << (2 * winLength)) - 1;
+    s32 score = 0;
+
+    for (s32 start = 0; start + winLength <= lineLengths[line]; start++)
+    {
+        u64 window = (code >> (2 * start)) & mask;
+        score += table ? table[window] : WindowScore(window, winLength);
+    }
+
+    return score;
+}
+
+void PatternEvaluator::UpdateCell(s32 index, u64 code)
+{
+    for (int d = 0; d < 4; d++)
+    {
+        s32 line  = cellLines[index][d];
+        s32 shift = 2 * cellOffsets[index][d];
+
+        lines[line] = (lines[line] & ~((u64) 3 << shift)) | (code << shift);
+
+        s32 score = ScoreLine(line);
+        total += score - lineScores[line];
+        lineScores[line] = score;
+    }
+}
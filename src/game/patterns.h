@@ -0,0 +1,37 @@
+#pragma once
+
+#include "universal/types.h"
+#include "board.h"
+
+// Hand-made evaluation for big boards. Every line through the board is kept
+// packed 2 bits per cell, and each winLength window of it is scored by
+// looking its pattern up in a table. Placing or removing an element only
+// rescores the four lines going through that cell.
+struct PatternEvaluator
+{
+    static constexpr s32 MAX_LINES      = 6 * Board::MAX_SIZE - 2;
+    static constexpr s32 MAX_TABLE_SIZE = 8;    // Longest window with a table
+
+    s32 size;
+    s32 winLength;
+    s32 numLines;
+    s32 total;                          // From cross' point of view
+    const s32* table;                   // Null if winLength is too long
+
+    u64 lines[MAX_LINES];               // 2 bits per cell, 0 is empty
+    s32 lineLengths[MAX_LINES];
+    s32 lineScores[MAX_LINES];
+    u16 cellLines[Board::MAX_MOVES][4]; // Line through a cell per direction
+    u8  cellOffsets[Board::MAX_MOVES][4];
+
+    void Init(const Board& board);
+
+    void AddElement(s32 index, s32 player);
+    void RemoveElement(s32 index);
+
+    // For the player to move
+    s32 Score(s32 player) const;
+
+    s32 ScoreLine(s32 line) const;
+    void UpdateCell(s32 index, u64 code);
+};
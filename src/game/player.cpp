@@ -0,0 +1,144 @@
+#include "player.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "board.h"
+#include "match.h"
+#include "clock.h"
+#include "search.h"
+
+// Fixed node budgets rather than time so a level plays the same on any
+// machine. Check changes with "tttcli calibrate".
+static const struct
+{
+    const char* name;
+    const char* spec;
+} levels[NUM_LEVELS] = {
+    { "Easy",   "search:nodes=30:noise=300:blunder=40" },
+    { "Medium", "search:nodes=300:noise=100:blunder=15" },
+    { "Hard",   "search:nodes=3000:noise=20:blunder=4" },
+    { "Expert", "search:nodes=100000" },
+};
+
+static const u64 BLUNDER_SEED = 0xB10DE2ULL;
+static const u64 NOISE_SEED   = 0x4E01CEULL;
+
+const char* GetLevelName(s32 level)
+{
+    return levels[level].name;
+}
+
+const char* GetLevelSpec(s32 level)
+{
+    return levels[level].spec;
+}
+
+// A whole option value, up to the next ':' or the end of the spec
+static bool ParseValue(const char text[], s64& value)
+{
+    char* end;
+    value = strtoll(text, &end, 10);
+    return end != text && (*end == ':' || *end == '\0');
+}
+
+bool ComputerPlayer::Parse(const char spec[])
+{
+    name    = spec;
+    limits  = {};
+    noise   = 0;
+    blunderChance = 0;
+    network = nullptr;
+
+    if (strncmp(spec, "level:", 6) == 0)
+    {
+        char* end;
+        s64 level = strtoll(spec + 6, &end, 10);
+        if (end == spec + 6 || *end != '\0' || level < 0 || level >= NUM_LEVELS || !Parse(levels[level].spec))
+            return false;
+
+        name = spec;
+        return true;
+    }
+
+    if (strcmp(spec, "random") == 0)
+    {
+        type = PlayerType::RANDOM;
+        return true;
+    }
+
+    if (strncmp(spec, "search", 6) != 0 || (spec[6] != '\0' && spec[6] != ':'))
+        return false;
+
+    type = PlayerType::SEARCH;
+    limits.nodes = 10000;
+
+    // Options are ":key=value" one after the other
+    for (const char* option = strchr(spec, ':'); option; option = strchr(option + 1, ':'))
+    {
+        s64 value;
+        if (strncmp(option, ":nodes=", 7) == 0 && ParseValue(option + 7, value) && value >= 0)
+            limits.nodes = (u64) value;
+        else if (strncmp(option, ":depth=", 7) == 0 && ParseValue(option + 7, value) && value >= 0)
+            limits.depth = (s32) value;
+        else if (strncmp(option, ":noise=", 7) == 0 && ParseValue(option + 7, value) && value >= 0)
+            noise = (s32) value;
+        else if (strncmp(option, ":blunder=", 9) == 0 && ParseValue(option + 9, value) && value >= 0)
+            blunderChance = (s32) value;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+s32 ComputerPlayer::ChooseMove(Board& board, Searcher& searcher, Random& random) const
+{
+    return ChooseMove(board, searcher, random, limits);
+}
+
+s32 ComputerPlayer::ChooseMove(Match& match, Searcher& searcher, Random& random) const
+{
+    if (!match.timed)
+        return ChooseMove(match.board, searcher, random, limits);
+
+    const Board& board = match.board;
+    f64 budget = match.clock.GetBudget(GetMonotonicTime(), (board.numCells - board.moveCount + 1) / 2);
+
+    SearchLimits timed = limits;
+    if (timed.time <= 0.0 || timed.time > budget)
+        timed.time = budget;
+
+    return ChooseMove(match.board, searcher, random, timed);
+}
+
+s32 ComputerPlayer::ChooseMove(Board& board, Searcher& searcher, Random& random, const SearchLimits& searchLimits) const
+{
+    if (type == PlayerType::SEARCH)
+    {
+        if (blunderChance > 0)
+        {
+            Random blunder;
+            blunder.Seed(board.hash ^ BLUNDER_SEED);
+
+            if (blunder.Range(100) < blunderChance)
+            {
+                s32 moves[Board::MAX_MOVES];
+                s32 numMoves = GenerateCandidates(board, moves);
+                if (numMoves)
+                    return moves[blunder.Range(numMoves)];
+            }
+        }
+
+        searcher.network = network;
+        searcher.rootNoise = noise;
+        searcher.noiseSeed = NOISE_SEED;
+        return searcher.Search(board, searchLimits).move;
+    }
+
+    s32 moves[Board::MAX_MOVES];
+    s32 numMoves = board.GenerateMoves(moves);
+    return numMoves ? moves[random.Range(numMoves)] : -1;
+}
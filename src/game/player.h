@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "board.h"
+#include "match.h"
+#include "search.h"
+#include "nnue.h"
+
+enum class PlayerType
+{
+    RANDOM,
+    SEARCH,
+};
+
+// A computer player configuration, written as "random",
+// "search[:nodes=N][:depth=N][:noise=N][:blunder=N]" or "level:N".
+//
+// Weaker players make mistakes on purpose: noise is added to the scores of
+// the moves at the root and blunder is the percent chance of a random move
+// instead. Both are decided from the position alone, so with node limits
+// a player always makes the same move in the same position.
+struct ComputerPlayer
+{
+    std::string name;
+    PlayerType type;
+    SearchLimits limits;
+    s32 noise;
+    s32 blunderChance;          // Percent
+    const Network* network;     // Can be null
+
+    bool Parse(const char spec[]);
+
+    // searcher and random belong to the caller so each thread can have its own
+    s32 ChooseMove(Board& board, Searcher& searcher, Random& random) const;
+
+    // The same, but on a timed match never thinking longer than the clock allows
+    s32 ChooseMove(Match& match, Searcher& searcher, Random& random) const;
+    s32 ChooseMove(Board& board, Searcher& searcher, Random& random, const SearchLimits& searchLimits) const;
+};
+
+// Difficulty levels for the menu, from weakest to strongest
+const s32 NUM_LEVELS = 4;
+
+const char* GetLevelName(s32 level);
+const char* GetLevelSpec(s32 level);
@@ -0,0 +1,108 @@
+#include "ponder.h"
+
+#include <thread>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "board.h"
+#include "search.h"
+#include "player.h"
+
+Ponderer::~Ponderer()
+{
+    Stop();
+}
+
+void Ponderer::Start(const Board& current, const ComputerPlayer& computer)
+{
+    Stop();
+
+    if (computer.type != PlayerType::SEARCH || current.IsFull())
+        return;
+
+    if (table.IsEmpty())
+        table.Init(16);
+
+    board = current;
+    predictedHash = 0;
+    stopSignal = false;
+    finished = false;
+    running = true;
+
+    thread = std::thread([this, computer]()
+    {
+        searcher = {};
+        searcher.table = &table;
+        searcher.network = computer.network;
+        searcher.stopSignal = &stopSignal;
+
+        // The search moves elements around, so work on a copy the
+        // main thread never looks at
+        Board position = board;
+
+        // Guess the other player's move with a smaller search
+        SearchLimits guessLimits = computer.limits;
+        guessLimits.nodes = computer.limits.nodes / 4;
+
+        table.Clear();
+        SearchResult guess = searcher.Search(position, guessLimits);
+        if (stopSignal || guess.move < 0)
+            return;
+
+        position.MakeMove(guess.move);
+        if (position.WonThrough(guess.move) || position.IsFull())
+            return;
+
+        predictedHash = position.hash;
+
+        // Same as the computer's real move
+        Random random;
+        random.Seed(position.hash);
+
+        table.Clear();
+        move = computer.ChooseMove(position, searcher, random);
+
+        // Running out of nodes is the normal end, only a stop throws it away
+        if (!stopSignal)
+            finished = true;
+    });
+}
+
+void Ponderer::Stop()
+{
+    if (!running)
+        return;
+
+    stopSignal = true;
+    thread.join();
+    running = false;
+}
+
+PonderState Ponderer::Check(const Board& current)
+{
+    if (!running)
+        return PonderState::NONE;
+
+    bool samePosition = predictedHash != 0 && predictedHash == current.hash;
+
+    if (finished)
+    {
+        thread.join();
+        running = false;
+
+        if (samePosition)
+        {
+            hits++;
+            return PonderState::HIT;
+        }
+
+        misses++;
+        return PonderState::MISS;
+    }
+
+    if (samePosition)
+        return PonderState::PENDING;
+
+    Stop();
+    misses++;
+    return PonderState::MISS;
+}
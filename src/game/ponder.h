@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include "universal/types.h"
+#include "board.h"
+#include "search.h"
+#include "player.h"
+
+enum class PonderState
+{
+    NONE,       // Wasn't pondering
+    PENDING,    // Pondering this position, not done yet
+    HIT,        // Done with this position, result is ready
+    MISS,       // Pondered something else, thrown away
+};
+
+// Thinks about the computer's reply on a background thread while the other
+// player decides. It guesses their move and has the computer choose its
+// reply to that with a cleared table, the same way the real move is chosen,
+// so a hit gives exactly the move the computer would have played.
+struct Ponderer
+{
+    std::thread thread;
+    std::atomic<bool> stopSignal;
+    std::atomic<bool> finished;
+    bool running { false };
+
+    Board board;                        // Position it started from
+    std::atomic<u64> predictedHash;     // Position after the predicted move, 0 until known
+    s32 move;
+    Searcher searcher;
+    TranspositionTable table;
+
+    u64 hits { 0 };
+    u64 misses { 0 };
+
+    ~Ponderer();
+
+    // board is the position with the other player to move
+    void Start(const Board& current, const ComputerPlayer& computer);
+    void Stop();
+
+    // Call when it's the computer's turn on board
+    PonderState Check(const Board& current);
+};
@@ -0,0 +1,105 @@
+#include "puzzle.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "universal/types.h"
+#include "platform/fileio.h"
+#include "board.h"
+
+static const u32 PUZZLE_VERSION = 1;
+
+static void PutU16(u8* out, u16 value)
+{
+    out[0] = (u8) value;
+    out[1] = (u8) (value >> 8);
+}
+
+static void PutU32(u8* out, u32 value)
+{
+    for (int i = 0; i < 4; i++)
+        out[i] = (u8) (value >> (8 * i));
+}
+
+static u32 GetU32(const u8* in)
+{
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((u32) in[3] << 24);
+}
+
+bool PuzzleSet::Load(const char filepath[])
+{
+    puzzles.clear();
+
+    std::vector<Byte> contents = LoadBinaryFile(filepath);
+    if (contents.size() < 16 || memcmp(contents.data(), "TTTP", 4) != 0 ||
+        GetU32(&contents[4]) != PUZZLE_VERSION)
+        return false;
+
+    size      = contents[8];
+    winLength = contents[9];
+    u32 count = GetU32(&contents[12]);
+
+    s32 numCells = size * size;
+    size_t packedSize = (numCells * 2 + 7) / 8;
+    size_t recordSize = 4 + packedSize;
+
+    if (size < 1 || size > Board::MAX_SIZE || contents.size() < 16 + count * recordSize)
+        return false;
+
+    for (u32 i = 0; i < count; i++)
+    {
+        const u8* record = &contents[16 + i * recordSize];
+
+        Puzzle puzzle;
+        puzzle.moves       = record[0];
+        puzzle.playerIndex = record[1];
+        puzzle.solution    = record[2] | (record[3] << 8);
+        puzzle.cells.resize(numCells);
+
+        for (s32 c = 0; c < numCells; c++)
+            puzzle.cells[c] = (CellElement) ((record[4 + c / 4] >> (2 * (c % 4))) & 3);
+
+        puzzles.push_back(puzzle);
+    }
+
+    return true;
+}
+
+bool PuzzleSet::Save(const char filepath[]) const
+{
+    FILE* file = fopen(filepath, "wb");
+    if (!file)
+        return false;
+
+    u8 header[16] = {};
+    memcpy(header, "TTTP", 4);
+    PutU32(header + 4, PUZZLE_VERSION);
+    header[8] = (u8) size;
+    header[9] = (u8) winLength;
+    PutU32(header + 12, (u32) puzzles.size());
+    fwrite(header, 1, sizeof(header), file);
+
+    s32 numCells = size * size;
+    std::vector<u8> record(4 + (numCells * 2 + 7) / 8);
+
+    for (const Puzzle& puzzle : puzzles)
+    {
+        memset(record.data(), 0, record.size());
+        record[0] = (u8) puzzle.moves;
+        record[1] = (u8) puzzle.playerIndex;
+        PutU16(&record[2], (u16) puzzle.solution);
+
+        for (s32 c = 0; c < numCells; c++)
+            record[4 + c / 4] |= (u8) puzzle.cells[c] << (2 * (c % 4));
+
+        fwrite(record.data(), 1, record.size(), file);
+    }
+
+    fclose(file);
+    return true;
+}
+
+void PuzzleSolver::Clear()
+{
+    memo.clear();
+}
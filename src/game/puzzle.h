@@ -0,0 +1,143 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+
+// A position where the player to move can force a win in exactly moves of
+// their own moves, and only one first move does it.
+struct Puzzle
+{
+    std::vector<CellElement> cells;
+    s32 playerIndex;
+    s32 moves;
+    s32 solution;
+};
+
+// Puzzle file, all little endian:
+//
+//   "TTTP", u32 version, u8 size, u8 winLength, u16 0, u32 count
+//   per puzzle: u8 moves, u8 player to move, u16 solution,
+//               cells packed 2 bits each
+struct PuzzleSet
+{
+    s32 size;
+    s32 winLength;
+    std::vector<Puzzle> puzzles;
+
+    bool Load(const char filepath[]);
+    bool Save(const char filepath[]) const;
+};
+
+// Exhaustive, tries every empty cell for both players. Remembers positions
+// it has solved, so use one per thread and Clear it between positions. Takes
+// a Board or a FixedBoard, the fixed one is a lot quicker where there is one.
+struct PuzzleSolver
+{
+    std::unordered_map<u64, bool> memo;
+
+    void Clear();
+
+    // Can the player to move win within plies moves, counting both players'
+    template <typename BoardType>
+    bool CanForceWin(BoardType& board, s32 plies);
+
+    // Does every reply lose within plies, the reply included
+    template <typename BoardType>
+    bool AllRepliesLose(BoardType& board, s32 plies);
+
+    // The only move winning in exactly moves, -1 if board isn't such a puzzle
+    template <typename BoardType>
+    s32 FindUniqueSolution(BoardType& board, s32 moves);
+};
+
+template <typename BoardType>
+bool PuzzleSolver::CanForceWin(BoardType& board, s32 plies)
+{
+    if (plies < 1)
+        return false;
+
+    s32 moves[BoardType::MAX_MOVES];
+    s32 numMoves = board.GenerateMoves(moves);
+
+    // Winning right away needs no lookahead
+    for (s32 i = 0; i < numMoves; i++)
+    {
+        board.MakeMove(moves[i]);
+        bool won = board.WonThrough(moves[i]);
+        board.UndoMove(moves[i]);
+
+        if (won)
+            return true;
+    }
+
+    if (plies < 3)
+        return false;
+
+    u64 key = board.hash ^ ((u64) plies * 0x9E3779B97F4A7C15ULL);
+    auto found = memo.find(key);
+    if (found != memo.end())
+        return found->second;
+
+    bool result = false;
+    for (s32 i = 0; i < numMoves && !result; i++)
+    {
+        board.MakeMove(moves[i]);
+        result = !board.IsFull() && AllRepliesLose(board, plies - 1);
+        board.UndoMove(moves[i]);
+    }
+
+    memo[key] = result;
+    return result;
+}
+
+template <typename BoardType>
+bool PuzzleSolver::AllRepliesLose(BoardType& board, s32 plies)
+{
+    s32 moves[BoardType::MAX_MOVES];
+    s32 numMoves = board.GenerateMoves(moves);
+
+    for (s32 i = 0; i < numMoves; i++)
+    {
+        board.MakeMove(moves[i]);
+        bool lost = !board.WonThrough(moves[i]) && !board.IsFull() &&
+                    CanForceWin(board, plies - 1);
+        board.UndoMove(moves[i]);
+
+        if (!lost)
+            return false;
+    }
+
+    return true;
+}
+
+template <typename BoardType>
+s32 PuzzleSolver::FindUniqueSolution(BoardType& board, s32 moves)
+{
+    // Has to take exactly that many moves, not fewer
+    if (moves > 1 && CanForceWin(board, 2 * moves - 3))
+        return -1;
+
+    s32 cells[BoardType::MAX_MOVES];
+    s32 numCells = board.GenerateMoves(cells);
+    s32 solution = -1;
+
+    for (s32 i = 0; i < numCells; i++)
+    {
+        board.MakeMove(cells[i]);
+        bool wins = board.WonThrough(cells[i]) ||
+                    (moves > 1 && !board.IsFull() && AllRepliesLose(board, 2 * moves - 2));
+        board.UndoMove(cells[i]);
+
+        if (!wins)
+            continue;
+
+        if (solution >= 0)
+            return -1;
+
+        solution = cells[i];
+    }
+
+    return solution;
+}
@@ -0,0 +1,355 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "universal/types.h"
+#include "platform/fileio.h"
+#include "board.h"
+#include "match.h"
+
+static const char INDEX_MAGIC[4] = { 'T', 'T', 'T', 'R' };
+static const u32 INDEX_VERSION = 2;
+static const size_t KEY_BYTES = 20;
+
+static const size_t HEADER_BYTES = 6;
+static const size_t MAX_RECORD_BYTES = HEADER_BYTES + 2 * Board::MAX_MOVES + 4;
+
+// FNV-1a, enough to spot a torn or half written record
+static u32 Checksum(const u8 data[], size_t size)
+{
+    u32 hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 16777619u;
+
+    return hash;
+}
+
+static void PutU16(u8* out, u16 value)
+{
+    out[0] = (u8) value;
+    out[1] = (u8) (value >> 8);
+}
+
+static void PutU32(u8* out, u32 value)
+{
+    for (int i = 0; i < 4; i++)
+        out[i] = (u8) (value >> (8 * i));
+}
+
+static void PutU64(u8* out, u64 value)
+{
+    for (int i = 0; i < 8; i++)
+        out[i] = (u8) (value >> (8 * i));
+}
+
+static u16 GetU16(const u8* data)
+{
+    return (u16) (data[0] | (data[1] << 8));
+}
+
+static u32 GetU32(const u8* data)
+{
+    return (u32) data[0] | ((u32) data[1] << 8) | ((u32) data[2] << 16) | ((u32) data[3] << 24);
+}
+
+static u64 GetU64(const u8* data)
+{
+    return (u64) GetU32(data) | ((u64) GetU32(data + 4) << 32);
+}
+
+// Reads the record the file is at, which starts at offset. False if it's
+// torn or not a record at all. out can be null to only skip it, checksum
+// gets the record's own when it isn't null.
+static bool ReadRecord(FILE* file, u64 offset, u64 fileEnd, ReplayGame* out, u64& next, u32* checksum = nullptr)
+{
+    u8 record[MAX_RECORD_BYTES];
+    if (offset + HEADER_BYTES > fileEnd || fread(record, 1, HEADER_BYTES, file) != HEADER_BYTES)
+        return false;
+
+    s32 size = record[0];
+    s32 numMoves = GetU16(record + 4);
+    if (size < 1 || size > Board::MAX_SIZE || record[1] < 1 || record[1] > size || record[2] > 1 ||
+        record[3] > (u8) MatchStatus::DRAW || numMoves > size * size)
+        return false;
+
+    size_t bytes = HEADER_BYTES + 2 * numMoves + 4;
+    if (offset + bytes > fileEnd || fread(record + HEADER_BYTES, 1, bytes - HEADER_BYTES, file) != bytes - HEADER_BYTES)
+        return false;
+
+    u32 check = GetU32(record + bytes - 4);
+    if (check != Checksum(record, bytes - 4))
+        return false;
+
+    if (checksum)
+        *checksum = check;
+
+    if (out)
+    {
+        out->size        = size;
+        out->winLength   = record[1];
+        out->firstPlayer = record[2];
+        out->status      = (MatchStatus) record[3];
+        out->moves.resize(numMoves);
+
+        for (s32 i = 0; i < numMoves; i++)
+            out->moves[i] = GetU16(record + HEADER_BYTES + 2 * i);
+    }
+
+    next = offset + bytes;
+    return true;
+}
+
+bool ReplayLog::Open(const char filepath[])
+{
+    Close();
+
+    path = filepath;
+    file = fopen(path.c_str(), "r+b");
+    if (!file)
+        file = fopen(path.c_str(), "w+b");
+    if (!file)
+        return false;
+
+    u64 fileEnd = GetFileLength(file);
+    std::string indexPath = path + ".idx";
+
+    {   // Whatever of the index still matches the log
+        keys.clear();
+        bool valid = false;
+        bool dropped = false;
+
+        FILE* in = fopen(indexPath.c_str(), "rb");
+        if (in)
+        {
+            u8 header[8];
+            valid = fread(header, 1, 8, in) == 8 && memcmp(header, INDEX_MAGIC, 4) == 0 &&
+                    GetU32(header + 4) == INDEX_VERSION;
+
+            // Every key has to land on the record it was written for,
+            // an index left over from another log doesn't
+            u8 entry[KEY_BYTES];
+            while (valid && fread(entry, 1, KEY_BYTES, in) == KEY_BYTES)
+            {
+                Key key = { GetU64(entry), GetU64(entry + 8), GetU32(entry + 16) };
+                u64 next;
+                u32 check;
+
+                if (key.game != keys.size() * GAMES_PER_KEY || key.offset >= fileEnd ||
+                    (keys.empty() ? key.offset != 0 : key.offset <= keys.back().offset) ||
+                    !SeekFile(file, key.offset) || !ReadRecord(file, key.offset, fileEnd, nullptr, next, &check) ||
+                    check != key.check)
+                {
+                    valid = false;
+                    break;
+                }
+
+                keys.push_back(key);
+            }
+
+            fclose(in);
+        }
+
+        if (!valid)
+            keys.clear();
+
+        // Counts the games after the last key, keying them on the way
+        u64 game, offset;
+        auto scan = [&]()
+        {
+            game = keys.empty() ? 0 : keys.back().game;
+            offset = keys.empty() ? 0 : keys.back().offset;
+
+            u64 next;
+            u32 check;
+            SeekFile(file, offset);
+            while (ReadRecord(file, offset, fileEnd, nullptr, next, &check))
+            {
+                if (game == keys.size() * GAMES_PER_KEY)
+                    keys.push_back({ game, offset, check });
+
+                game++;
+                offset = next;
+            }
+        };
+
+        size_t keysKept = keys.size();
+        scan();
+
+        // Only a torn record can be left after the last whole one. More
+        // than that and the keys skipped games, so it's all read again.
+        if (keysKept > 0 && fileEnd - offset >= MAX_RECORD_BYTES)
+        {
+            keys.clear();
+            keysKept = 0;
+            valid = false;
+            scan();
+        }
+
+        numGames = game;
+        end = offset;
+
+        // The last key's game can be the torn one
+        while (!keys.empty() && keys.back().game >= numGames)
+        {
+            keys.pop_back();
+            dropped = true;
+        }
+
+        if (!valid || dropped)
+        {   // Written out again, it's small next to the log
+            indexFile = fopen(indexPath.c_str(), "wb");
+            if (!indexFile)
+                return false;
+
+            u8 header[8];
+            memcpy(header, INDEX_MAGIC, 4);
+            PutU32(header + 4, INDEX_VERSION);
+            fwrite(header, 1, 8, indexFile);
+            keysKept = 0;
+        }
+        else
+        {
+            indexFile = fopen(indexPath.c_str(), "ab");
+            if (!indexFile)
+                return false;
+        }
+
+        for (size_t i = keysKept; i < keys.size(); i++)
+        {
+            u8 entry[KEY_BYTES];
+            PutU64(entry, keys[i].game);
+            PutU64(entry + 8, keys[i].offset);
+            PutU32(entry + 16, keys[i].check);
+            fwrite(entry, 1, KEY_BYTES, indexFile);
+        }
+
+        fflush(indexFile);
+    }
+
+    return true;
+}
+
+void ReplayLog::Close()
+{
+    if (file)
+        fclose(file);
+    if (indexFile)
+        fclose(indexFile);
+
+    file = indexFile = nullptr;
+    keys.clear();
+    numGames = end = 0;
+}
+
+// Flushed but not synced, losing the last few games in a crash is fine
+bool ReplayLog::Append(const ReplayGame& game)
+{
+    if (!file || game.moves.size() > Board::MAX_MOVES)
+        return false;
+
+    u8 record[MAX_RECORD_BYTES];
+    record[0] = (u8) game.size;
+    record[1] = (u8) game.winLength;
+    record[2] = (u8) game.firstPlayer;
+    record[3] = (u8) game.status;
+    PutU16(record + 4, (u16) game.moves.size());
+
+    for (size_t i = 0; i < game.moves.size(); i++)
+        PutU16(record + HEADER_BYTES + 2 * i, game.moves[i]);
+
+    size_t bytes = HEADER_BYTES + 2 * game.moves.size() + 4;
+    u32 check = Checksum(record, bytes - 4);
+    PutU32(record + bytes - 4, check);
+
+    if (!SeekFile(file, end) || fwrite(record, 1, bytes, file) != bytes || fflush(file) != 0)
+        return false;
+
+    if (numGames % GAMES_PER_KEY == 0)
+    {
+        keys.push_back({ numGames, end, check });
+
+        u8 entry[KEY_BYTES];
+        PutU64(entry, numGames);
+        PutU64(entry + 8, end);
+        PutU32(entry + 16, check);
+        fwrite(entry, 1, KEY_BYTES, indexFile);
+        fflush(indexFile);
+    }
+
+    numGames++;
+    end += bytes;
+    return true;
+}
+
+bool ReplayLog::Read(u64 game, ReplayGame& out)
+{
+    if (!file || game >= numGames)
+        return false;
+
+    // Last key at or before the game
+    auto after = std::upper_bound(keys.begin(), keys.end(), game,
+                                  [](u64 value, const Key& key) { return value < key.game; });
+    const Key& key = *(after - 1);
+
+    u64 offset = key.offset;
+    u64 next;
+    if (!SeekFile(file, offset))
+        return false;
+
+    for (u64 i = key.game; i < game; i++)
+    {
+        if (!ReadRecord(file, offset, end, nullptr, next))
+            return false;
+
+        offset = next;
+    }
+
+    return ReadRecord(file, offset, end, &out, next);
+}
+
+void ReplayCursor::Load(const ReplayGame& value)
+{
+    game = value;
+    keyframes.clear();
+
+    Board board;
+    board.Init(game.size, game.winLength);
+    board.Clear(game.firstPlayer);
+
+    // A record that checks out can still have moves that don't, the game stops there
+    s32 numMoves = (s32) game.moves.size();
+    for (s32 i = 0; i <= numMoves; i++)
+    {
+        if (i % KEYFRAME_MOVES == 0)
+            keyframes.push_back(board);
+
+        if (i == numMoves)
+            break;
+
+        s32 move = game.moves[i];
+        if (move >= board.numCells || board.cells[move] != CellElement::EMPTY)
+        {
+            game.moves.resize(i);
+            break;
+        }
+
+        board.MakeMove(move);
+    }
+}
+
+void ReplayCursor::Seek(s32 moves, Match& out) const
+{
+    s32 numMoves = (s32) game.moves.size();
+    moves = moves < 0 ? 0 : (moves > numMoves ? numMoves : moves);
+
+    out.board = keyframes[moves / KEYFRAME_MOVES];
+    for (s32 i = (moves / KEYFRAME_MOVES) * KEYFRAME_MOVES; i < moves; i++)
+        out.board.MakeMove(game.moves[i]);
+
+    out.status   = moves == numMoves ? game.status : MatchStatus::PLAYING;
+    out.lastMove = moves > 0 ? game.moves[moves - 1] : -1;
+    out.timed    = false;
+}
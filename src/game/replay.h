@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+#include "match.h"
+
+// A finished game, everything needed to play it back
+struct ReplayGame
+{
+    s32 size;
+    s32 winLength;
+    s32 firstPlayer;
+    MatchStatus status;
+    std::vector<u16> moves;
+};
+
+// Every finished game appended to one file, one record after the other:
+//
+//   u8 size, u8 winLength, u8 first player, u8 status, u16 moves,
+//   u16 cell per move, u32 checksum of everything before it
+//
+// "<path>.idx" is a sparse index next to it, "TTTR", u32 version and then
+// u64 game, u64 offset and the record's u32 checksum for every
+// GAMES_PER_KEY-th game. Reading game n is a binary search of the index and
+// at most GAMES_PER_KEY - 1 records skipped, however big the log gets. All
+// little endian. Open reads the record under every key and rebuilds the
+// index from the log if any of them isn't the one it was written for.
+//
+// A record torn by a crash ends the log, the next one written replaces it.
+struct ReplayLog
+{
+    static const u64 GAMES_PER_KEY = 256;
+
+    struct Key
+    {
+        u64 game;
+        u64 offset;
+        u32 check;      // Checksum of the record at offset
+    };
+
+    std::string path;
+    FILE* file { nullptr };         // Reading and writing, always seeked first
+    FILE* indexFile { nullptr };
+    std::vector<Key> keys;
+    u64 numGames;
+    u64 end;                        // Where the last whole record finishes
+
+    // Creates the log if there isn't one and catches the index up with it
+    bool Open(const char filepath[]);
+    void Close();
+
+    bool Append(const ReplayGame& game);
+    bool Read(u64 game, ReplayGame& out);
+};
+
+// One game from the log to scrub through. The board is kept every
+// KEYFRAME_MOVES moves so any move is a copy and a few MakeMoves away.
+struct ReplayCursor
+{
+    static const s32 KEYFRAME_MOVES = 16;
+
+    ReplayGame game;
+    std::vector<Board> keyframes;
+
+    void Load(const ReplayGame& value);
+
+    // The match as it was after moves moves
+    void Seek(s32 moves, Match& out) const;
+};
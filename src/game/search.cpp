@@ -0,0 +1,424 @@
+#include "search.h"
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "board.h"
+
+// Win scores are stored relative to the position they were found in
+// so the same entry works no matter how deep it's probed from.
+static s32 ScoreToTT(s32 score, s32 ply)
+{
+    if (score >= WIN_SCORE - Board::MAX_MOVES)
+        return score + ply;
+    if (score <= -(WIN_SCORE - Board::MAX_MOVES))
+        return score - ply;
+
+    return score;
+}
+
+static s32 ScoreFromTT(s32 score, s32 ply)
+{
+    if (score >= WIN_SCORE - Board::MAX_MOVES)
+        return score - ply;
+    if (score <= -(WIN_SCORE - Board::MAX_MOVES))
+        return score + ply;
+
+    return score;
+}
+
+// The stop signal is read at every node. The clock costs more than a node
+// on small boards and much less than one on big boards with the network,
+// so the nodes between reads of it are sized to keep them about
+// CHECK_SECONDS apart, between 1 and MAX_CHECK_INTERVAL nodes.
+static const s32 MAX_CHECK_INTERVAL = 1024;
+static const f64 CHECK_SECONDS      = 0.0001;
+
+static f64 GetTime()
+{
+    using namespace std::chrono;
+    return duration<f64>(steady_clock::now().time_since_epoch()).count();
+}
+
+static s32 RootNoise(u64 hash, s32 move, s32 amount, u64 seed)
+{
+    Random random;
+    random.Seed(hash ^ seed ^ ((u64) (move + 1) * 0x9E3779B97F4A7C15ULL));
+    return random.Range(2 * amount + 1) - amount;
+}
+
+static void MoveToFront(s32 moves[], s32 numMoves, s32 move)
+{
+    for (s32 i = 0; i < numMoves; i++)
+    {
+        if (moves[i] == move)
+        {
+            for (; i > 0; i--)
+                moves[i] = moves[i - 1];
+            moves[0] = move;
+            return;
+        }
+    }
+}
+
+static u64 PackEntry(s32 score, s32 move, s32 depth, Bound bound)
+{
+    return (u64) (u32) score | ((u64) (u16) move << 32) | ((u64) (u8) depth << 48) | ((u64) bound << 56);
+}
+
+static TTEntry UnpackEntry(u64 key, u64 data)
+{
+    return TTEntry { key, (s32) (u32) data, (s16) (u16) (data >> 32), (s8) (u8) (data >> 48), (Bound) (data >> 56) };
+}
+
+void TranspositionTable::Init(s32 sizeLog2)
+{
+    numSlots = (u64) 1 << sizeLog2;
+    slots.reset(new TTSlot[numSlots]);
+    mask = numSlots - 1;
+    Clear();
+}
+
+void TranspositionTable::Clear()
+{
+    // Depth -1 marks an empty slot
+    u64 empty = PackEntry(0, -1, -1, Bound::EXACT);
+    for (u64 i = 0; i < numSlots; i++)
+    {
+        slots[i].check.store(empty, std::memory_order_relaxed);
+        slots[i].data.store(empty, std::memory_order_relaxed);
+    }
+}
+
+bool TranspositionTable::IsEmpty() const
+{
+    return !slots;
+}
+
+bool TranspositionTable::Probe(u64 key, TTEntry& out) const
+{
+    const TTSlot& slot = slots[key & mask];
+    u64 data = slot.data.load(std::memory_order_relaxed);
+    if ((slot.check.load(std::memory_order_relaxed) ^ data) != key)
+        return false;
+
+    out = UnpackEntry(key, data);
+    return out.depth >= 0;
+}
+
+void TranspositionTable::Store(u64 key, s32 score, s32 move, s32 depth, Bound bound)
+{
+    TTSlot& slot = slots[key & mask];
+
+    // Keep deeper results for the same position
+    TTEntry current;
+    if (Probe(key, current) && current.depth > depth)
+        return;
+
+    // Depth only goes up to 127 here, which just means very deep
+    // entries get searched again instead of cutting off
+    if (depth > 127)
+        depth = 127;
+
+    u64 data = PackEntry(score, move, depth, bound);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+s32 Evaluate(const Board& board)
+{
+    PatternEvaluator patterns;
+    patterns.Init(board);
+    return patterns.Score(board.playerIndex);
+}
+
+s32 GenerateCandidates(const Board& board, s32 moves[])
+{
+    // Small boards are cheap enough to search completely
+    if (board.size <= 4)
+        return board.GenerateMoves(moves);
+
+    s32 size = board.size;
+    if (board.moveCount == 0)
+    {
+        moves[0] = (size / 2) * size + size / 2;
+        return 1;
+    }
+
+    // Only cells within two of an element already placed
+    const s32 radius = 2;
+    s32 count = 0;
+
+    for (s32 row = 0; row < size; row++)
+        for (s32 col = 0; col < size; col++)
+        {
+            if (board.cells[row * size + col] != CellElement::EMPTY)
+                continue;
+
+            bool nearby = false;
+            for (s32 r = row - radius; r <= row + radius && !nearby; r++)
+                for (s32 c = col - radius; c <= col + radius; c++)
+                {
+                    if (r >= 0 && r < size && c >= 0 && c < size &&
+                        board.cells[r * size + c] != CellElement::EMPTY)
+                    {
+                        nearby = true;
+                        break;
+                    }
+                }
+
+            if (nearby)
+                moves[count++] = row * size + col;
+        }
+
+    return count;
+}
+
+void Searcher::Prepare(const Board& board, const SearchLimits& searchLimits)
+{
+    limits  = searchLimits;
+    nodes   = 0;
+    stopped = false;
+    checkInterval = 1;
+    checkCountdown = 1;
+    startTime = GetTime();
+    lastCheck = startTime;
+
+    useNetwork = network && network->Supports(board);
+    if (useNetwork)
+        network->Refresh(accumulator, board);
+    else
+        patterns.Init(board);
+}
+
+SearchResult Searcher::Search(Board& board, const SearchLimits& searchLimits)
+{
+    Prepare(board, searchLimits);
+
+    s32 moves[Board::MAX_MOVES];
+    s32 numMoves = GenerateCandidates(board, moves);
+
+    SearchResult result = { numMoves ? moves[0] : -1, 0, 0, 0 };
+
+    s32 maxDepth = board.numCells - board.moveCount;
+    if (limits.depth > 0 && limits.depth < maxDepth)
+        maxDepth = limits.depth;
+
+    if (table)
+    {
+        TTEntry entry;
+        if (table->Probe(board.hash, entry) && entry.move >= 0)
+            MoveToFront(moves, numMoves, entry.move);
+    }
+
+    for (s32 depth = 1; depth <= maxDepth; depth++)
+    {
+        s32 alpha = -INFINITE_SCORE;
+        s32 best = -INFINITE_SCORE;
+        s32 bestMove = moves[0];
+
+        for (s32 i = 0; i < numMoves; i++)
+        {
+            s32 move = moves[i];
+            MakeMove(board, move);
+
+            s32 score;
+            if (board.WonThrough(move))
+                score = WIN_SCORE - 1;
+            else if (board.IsFull())
+                score = 0;
+            else
+            {
+                // With noise a move up to rootNoise below alpha can still
+                // end up best, so it needs an exact score too
+                score = -Negamax(board, depth - 1, -INFINITE_SCORE, -(alpha - rootNoise), 1);
+            }
+
+            UndoMove(board, move);
+
+            if (stopped)
+                break;
+
+            if (rootNoise && !IsWinScore(score))
+                score += RootNoise(board.hash, move, rootNoise, noiseSeed);
+
+            if (score > best)
+            {
+                best = score;
+                bestMove = move;
+            }
+            if (best > alpha)
+                alpha = best;
+        }
+
+        // An unfinished iteration can't be trusted, keep the last one
+        if (stopped)
+            break;
+
+        result.move  = bestMove;
+        result.score = best;
+        result.depth = depth;
+
+        if (table)
+            table->Store(board.hash, ScoreToTT(best, 0), bestMove, depth, Bound::EXACT);
+
+        if (onIteration)
+        {
+            result.nodes = nodes;
+            onIteration(result, callbackData);
+        }
+
+        // Search the best move first next time
+        MoveToFront(moves, numMoves, bestMove);
+
+        if (IsWinScore(best))
+            break;
+    }
+
+    result.nodes = nodes;
+    return result;
+}
+
+s32 Searcher::Negamax(Board& board, s32 depth, s32 alpha, s32 beta, s32 ply)
+{
+    if (ShouldStop())
+    {
+        stopped = true;
+        return 0;
+    }
+
+    if (depth == 0)
+        return EvaluateLeaf(board);
+
+    s32 alphaOrig = alpha;
+    s32 ttMove = -1;
+
+    if (table)
+    {
+        TTEntry entry;
+        if (table->Probe(board.hash, entry))
+        {
+            ttMove = entry.move;
+
+            if (entry.depth >= depth)
+            {
+                s32 score = ScoreFromTT(entry.score, ply);
+
+                if (entry.bound == Bound::EXACT)
+                    return score;
+                if (entry.bound == Bound::LOWER && score > alpha)
+                    alpha = score;
+                else if (entry.bound == Bound::UPPER && score < beta)
+                    beta = score;
+
+                if (alpha >= beta)
+                    return score;
+            }
+        }
+    }
+
+    s32 moves[Board::MAX_MOVES];
+    s32 numMoves = GenerateCandidates(board, moves);
+    if (ttMove >= 0)
+        MoveToFront(moves, numMoves, ttMove);
+
+    s32 best = -INFINITE_SCORE;
+    s32 bestMove = moves[0];
+
+    for (s32 i = 0; i < numMoves; i++)
+    {
+        s32 move = moves[i];
+        MakeMove(board, move);
+
+        s32 score;
+        if (board.WonThrough(move))
+            score = WIN_SCORE - (ply + 1);
+        else if (board.IsFull())
+            score = 0;
+        else
+            score = -Negamax(board, depth - 1, -beta, -alpha, ply + 1);
+
+        UndoMove(board, move);
+
+        if (stopped)
+            return 0;
+
+        if (score > best)
+        {
+            best = score;
+            bestMove = move;
+        }
+        if (best > alpha)
+            alpha = best;
+        if (alpha >= beta)
+            break;
+    }
+
+    if (table)
+    {
+        Bound bound = Bound::EXACT;
+        if (best <= alphaOrig)
+            bound = Bound::UPPER;
+        else if (best >= beta)
+            bound = Bound::LOWER;
+
+        table->Store(board.hash, ScoreToTT(best, ply), bestMove, depth, bound);
+    }
+
+    return best;
+}
+
+bool Searcher::ShouldStop()
+{
+    if (limits.nodes && nodes >= limits.nodes)
+        return true;
+
+    if (stopSignal && stopSignal->load(std::memory_order_relaxed))
+        return true;
+
+    if (--checkCountdown > 0)
+        return false;
+
+    f64 now = GetTime();
+    f64 elapsed = now - lastCheck;
+    lastCheck = now;
+
+    if (elapsed < CHECK_SECONDS / 2 && checkInterval < MAX_CHECK_INTERVAL)
+        checkInterval *= 2;
+    else if (elapsed > CHECK_SECONDS * 2 && checkInterval > 1)
+        checkInterval /= 2;
+    checkCountdown = checkInterval;
+
+    return limits.time > 0.0 && now - startTime >= limits.time;
+}
+
+void Searcher::MakeMove(Board& board, s32 move)
+{
+    if (useNetwork)
+        network->AddElement(accumulator, move, board.playerIndex);
+    else
+        patterns.AddElement(move, board.playerIndex);
+
+    board.MakeMove(move);
+    nodes++;
+}
+
+void Searcher::UndoMove(Board& board, s32 move)
+{
+    board.UndoMove(move);
+
+    if (useNetwork)
+        network->RemoveElement(accumulator, move, board.playerIndex);
+    else
+        patterns.RemoveElement(move);
+}
+
+s32 Searcher::EvaluateLeaf(const Board& board)
+{
+    if (useNetwork)
+        return network->Evaluate(accumulator, board.playerIndex);
+
+    return patterns.Score(board.playerIndex);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "universal/types.h"
+#include "board.h"
+#include "nnue.h"
+#include "patterns.h"
+
+// Scores are from the point of view of the player to move. A win n moves
+// from the root scores WIN_SCORE - n so quicker wins are preferred.
+const s32 WIN_SCORE      = 100000000;
+const s32 INFINITE_SCORE = WIN_SCORE + 1;
+
+inline bool IsWinScore(s32 score)
+{
+    return score >= WIN_SCORE - Board::MAX_MOVES || score <= -(WIN_SCORE - Board::MAX_MOVES);
+}
+
+struct SearchLimits
+{
+    s32 depth;      // 0 means no limit
+    u64 nodes;      // 0 means no limit
+    f64 time;       // Seconds, 0 means no limit. Makes results depend on machine speed.
+};
+
+struct SearchResult
+{
+    s32 move;
+    s32 score;
+    s32 depth;      // Last depth that was searched completely
+    u64 nodes;
+};
+
+enum class Bound : u8
+{
+    EXACT,
+    LOWER,
+    UPPER,
+};
+
+struct TTEntry
+{
+    u64   key;
+    s32   score;
+    s16   move;
+    s8    depth;
+    Bound bound;
+};
+
+// An entry packed into two words, the key stored xor the data. Threads
+// sharing a table can write slots while others read them: a slot torn by
+// two writers no longer checks out against any key, so it's just a miss.
+struct TTSlot
+{
+    std::atomic<u64> check;     // key ^ data
+    std::atomic<u64> data;
+};
+
+struct TranspositionTable
+{
+    std::unique_ptr<TTSlot[]> slots;
+    u64 numSlots;
+    u64 mask;
+
+    void Init(s32 sizeLog2);    // 2^sizeLog2 entries
+    void Clear();
+    bool IsEmpty() const;       // Not initialised yet
+
+    // Copies the entry for key into out, false if there isn't one
+    bool Probe(u64 key, TTEntry& out) const;
+    void Store(u64 key, s32 score, s32 move, s32 depth, Bound bound);
+};
+
+// Static evaluation of a position where the game isn't over yet. Scans the
+// whole board, the search keeps a PatternEvaluator up to date instead.
+s32 Evaluate(const Board& board);
+
+// The cells worth searching. On big boards that's only the ones near
+// elements already placed. moves needs space for MAX_MOVES entries.
+s32 GenerateCandidates(const Board& board, s32 moves[]);
+
+// Iterative deepening alpha-beta. Without a time limit or stop signal
+// the same position and limits always give the same move.
+struct Searcher
+{
+    TranspositionTable* table;  // Can be null
+    const Network* network;     // Can be null, only used on boards it supports
+
+    // Optional, set from another thread to stop the search early
+    const std::atomic<bool>* stopSignal;
+
+    // Optional, called after every completed iteration
+    void (*onIteration)(const SearchResult& result, void* data);
+    void* callbackData;
+
+    // Deterministic error in [-rootNoise, rootNoise] added to each root move's
+    // score, the same for a given position, move and seed. Never turns a win
+    // or loss into something else. 0 for the best move every time.
+    s32 rootNoise;
+    u64 noiseSeed;
+
+    SearchLimits limits;
+    u64 nodes;
+    bool stopped;
+    s32 checkCountdown;
+    s32 checkInterval;  // Nodes between reads of the clock
+    f64 startTime;
+    f64 lastCheck;
+
+    bool useNetwork;
+    Accumulator accumulator;
+    PatternEvaluator patterns;
+
+    SearchResult Search(Board& board, const SearchLimits& searchLimits);
+
+    // Sets up for searching board, Search does this itself. For callers
+    // that drive Negamax on their own.
+    void Prepare(const Board& board, const SearchLimits& searchLimits);
+
+    s32 Negamax(Board& board, s32 depth, s32 alpha, s32 beta, s32 ply);
+
+    bool ShouldStop();
+    void MakeMove(Board& board, s32 move);
+    void UndoMove(Board& board, s32 move);
+    s32  EvaluateLeaf(const Board& board);
+};
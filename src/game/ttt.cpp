@@ -1,21 +1,53 @@
 #include "ttt.h"
 
+#include <cmath>
 #include <cstring>
 #include <ctime>
 #include <string>
+#include <vector>
 #include "universal/types.h"
+#include "universal/math.h"
 #include "platform/application.h"
 #include "engine/shader.h"
 #include "engine/sprite.h"
 #include "engine/ui.h"
 
-static struct
+// Node budgets for the Connect Four computer at each level. It plays
+// perfectly whenever the solver finishes within them.
+static const u64 connectFourNodes[NUM_LEVELS] = { 20000, 200000, 2000000, 20000000 };
+
+static const char* variantNames[(int) Variant::NUM_VARIANTS] = {
+    "Tic Tac Toe",
+    "Connect Four",
+    "Infinite Gomoku",
+};
+
+// Cells across the screen on the infinite board before zooming
+static const int VIEW_CELLS = 15;
+
+// Clock button in the main menu, Tic Tac Toe only
+static const struct
 {
-    std::string text;
-    bool isPaused;
-    bool isEndScreen;
-    bool inMainMenu;
-} pauseData;
+    const char* name;
+    const char* spec;
+} clockSettings[] = {
+    { "Off",       "none" },
+    { "1 min",     "60" },
+    { "30s + 2s",  "30+2" },
+    { "5s a move", "move:5" },
+};
+
+static const int NUM_CLOCK_SETTINGS = sizeof(clockSettings) / sizeof(clockSettings[0]);
+
+// Boards across the watch view, 16, 64 or 256 games
+static const int watchSizes[] = { 4, 8, 16 };
+static const int NUM_WATCH_SETTINGS = sizeof(watchSizes) / sizeof(watchSizes[0]);
+
+// Finished games, in the working directory
+static const char* REPLAY_LOG_PATH = "replays.ttr";
+
+// Seconds between moves in the watch view
+static const f64 WATCH_PASS_SECONDS = 0.25;
 
 
 void Game::Init(Application* app)
@@ -25,6 +57,11 @@ void Game::Init(Application* app)
     const f32 boardSize = (f32) app->refScreenHeight - 100.0f;
     const f32 cellSize  = boardSize / 3.0f;
 
+    camera.viewport.topLeft = { (app->refScreenWidth - boardSize) / 2.0f, 50.0f };
+    camera.viewport.size    = { boardSize, boardSize };
+    camera.minCellSize = 8.0f;
+    camera.maxCellSize = boardSize / 2.0f;
+
     spriteShader.LoadShader("res/shaders/sprite.vert", Shader::Type::VERTEX_SHADER);
     spriteShader.LoadShader("res/shaders/sprite.frag", Shader::Type::FRAGMENT_SHADER);
     spriteShader.Compile();
@@ -33,57 +70,357 @@ void Game::Init(Application* app)
     sprites[0].Set({ cellSize, cellSize }, { 0.0f, 0.0f, 0.5f, 1.0f });
     sprites[1].Set({ cellSize, cellSize }, { 0.0f, 0.5f, 1.0f, 1.0f });
 
-    pauseData.inMainMenu = true;
+    gridBoards.Init();
+    gridPieces.Init();
+
+    variant = Variant::TIC_TAC_TOE;
+    match.Start(3, 3);
+    connectFour.Clear();
+    connectFourSolver.Init(21);
+    infiniteBoard.Init(5);
+    window.Init(15, 5);
+    FitCamera();
+
+    // Optional, the computer only uses it on the board size it was made for
+    network.Load("res/nets/gomoku15.nnue");
+
+    level = 1;
+    SetLevel(level);
+
+    // Optional too, the Puzzles button only shows up if they're for this board
+    if (!puzzleSet.Load("res/puzzles/3x3.ttp") || puzzleSet.size != match.board.size || puzzleSet.winLength != match.board.winLength)
+        puzzleSet.puzzles.clear();
+
+    computerIndex = 1;
+    inPuzzle = false;
+    puzzleIndex = 0;
+
+    analysis.network = &network;
+    showHints = false;
+
+    table.Init(16);
+    searcher = {};
+    searcher.table = &table;
+    random.Seed((u64) time(nullptr));
+
+    online = false;
+    netMatch = 0;
+    pendingMove = -1;
+    timingDisplay = timingConfirmed = false;
+    showNetStats = false;
+    inputToDisplay = inputToConfirmed = 0.0;
+
+    clockSetting = 0;
+    timeControl.Parse(clockSettings[clockSetting].spec);
+
+    watching = false;
+    watchSetting = 0;
+
+    // Without it nothing is recorded and there's no Replays button
+    replayLog.Open(REPLAY_LOG_PATH);
+    replaying = false;
+    replayGame = 0;
+
+    pause.inMainMenu = true;
 }
 
 void Game::Reset()
 {
-    for (int i = 0; i < 9; i++)
-        board[i] = CellElement::EMPTY;
+    ponderer.Stop();
+    match.Start(match.board.size, match.board.winLength);
+    StartClock();
+    StartRecording();
+    connectFour.Clear();
+    infiniteBoard.Clear();
+    FitCamera();
     playerScores[0] = 0;
     playerScores[1] = 0;
-    playerIndex = 0;
 
-    pauseData.isPaused = false;
-    pauseData.isEndScreen = false;
-    pauseData.text = "Game Paused...";
+    pause.isPaused = false;
+    pause.isEndScreen = false;
+    pause.text = "Game Paused...";
+
+    if (online)
+        NewOnlineGame();
+
+    if (inPuzzle)
+        StartPuzzle(puzzleIndex);
 }
 
 void Game::NextRound()
 {
-    for (int i = 0; i < 9; i++)
-        board[i] = CellElement::EMPTY;
+    if (inPuzzle)
+    {
+        StartPuzzle(puzzleSolved ? puzzleIndex + 1 : puzzleIndex);
+        return;
+    }
+
+    if (online)
+    {
+        pause.isPaused = false;
+        pause.isEndScreen = false;
+        pause.text = "Game Paused...";
+        NewOnlineGame();
+        return;
+    }
+
+    ponderer.Stop();
+    match.Start(match.board.size, match.board.winLength, match.board.playerIndex);
+    StartClock();
+    StartRecording();
+    connectFour.Clear(connectFour.playerIndex);
+    infiniteBoard.Clear(infiniteBoard.playerIndex);
+    FitCamera();
+
+    pause.isPaused = false;
+    pause.isEndScreen = false;
+    pause.text = "Game Paused...";
+}
+
+// Online games and puzzles are never timed
+void Game::StartClock()
+{
+    if (variant != Variant::TIC_TAC_TOE || online || inPuzzle)
+        return;
+
+    match.StartClock(timeControl);
+
+    if (match.timed && pause.inMainMenu)
+        match.clock.Pause(GetMonotonicTime());
+}
+
+void Game::ToggleHints()
+{
+    showHints = !showHints;
+}
+
+// The human plays the side to move and the strongest level defends
+void Game::StartPuzzle(int index)
+{
+    ponderer.Stop();
+
+    puzzleIndex = index % (int) puzzleSet.puzzles.size();
+    const Puzzle& puzzle = puzzleSet.puzzles[puzzleIndex];
+
+    match.SetPosition(puzzle.cells.data(), puzzle.playerIndex);
+    computerIndex = 1 - puzzle.playerIndex;
+    puzzleMovesLeft = puzzle.moves;
+    puzzleSolved = false;
+
+    computer.Parse(GetLevelSpec(NUM_LEVELS - 1));
+    computer.network = &network;
+
+    pause.isPaused = false;
+    pause.isEndScreen = false;
+    pause.text = "Game Paused...";
+}
+
+// Green for good cells for the player to move, red for bad ones. Proven
+// wins and losses get the full colour, heuristic scores only part of it.
+static Vec4 HintColor(s32 score)
+{
+    f32 t;
+    if (IsWinScore(score))
+        t = score > 0 ? 1.0f : -1.0f;
+    else
+        t = Clamp((f32) score / 100.0f, -1.0f, 1.0f) * 0.5f;
+
+    if (t >= 0.0f)
+        return { 1.0f - 0.6f * t, 1.0f, 1.0f - 0.6f * t, 1.0f };
 
-    pauseData.isPaused = false;
-    pauseData.isEndScreen = false;
-    pauseData.text = "Game Paused...";
+    return { 1.0f, 1.0f + 0.6f * t, 1.0f + 0.6f * t, 1.0f };
+}
+
+void Game::SetVariant(Variant value)
+{
+    variant = value;
+    inPuzzle = false;
+    analysis.Stop();
+    Reset();
+}
+
+void Game::FitCamera()
+{
+    if (variant == Variant::UNBOUNDED)
+    {
+        camera.Fit(VIEW_CELLS, VIEW_CELLS);
+        camera.center = { 0.5f, 0.5f };
+    }
+    else
+    {
+        camera.Fit(GetColumns(), GetRows());
+    }
+}
+
+void Game::UpdateCamera(Application* app)
+{
+    if (!pause.inMainMenu && !pause.isPaused && !watching && !replaying)
+        camera.Update(app);
+}
+
+void Game::SetLevel(int value)
+{
+    level = value;
+    computer.Parse(GetLevelSpec(level));
+    computer.network = &network;
+}
+
+// Starts on the last game played, as it finished
+void Game::StartReplays()
+{
+    ponderer.Stop();
+    analysis.Stop();
+
+    replaying = true;
+    replay.keyframes.clear();
+    pause.inMainMenu = false;
+    pause.isPaused = false;
+    pause.isEndScreen = false;
+
+    ShowReplay(replayLog.numGames - 1, Board::MAX_MOVES);
+}
+
+void Game::StopReplays()
+{
+    replaying = false;
+    pause.inMainMenu = true;
+}
+
+// The match becomes the replay's position, so the rest of the game sees
+// it like any other
+void Game::ShowReplay(u64 game, s32 move)
+{
+    if (game != replayGame || replay.keyframes.empty())
+    {
+        ReplayGame loaded;
+        if (!replayLog.Read(game, loaded))
+            return;
+
+        replay.Load(loaded);
+        replayGame = game;
+    }
+
+    s32 numMoves = (s32) replay.game.moves.size();
+    replayMove = move < 0 ? 0 : (move > numMoves ? numMoves : move);
+
+    bool resized = match.board.size != replay.game.size;
+    replay.Seek(replayMove, match);
+    if (resized)
+        FitCamera();
+}
+
+// Arrows step through moves and games, Home and End jump to either end
+void Game::UpdateReplay(Application* app)
+{
+    if (!replaying)
+        return;
+
+    if (app->GetKeyDown(KEY(LEFT)))
+        ShowReplay(replayGame, replayMove - 1);
+    if (app->GetKeyDown(KEY(RIGHT)))
+        ShowReplay(replayGame, replayMove + 1);
+    if (app->GetKeyDown(KEY(HOME)))
+        ShowReplay(replayGame, 0);
+    if (app->GetKeyDown(KEY(END)))
+        ShowReplay(replayGame, Board::MAX_MOVES);
+
+    if (app->GetKeyDown(KEY(UP)) && replayGame > 0)
+        ShowReplay(replayGame - 1, 0);
+    if (app->GetKeyDown(KEY(DOWN)) && replayGame + 1 < replayLog.numGames)
+        ShowReplay(replayGame + 1, 0);
+}
+
+// The computer plays every game at the current level
+void Game::StartWatching()
+{
+    ponderer.Stop();
+    analysis.Stop();
+
+    int side = watchSizes[watchSetting];
+    monitor.Start(side * side, match.board.size, match.board.winLength, computer, WATCH_PASS_SECONDS);
+
+    watching = true;
+    pause.inMainMenu = false;
+}
+
+void Game::StopWatching()
+{
+    monitor.Stop();
+    watching = false;
+    pause.inMainMenu = true;
 }
 
 bool Game::IsPaused()
 {
-    return pauseData.isPaused;
+    return pause.isPaused;
 }
 
 void Game::SetPause(bool value)
 {
-    if (pauseData.isEndScreen)
+    // Nothing to pause in the watch view or replays, escape goes back to the menu
+    if (watching)
+        StopWatching();
+    else if (replaying)
+        StopReplays();
+    else if (pause.isEndScreen)
         NextRound();
     else
-        pauseData.isPaused = value;
+        pause.isPaused = value;
 }
 
 void Game::Update()
 {
-    if (pauseData.isPaused)
+    if (match.timed)
+    {   // Time only runs while the board is up and nobody has paused
+        f64 now = GetMonotonicTime();
+        if (pause.isPaused || pause.inMainMenu || watching)
+            match.clock.Pause(now);
+        else
+            match.clock.Resume(now);
+
+        if (match.CheckTime())
+            FinishOnTime();
+    }
+
+    if (watching || replaying)
         return;
 
-    if (vsComputer && playerIndex == 1)
+    // Hints only for a human's turn, the computer doesn't need them
+    bool humanTurn = !vsComputer || GetPlayerToMove() != computerIndex;
+    if (showHints && humanTurn && variant == Variant::TIC_TAC_TOE && !pause.isPaused && !pause.inMainMenu)
+        analysis.Follow(match.board);
+    else
+        analysis.Stop();
+
+    if (pause.isPaused)
+        return;
+
+    if (!vsComputer)
+        return;
+
+    if (variant == Variant::CONNECT_FOUR)
+    {
+        if (connectFour.playerIndex == computerIndex)
+            DropDiscComp();
+        return;
+    }
+
+    if (variant == Variant::UNBOUNDED)
+    {
+        if (infiniteBoard.playerIndex == computerIndex)
+            PlaceStoneComp();
+        return;
+    }
+
+    if (match.board.playerIndex == computerIndex)
         PlaceElementComp();
+    else if (!ponderer.running)
+        ponderer.Start(match.board, computer);
 }
 
 void Game::Render(Application* app)
 {
-    if (pauseData.inMainMenu)
+    if (pause.inMainMenu)
     {
         {   // Title
             std::string title = "Tic Tac Toe";
@@ -92,41 +429,147 @@ void Game::Render(Application* app)
             UI::RenderText(app, title, font, { 1.0f, 1.0f, 1.0f, 1.0f }, position, 0.0f);
         }
 
-        {   // Buttons
+        {   // Buttons, one under the other
             // Not necessary to have both players since Inconsolata
             // is monospace but welp.
             std::string btn1Text = "1 Player";
             std::string btn2Text = "2 Player";
 
+            Vec2 size = UI::GetRenderedTextSize(btn1Text, font);
+            f32 top = 60.0f;
+            f32 spacing = size.y + 25.0f;
+
+            {   // Game, cycles through the variants
+                std::string variantText = std::string("Game: ") + variantNames[(int) variant];
+                Vec2 variantSize = UI::GetRenderedTextSize(variantText, font);
+                Vec2 position = { (app->refScreenWidth - variantSize.x - 20.0f) / 2.0f, top };
+                if (UI::RenderTextButton(app, GenUIID(), variantText, font,
+                                         { 10.0f, 5.0f }, position, 0.0f))
+                {
+                    SetVariant((Variant) (((int) variant + 1) % (int) Variant::NUM_VARIANTS));
+                }
+            }
+
             {   // 1 Player button
-                Vec2 size = UI::GetRenderedTextSize(btn1Text, font);
-                Vec2 position = { (app->refScreenWidth - size.x - 20.0f) / 2.0f, (app->refScreenHeight / 2.0f) - size.y - 15.0f };
+                Vec2 position = { (app->refScreenWidth - size.x - 20.0f) / 2.0f, top + spacing };
                 if (UI::RenderTextButton(app, GenUIID(), btn1Text, font,
                                          { 10.0f, 5.0f }, position, 0.0f))
                 {
                     vsComputer = true;
-                    pauseData.inMainMenu = false;
+                    computerIndex = 1;
+                    inPuzzle = false;
+                    online = false;
+                    SetLevel(level);
+                    pause.inMainMenu = false;
                     Reset();
                 }
             }
 
             {   // 2 Player button
-                Vec2 size = UI::GetRenderedTextSize(btn2Text, font);
-                Vec2 position = { (app->refScreenWidth - size.x - 20.0f) / 2.0f, (app->refScreenHeight / 2.0f) + size.y + 15.0f };
+                Vec2 btn2Size = UI::GetRenderedTextSize(btn2Text, font);
+                Vec2 position = { (app->refScreenWidth - btn2Size.x - 20.0f) / 2.0f, top + 2.0f * spacing };
                 if (UI::RenderTextButton(app, GenUIID(), btn2Text, font,
                                          { 10.0f, 5.0f }, position, 0.0f))
                 {
                     vsComputer = false;
-                    pauseData.inMainMenu = false;
+                    inPuzzle = false;
+                    online = false;
+                    pause.inMainMenu = false;
                     Reset();
                 }
             }
+
+            {   // Difficulty for 1 Player, cycles through the levels
+                std::string levelText = std::string("Level: ") + GetLevelName(level);
+                Vec2 levelSize = UI::GetRenderedTextSize(levelText, font);
+                Vec2 position = { (app->refScreenWidth - levelSize.x - 20.0f) / 2.0f, top + 3.0f * spacing };
+                if (UI::RenderTextButton(app, GenUIID(), levelText, font,
+                                         { 10.0f, 5.0f }, position, 0.0f))
+                {
+                    level = (level + 1) % NUM_LEVELS;
+                }
+            }
+
+            if (variant == Variant::TIC_TAC_TOE && !puzzleSet.puzzles.empty())
+            {   // Puzzles, carries on from the last one played
+                std::string puzzleText = "Puzzles";
+                Vec2 puzzleSize = UI::GetRenderedTextSize(puzzleText, font);
+                Vec2 position = { (app->refScreenWidth - puzzleSize.x - 20.0f) / 2.0f, top + 4.0f * spacing };
+                if (UI::RenderTextButton(app, GenUIID(), puzzleText, font,
+                                         { 10.0f, 5.0f }, position, 0.0f))
+                {
+                    vsComputer = true;
+                    inPuzzle = true;
+                    online = false;
+                    pause.inMainMenu = false;
+                    Reset();
+                }
+            }
+
+            if (variant == Variant::TIC_TAC_TOE)
+            {   // Online, against whoever else connects to the same server,
+                // then Watch for a grid of computer games and Replays once
+                // there are finished games to go through
+                std::string onlineText = "Online";
+                std::string watchText = "Watch";
+                std::string replaysText = "Replays";
+                bool showReplays = replayLog.numGames > 0;
+
+                Vec2 onlineSize = UI::GetRenderedTextSize(onlineText, font) + Vec2 { 20.0f, 10.0f };
+                Vec2 watchSize = UI::GetRenderedTextSize(watchText, font) + Vec2 { 20.0f, 10.0f };
+                Vec2 replaysSize = UI::GetRenderedTextSize(replaysText, font) + Vec2 { 20.0f, 10.0f };
+                f32 rowWidth = onlineSize.x + watchSize.x + 10.0f + (showReplays ? replaysSize.x + 10.0f : 0.0f);
+                f32 slot = puzzleSet.puzzles.empty() ? 4.0f : 5.0f;
+
+                Vec2 position = { (app->refScreenWidth - rowWidth) / 2.0f, top + slot * spacing };
+                if (UI::RenderTextButton(app, GenUIID(), onlineText, font,
+                                         { 10.0f, 5.0f }, position, 0.0f))
+                {
+                    StartOnline();
+                }
+
+                position.x += onlineSize.x + 10.0f;
+                if (UI::RenderTextButton(app, GenUIID(), watchText, font,
+                                         { 10.0f, 5.0f }, position, 0.0f))
+                {
+                    StartWatching();
+                }
+
+                position.x += watchSize.x + 10.0f;
+                if (showReplays && UI::RenderTextButton(app, GenUIID(), replaysText, font,
+                                                        { 10.0f, 5.0f }, position, 0.0f))
+                {
+                    StartReplays();
+                }
+            }
+
+            if (variant == Variant::TIC_TAC_TOE)
+            {   // Time control for 1 and 2 Player, cycles through the settings
+                std::string clockText = std::string("Clock: ") + clockSettings[clockSetting].name;
+                Vec2 clockSize = UI::GetRenderedTextSize(clockText, font);
+                f32 slot = puzzleSet.puzzles.empty() ? 5.0f : 6.0f;
+                Vec2 position = { (app->refScreenWidth - clockSize.x - 20.0f) / 2.0f, top + slot * spacing };
+                if (UI::RenderTextButton(app, GenUIID(), clockText, font,
+                                         { 10.0f, 5.0f }, position, 0.0f))
+                {
+                    clockSetting = (clockSetting + 1) % NUM_CLOCK_SETTINGS;
+                    timeControl.Parse(clockSettings[clockSetting].spec);
+                }
+            }
         }
         return;
     }
 
+    if (watching)
+    {
+        RenderGrid(app);
+        return;
+    }
+
     static const f32 boardSize = (f32) app->refScreenHeight - 100.0f;
-    static const f32 cellSize  = boardSize / 3.0f;
+
+    const int rows    = GetRows();
+    const int columns = GetColumns();
 
     static Vec4 playerColors[] = {
         { 1.0f, 0.7f, 0.7f, 1.0f }, // Highlighted Cross
@@ -134,8 +577,56 @@ void Game::Render(Application* app)
     };
 
     {   // Title
-        std::string title = "Tic Tac Toe";
-        Vec2 size = UI::GetRenderedTextSize(title, font);
+        std::string title = variantNames[(int) variant];
+        if (variant == Variant::UNBOUNDED)
+        {   // Where the view is, it can be a long way out
+            char buffer[64];
+            sprintf(buffer, "%s (%d, %d)", variantNames[(int) variant],
+                    (int) floorf(camera.center.x), (int) floorf(camera.center.y));
+            title = buffer;
+        }
+        else if (online)
+        {
+            NetStatus status = net.status;
+            if (status == NetStatus::FAILED)
+                title = "Can't connect";
+            else if (status == NetStatus::CONNECTING)
+                title = "Connecting...";
+            else if (netMatch == 0)
+                title = "Finding opponent...";
+            else
+                title = netPlayer == 0 ? "Online, you're X" : "Online, you're O";
+        }
+        else if (replaying)
+        {
+            char buffer[64];
+            sprintf(buffer, "Game %llu/%llu, move %d/%d", replayGame + 1, replayLog.numGames,
+                    replayMove, (int) replay.game.moves.size());
+            title = buffer;
+        }
+        else if (match.timed && variant == Variant::TIC_TAC_TOE)
+        {   // Both clocks, the one that's running marked
+            f64 now = GetMonotonicTime();
+            char sides[2][24];
+
+            for (int side = 0; side < 2; side++)
+            {
+                f64 left = match.clock.GetRemaining(side, now);
+                left = left > 0.0 ? left : 0.0;
+                sprintf(sides[side], "%s%c %d:%04.1f", match.clock.running == side ? ">" : "",
+                        side == 0 ? 'X' : 'O', (int) (left / 60.0), fmod(left, 60.0));
+            }
+
+            title = std::string(sides[0]) + "   " + sides[1];
+        }
+        else if (inPuzzle)
+        {
+            char buffer[48];
+            sprintf(buffer, "Puzzle %d/%d: Win in %d", puzzleIndex + 1,
+                    (int) puzzleSet.puzzles.size(), puzzleSet.puzzles[puzzleIndex].moves);
+            title = buffer;
+        }
+
         Vec2 position = { (app->refScreenWidth - boardSize) / 2.0f, 10.0f };
         UI::RenderText(app, title, font, { 1.0f, 1.0f, 1.0f, 1.0f },
                         position, 0.0f);
@@ -148,60 +639,158 @@ void Game::Render(Application* app)
             { 1.0f, 1.0f, 1.0f, 1.0f }, // Empty
         };
 
-        f32 xOffset = (app->refScreenWidth - boardSize) / 2.0f;
-        f32 yOffset = 50.0f;
+        bool bounded = variant != Variant::UNBOUNDED;
+        int player = GetPlayerToMove();
 
-        for (int i = 0; i < 3; i++)
-            for (int j = 0; j < 3; j++)
+        // Everything below only looks at the cells inside the viewport,
+        // however big the board is
+        s32 minX, minY, maxX, maxY;
+        camera.GetVisibleCells(minX, minY, maxX, maxY);
+
+        if (bounded)
+        {
+            minX = minX < 0 ? 0 : minX;
+            minY = minY < 0 ? 0 : minY;
+            maxX = maxX > columns - 1 ? columns - 1 : maxX;
+            maxY = maxY > rows - 1 ? rows - 1 : maxY;
+        }
+
+        auto cellRect = [&](s32 x, s32 y)
+        {
+            UI::Rect r;
+            r.topLeft = camera.CellToScreen((f32) x, (f32) (y + 1));
+            r.size    = { camera.cellSize, camera.cellSize };
+            return r;
+        };
+
+        UI::SetClipRect(app, camera.viewport);
+
+        if (minX <= maxX && minY <= maxY)
+        {   // Background, one rect for all the visible cells
+            UI::Rect r;
+            r.topLeft = camera.CellToScreen((f32) minX, (f32) (maxY + 1));
+            r.size    = camera.CellToScreen((f32) (maxX + 1), (f32) minY) - r.topLeft;
+            UI::RenderRect(app, r, colors[(int) CellElement::EMPTY], 0.0f);
+        }
+
+        if (!bounded)
+        {   // Grid lines, nothing else shows where the cells are
+            f32 width = camera.cellSize > 24.0f ? 2.0f : 1.0f;
+            Vec4 lineColor = { 0.8f, 0.8f, 0.8f, 1.0f };
+
+            for (s32 x = minX; x <= maxX + 1; x++)
             {
-                f32 y = (f32) app->refScreenHeight - ((f32) (i + 1)) * cellSize - yOffset;
-                f32 x = j * cellSize + xOffset;
+                UI::Rect r;
+                r.topLeft = camera.CellToScreen((f32) x, (f32) (maxY + 1)) - Vec2 { width / 2.0f, 0.0f };
+                r.size    = { width, (maxY - minY + 1) * camera.cellSize };
+                UI::RenderRect(app, r, lineColor, -0.002f);
+            }
 
+            for (s32 y = minY; y <= maxY + 1; y++)
+            {
                 UI::Rect r;
-                r.topLeft = { x, y };
-                r.size    = { cellSize, cellSize };
+                r.topLeft = camera.CellToScreen((f32) minX, (f32) y) - Vec2 { 0.0f, width / 2.0f };
+                r.size    = { (maxX - minX + 1) * camera.cellSize, width };
+                UI::RenderRect(app, r, lineColor, -0.002f);
+            }
+        }
 
-                if (!pauseData.isPaused && board[i * 3 + j] == CellElement::EMPTY)
+        s32 hintDepth = showHints && variant == Variant::TIC_TAC_TOE ? analysis.GetScores(match.board, hintScores) : 0;
+        if (hintDepth > 0 && !pause.isPaused)
+        {
+            for (s32 y = minY; y <= maxY; y++)
+                for (s32 x = minX; x <= maxX; x++)
                 {
-                    Vec4 color = colors[(int) board[i * 3 + j]];
-                    if (vsComputer && playerIndex == 1)
-                    {
-                        UI::RenderRect(app, r, color, 0.0f);
-                    }
-                    else if (UI::RenderButton(app, GenUIIDWithSec(i * 3 + j), r,
-                                             color, playerColors[playerIndex], colors[playerIndex],
-                                             0.0f))
-                    {
-                        PlaceElement(i * 3 + j);
-                    }
+                    if (CanPlaceAt(x, y))
+                        UI::RenderRect(app, cellRect(x, y), HintColor(hintScores[y * columns + x]), -0.001f);
                 }
-                else
+        }
+
+        {   // The cell under the mouse is worked out from its position
+            // instead of every cell checking whether it's hovered
+            Vec2 mouse = { (f32) app->mouseX, (f32) app->mouseY };
+            bool humanTurn = online ? IsOnlineTurn() : !(vsComputer && player == computerIndex);
+
+            if (!pause.isPaused && !replaying && humanTurn && camera.Contains(mouse))
+            {
+                Vec2 grid = camera.ScreenToGrid(mouse);
+                s32 x = (s32) floorf(grid.x);
+                s32 y = (s32) floorf(grid.y);
+                bool onBoard = !bounded || (x >= 0 && x < columns && y >= 0 && y < rows);
+                bool clicked = app->GetMouseButtonDown(MOUSE(1));
+
+                if (onBoard && CanPlaceAt(x, y))
                 {
-                    UI::RenderRect(app, r, { 1.0f, 1.0f, 1.0f, 1.0f }, 0.0f);
+                    Vec4 color = app->GetMouseButton(MOUSE(1)) ? colors[player] : playerColors[player];
+                    UI::RenderRect(app, cellRect(x, y), color, -0.0015f);
+
+                    if (clicked)
+                        PlaceAt(x, y);
                 }
             }
+        }
 
         // @Todo: Inefficient and clunky
         {   // Draw all sprites
-            for (int i = 0; i < 9; i++)
+            auto drawPiece = [&](s32 x, s32 y, CellElement cell)
             {
-                if (board[i] != CellElement::EMPTY)
-                {
-                    atlas.Bind(0);
+                atlas.Bind(0);
 
-                    spriteShader.Bind();
-                    spriteShader.SetUniform1i("u_atlas", 0);
+                spriteShader.Bind();
+                spriteShader.SetUniform1i("u_atlas", 0);
 
-                    f32 scale = cellSize / (f32) atlas.height;
-                    f32 x = 2.0f * ((i % 3) - 1) * cellSize / app->refScreenWidth;
-                    f32 y = 2.0f * ((i / 3) - 1) * cellSize / app->refScreenHeight;
-                    Mat4 mat = Mat4::Scaling({ scale, scale, 1.0f }).Translate({ x, y, -0.01f });
-                    spriteShader.SetUniformMat4("u_mat", false, mat);
+                Vec2 middle = camera.CellToScreen(x + 0.5f, y + 0.5f);
+                f32 scale = camera.cellSize / (f32) atlas.height;
+                f32 ndcX = 2.0f * middle.x / app->refScreenWidth - 1.0f;
+                f32 ndcY = 1.0f - 2.0f * middle.y / app->refScreenHeight;
+                Mat4 mat = Mat4::Scaling({ scale, scale, 1.0f }).Translate({ ndcX, ndcY, -0.01f });
+                spriteShader.SetUniformMat4("u_mat", false, mat);
 
-                    sprites[(int) board[i]].Draw();
-                }
+                sprites[(int) cell].Draw();
+            };
+
+            if (variant == Variant::UNBOUNDED)
+            {
+                // Only the chunks on screen get looked at
+                visibleElements.clear();
+                infiniteBoard.GetElementsIn(minX, minY, maxX, maxY, visibleElements);
+
+                for (const InfiniteElement& element : visibleElements)
+                    drawPiece(element.x, element.y, element.element);
+            }
+            else
+            {
+                for (s32 y = minY; y <= maxY; y++)
+                    for (s32 x = minX; x <= maxX; x++)
+                    {
+                        CellElement cell = GetCell(x, y);
+                        if (cell != CellElement::EMPTY)
+                            drawPiece(x, y, cell);
+                    }
             }
         }
+
+        UI::ClearClipRect();
+    }
+
+    if (online && showNetStats)
+    {   // Debug overlay, F3 toggles it
+        char lines[3][32];
+        sprintf(lines[0], "rtt  %5.1f ms", (f64) net.lastRoundTrip);
+        sprintf(lines[1], "draw %5.1f ms", inputToDisplay);
+        sprintf(lines[2], "ack  %5.1f ms", inputToConfirmed);
+
+        Vec2 position = camera.viewport.topLeft + Vec2 { 5.0f, 5.0f };
+        UI::Rect rect;
+        rect.topLeft = camera.viewport.topLeft;
+        rect.size = { UI::GetRenderedTextSize(lines[0], font).x + 10.0f, 3.0f * font.fontHeight + 10.0f };
+        UI::RenderRect(app, rect, { 0.0f, 0.0f, 0.0f, 0.6f }, -0.015f);
+
+        for (int i = 0; i < 3; i++)
+        {
+            UI::RenderText(app, lines[i], font, { 1.0f, 1.0f, 1.0f, 1.0f }, position, -0.016f);
+            position.y += font.fontHeight;
+        }
     }
 
     {   // Player Scores
@@ -221,6 +810,59 @@ void Game::Render(Application* app)
         }
     }
 
+    if (replaying)
+    {   // Scrubbing, a slider for the game under the title and one for the move
+        // above the buttons, which step through moves and games
+        UI::Rect gameRect;
+        gameRect.topLeft = { (app->refScreenWidth - boardSize) / 2.0f, 38.0f };
+        gameRect.size    = { boardSize, 10.0f };
+
+        f32 gameValue = replayLog.numGames > 1 ? (f32) replayGame / (f32) (replayLog.numGames - 1) : 0.0f;
+        if (UI::RenderSlider(app, GenUIID(), gameRect, gameValue, 0.0f))
+        {
+            u64 game = (u64) (gameValue * (replayLog.numGames - 1) + 0.5f);
+            if (game != replayGame)
+                ShowReplay(game, 0);
+        }
+
+        UI::Rect moveRect;
+        moveRect.topLeft = { (app->refScreenWidth - boardSize) / 2.0f, app->refScreenHeight - 47.0f };
+        moveRect.size    = { boardSize, 10.0f };
+
+        s32 numMoves = (s32) replay.game.moves.size();
+        f32 moveValue = numMoves > 0 ? (f32) replayMove / (f32) numMoves : 0.0f;
+        if (UI::RenderSlider(app, GenUIID(), moveRect, moveValue, 0.0f))
+            ShowReplay(replayGame, (s32) (moveValue * numMoves + 0.5f));
+
+        const char* labels[] = { "<<", "<", ">", ">>", "Menu" };
+        const int numButtons = sizeof(labels) / sizeof(labels[0]);
+
+        f32 totalWidth = -10.0f;
+        for (int i = 0; i < numButtons; i++)
+            totalWidth += UI::GetRenderedTextSize(labels[i], font).x + 30.0f;
+
+        Vec2 topLeft = { (app->refScreenWidth - totalWidth) / 2.0f, app->refScreenHeight - 33.0f };
+        for (int i = 0; i < numButtons; i++)
+        {
+            if (UI::RenderTextButton(app, GenUIIDWithSec(i), labels[i], font,
+                                     { 10.0f, 5.0f }, topLeft, 0.0f))
+            {
+                if (i == 0 && replayGame > 0)
+                    ShowReplay(replayGame - 1, 0);
+                else if (i == 1)
+                    ShowReplay(replayGame, replayMove - 1);
+                else if (i == 2)
+                    ShowReplay(replayGame, replayMove + 1);
+                else if (i == 3 && replayGame + 1 < replayLog.numGames)
+                    ShowReplay(replayGame + 1, 0);
+                else if (i == 4)
+                    StopReplays();
+            }
+
+            topLeft.x += UI::GetRenderedTextSize(labels[i], font).x + 30.0f;
+        }
+    }
+    else
     {   // Bottom
 
         std::string resetBtnText = "Reset";
@@ -245,26 +887,27 @@ void Game::Render(Application* app)
             if (UI::RenderTextButton(app, GenUIID(), menuBtnText, font,
                                      { 10.0f, 5.0f }, topLeft, 0.0f))
             {
-                pauseData.inMainMenu = true;
+                LeaveOnline();
+                pause.inMainMenu = true;
             }
         }
     }
 
     {
-        if (pauseData.isPaused)
+        if (pause.isPaused)
         {
             f32 y = (f32) app->refScreenHeight - boardSize - 50.0f;
             f32 x = (app->refScreenWidth - boardSize) / 2.0f;
 
             UI::Rect rect;
             rect.topLeft = { x, y };
-            rect.size = { 3 * cellSize, 3 * cellSize };
+            rect.size = { boardSize, boardSize };
             UI::RenderRect(app, rect, { 0.0f, 0.0f, 0.0f, 0.7f }, -0.02f);
 
             {   // Pause Text
-                Vec2 textSize = UI::GetRenderedTextSize(pauseData.text, font);
+                Vec2 textSize = UI::GetRenderedTextSize(pause.text, font);
                 Vec2 textTopLeft = rect.topLeft + Vec2 { (boardSize - textSize.x) / 2.0f, (boardSize - textSize.y) / 2.0f };
-                UI::RenderText(app, pauseData.text, font, { 1.0f, 1.0f, 1.0f, 1.0f }, textTopLeft, -0.03f);
+                UI::RenderText(app, pause.text, font, { 1.0f, 1.0f, 1.0f, 1.0f }, textTopLeft, -0.03f);
             }
 
             { // Continue Button
@@ -281,86 +924,496 @@ void Game::Render(Application* app)
     }
 }
 
-void Game::PlaceElement(int index)
+// Every board in one instanced draw and every piece in another, the
+// number of draw calls doesn't depend on how many games are up
+void Game::RenderGrid(Application* app)
 {
-    if (board[index] == CellElement::EMPTY)
-    {
-        board[index] = (CellElement) playerIndex;
-        
-        if (PlayerWon())
+    static const f32 boardSize = (f32) app->refScreenHeight - 100.0f;
+
+    static Vec4 resultColors[] = {
+        { 1.0f, 1.0f, 1.0f, 1.0f }, // Playing
+        { 1.0f, 0.7f, 0.7f, 1.0f }, // Cross won
+        { 0.7f, 0.7f, 1.0f, 1.0f }, // Circle won
+        { 0.7f, 0.7f, 0.7f, 1.0f }, // Draw
+    };
+
+    u64 finished = monitor.Copy(gridCells, gridResults);
+    int side = watchSizes[watchSetting];
+    int size = match.board.size;
+
+    {   // Title
+        char buffer[48];
+        sprintf(buffer, "%d games, %llu finished", monitor.numGames, finished);
+        Vec2 position = { (app->refScreenWidth - boardSize) / 2.0f, 10.0f };
+        UI::RenderText(app, buffer, font, { 1.0f, 1.0f, 1.0f, 1.0f }, position, 0.0f);
+    }
+
+    {   // Boards with a gap between them, tinted once they're over
+        Vec2 topLeft = { (app->refScreenWidth - boardSize) / 2.0f, 50.0f };
+        f32 tile = boardSize / side;
+        f32 gap = tile * 0.08f > 1.0f ? tile * 0.08f : 1.0f;
+        f32 cellSize = (tile - gap) / size;
+
+        gridBoards.Clear();
+        gridPieces.Clear();
+
+        for (int game = 0; game < monitor.numGames; game++)
         {
-            char buffer[32];
-            sprintf(buffer, "Player %d Wins!", playerIndex + 1);
-            pauseData.text     = buffer;
-            pauseData.isPaused = pauseData.isEndScreen = true;
-            playerScores[playerIndex]++;
+            UI::Rect board;
+            board.topLeft = topLeft + Vec2 { (game % side) * tile + gap / 2.0f, (game / side) * tile + gap / 2.0f };
+            board.size    = { tile - gap, tile - gap };
+            gridBoards.AddRect(app, board, resultColors[(int) gridResults[game]]);
+
+            const CellElement* cells = &gridCells[game * monitor.numCells];
+            for (int i = 0; i < monitor.numCells; i++)
+            {
+                if (cells[i] == CellElement::EMPTY)
+                    continue;
+
+                // Rows count from the bottom like the big board
+                UI::Rect cell;
+                cell.topLeft = board.topLeft + Vec2 { (i % size) * cellSize, (size - 1 - i / size) * cellSize };
+                cell.size    = { cellSize, cellSize };
+                gridPieces.AddSprite(app, cell, sprites[(int) cells[i]]);
+            }
         }
-        else if (IsDraw())
-        {
-            pauseData.text     = "Draw...";
-            pauseData.isPaused = pauseData.isEndScreen = true;
+
+        gridBoards.Draw(nullptr, 0.0f);
+        gridPieces.Draw(&atlas, -0.01f);
+    }
+
+    {   // Bottom, how many games and back to the menu
+
+        char gamesText[24];
+        snprintf(gamesText, sizeof(gamesText), "Games: %d", side * side);
+        std::string menuBtnText = "Menu";
+
+        Vec2 gamesBtnSize = UI::GetRenderedTextSize(gamesText, font) + Vec2 { 20.0f, 10.0f };
+        Vec2 menuBtnSize = UI::GetRenderedTextSize(menuBtnText, font) + Vec2 { 20.0f, 10.0f };
+
+        Vec2 totalSize { gamesBtnSize.x + menuBtnSize.x + 10.0f, gamesBtnSize.y };
+
+        {   // Games button, cycles through the grid sizes
+            Vec2 topLeft = { ((app->refScreenWidth - totalSize.x) / 2.0f), app->refScreenHeight - 50.0f + (gamesBtnSize.y / 2.0f) };
+            if (UI::RenderTextButton(app, GenUIID(), gamesText, font,
+                                     { 10.0f, 5.0f }, topLeft, 0.0f))
+            {
+                watchSetting = (watchSetting + 1) % NUM_WATCH_SETTINGS;
+                StartWatching();
+            }
+        }
+
+        {   // Menu button
+            Vec2 topLeft = { ((app->refScreenWidth - totalSize.x) / 2.0f) + gamesBtnSize.x + 10.0f, app->refScreenHeight - 50.0f + (menuBtnSize.y / 2.0f) };
+            if (UI::RenderTextButton(app, GenUIID(), menuBtnText, font,
+                                     { 10.0f, 5.0f }, topLeft, 0.0f))
+            {
+                StopWatching();
+            }
         }
+    }
+}
+
+int Game::GetRows()
+{
+    if (variant == Variant::CONNECT_FOUR)
+        return ConnectFour::HEIGHT;
+    if (variant == Variant::UNBOUNDED)
+        return 0;
+
+    return match.board.size;
+}
+
+int Game::GetColumns()
+{
+    if (variant == Variant::CONNECT_FOUR)
+        return ConnectFour::WIDTH;
+    if (variant == Variant::UNBOUNDED)
+        return 0;
+
+    return match.board.size;
+}
+
+CellElement Game::GetCell(int x, int y)
+{
+    if (variant == Variant::CONNECT_FOUR)
+        return connectFour.GetCell(y, x);
+    if (variant == Variant::UNBOUNDED)
+        return infiniteBoard.GetCell(x, y);
+
+    return match.board.cells[y * match.board.size + x];
+}
+
+// Discs can only go on top of a column, that's the cell that lights up
+bool Game::CanPlaceAt(int x, int y)
+{
+    if (variant == Variant::CONNECT_FOUR)
+        return connectFour.CanPlay(x) && connectFour.LandingRow(x) == y;
+
+    return GetCell(x, y) == CellElement::EMPTY;
+}
+
+void Game::PlaceAt(int x, int y)
+{
+    if (variant == Variant::CONNECT_FOUR)
+        DropDisc(x);
+    else if (variant == Variant::UNBOUNDED)
+        PlaceStone(x, y);
+    else if (online)
+        PlaceOnline(y * match.board.size + x);
+    else
+        PlaceElement(y * match.board.size + x);
+}
+
+int Game::GetPlayerToMove()
+{
+    if (variant == Variant::CONNECT_FOUR)
+        return connectFour.playerIndex;
+    if (variant == Variant::UNBOUNDED)
+        return infiniteBoard.playerIndex;
+
+    return match.board.playerIndex;
+}
+
+// winner is -1 for a draw
+void Game::FinishRound(int winner)
+{
+    if (winner >= 0)
+    {
+        char buffer[32];
+        sprintf(buffer, "Player %d Wins!", winner + 1);
+        pause.text = buffer;
+        playerScores[winner]++;
+    }
+    else
+    {
+        pause.text = "Draw...";
+    }
+
+    if (online)
+        pause.text = winner < 0 ? "Draw..." : (winner == netPlayer ? "You Win!" : "You Lose...");
+
+    // Puzzles start part way through, there's no whole game to keep
+    if (variant == Variant::TIC_TAC_TOE && !inPuzzle)
+        SaveRecording();
+
+    pause.isPaused = pause.isEndScreen = true;
+}
 
-        playerIndex = 1 - playerIndex;
+void Game::StartRecording()
+{
+    record.size        = match.board.size;
+    record.winLength   = match.board.winLength;
+    record.firstPlayer = match.board.playerIndex;
+    record.moves.clear();
+}
+
+void Game::SaveRecording()
+{
+    record.status = match.status;
+    replayLog.Append(record);
+}
+
+void Game::PlaceElement(int index)
+{
+    int player = match.board.playerIndex;
+    if (!match.Play(index))
+    {
+        // Clicked after the flag fell
+        if (match.timed && match.IsOver())
+            FinishOnTime();
+
+        return;
+    }
+
+    record.moves.push_back((u16) index);
+
+    if (match.status == MatchStatus::CROSS_WON || match.status == MatchStatus::CIRCLE_WON)
+    {
+        FinishRound(player);
+
+        if (inPuzzle)
+        {
+            puzzleSolved = player != computerIndex;
+            pause.text = puzzleSolved ? "Solved!" : "Failed, try again...";
+        }
+    }
+    else if (match.status == MatchStatus::DRAW)
+    {
+        FinishRound(-1);
     }
+    else if (inPuzzle && player != computerIndex && --puzzleMovesLeft == 0)
+    {   // Out of moves, a win after this doesn't count
+        pause.text     = "Too slow, try again...";
+        pause.isPaused = pause.isEndScreen = true;
+    }
+}
+
+void Game::FinishOnTime()
+{
+    int loser = match.clock.flagged;
+    FinishRound(1 - loser);
+
+    char buffer[40];
+    sprintf(buffer, "Player %d Ran Out of Time", loser + 1);
+    pause.text = buffer;
 }
 
 void Game::PlaceElementComp()
 {
-    // A random number is generated and
-    // for selecting the index, if the index isn't
-    // empty then the board linearly probed for the next index;
+    PonderState state = ponderer.Check(match.board);
 
-    int startIndex = rand() % 9;
-    int index = startIndex;
-    while (board[index] != CellElement::EMPTY)
+    // Already searching this exact position, the result comes in a few frames.
+    // On the clock that's only worth waiting for as long as a search would get.
+    if (state == PonderState::PENDING)
     {
-        index = (index + 1) % 9;
-        if (index == startIndex)
-            break;
+        const GameClock& clock = match.clock;
+        s32 movesLeft = (match.board.numCells - match.board.moveCount + 1) / 2;
+        if (!match.timed || GetMonotonicTime() - clock.turnStart < clock.GetBudget(clock.turnStart, movesLeft))
+            return;
+
+        ponderer.Stop();
     }
 
-    PlaceElement(index);
+    if (state == PonderState::HIT)
+    {
+        PlaceElement(ponderer.move);
+        return;
+    }
+
+    // Cleared like the ponderer's so a move never depends on earlier searches
+    table.Clear();
+    PlaceElement(computer.ChooseMove(match, searcher, random));
 }
 
-bool Game::IsDraw()
+void Game::DropDisc(int column)
 {
-    for (int i = 0; i < 9; i++)
+    if (!connectFour.CanPlay(column))
+        return;
+
+    int player = connectFour.playerIndex;
+    connectFour.Play(column);
+
+    if (connectFour.LastMoveWon())
+        FinishRound(player);
+    else if (connectFour.IsFull())
+        FinishRound(-1);
+}
+
+void Game::DropDiscComp()
+{
+    // The middle column is the only winning first move, and proving
+    // that from scratch takes far longer than anyone would wait
+    if (connectFour.moveCount == 0)
     {
-        if (board[i] == CellElement::EMPTY)
-            return false;
+        DropDisc(ConnectFour::WIDTH / 2);
+        return;
     }
 
-    return true;
+    connectFourSolver.nodeLimit = connectFourNodes[level];
+    DropDisc(connectFourSolver.BestMove(connectFour));
 }
 
-bool Game::PlayerWon()
+void Game::PlaceStone(int x, int y)
 {
-    static const int winLines[8][3] = {
-        // Horizontal
-        { 0, 1, 2 },
-        { 3, 4, 5 },
-        { 6, 7, 8 },
+    int player = infiniteBoard.playerIndex;
+    if (!infiniteBoard.MakeMove(x, y))
+        return;
 
-        // Vertical
-        { 0, 3, 6 },
-        { 1, 4, 7 },
-        { 2, 5, 8 },
+    // No draws, there's always another cell
+    if (infiniteBoard.WonThrough(x, y))
+        FinishRound(player);
+}
 
-        // Diagonal
-        { 0, 4, 8 },
-        { 2, 4, 6 },
-    };
+void Game::PlaceStoneComp()
+{
+    // The search only knows boards with edges, so it plays on a window
+    // around the last move. Anything outside that doesn't exist to it.
+    int centerX = 0, centerY = 0;
+    if (!infiniteBoard.moves.empty())
+    {
+        centerX = infiniteBoard.moves.back().x;
+        centerY = infiniteBoard.moves.back().y;
+    }
+
+    int left = centerX - window.size / 2;
+    int bottom = centerY - window.size / 2;
+
+    std::vector<CellElement> layout(window.numCells, CellElement::EMPTY);
+    visibleElements.clear();
+    infiniteBoard.GetElementsIn(left, bottom, left + window.size - 1, bottom + window.size - 1, visibleElements);
+    for (const InfiniteElement& element : visibleElements)
+        layout[(element.y - bottom) * window.size + element.x - left] = element.element;
+
+    window.SetPosition(layout.data(), infiniteBoard.playerIndex);
+
+    table.Clear();
+    int move = computer.ChooseMove(window, searcher, random);
+    int x = left + move % window.size;
+    int y = bottom + move / window.size;
+
+    PlaceStone(x, y);
+
+    // Keep the reply on screen
+    s32 minX, minY, maxX, maxY;
+    camera.GetVisibleCells(minX, minY, maxX, maxY);
+    if (x <= minX || x >= maxX || y <= minY || y >= maxY)
+        camera.center = { x + 0.5f, y + 0.5f };
+}
+
+void Game::StartOnline()
+{
+    vsComputer = false;
+    inPuzzle = false;
+    online = true;
+    pause.inMainMenu = false;
+
+    if (net.status != NetStatus::CONNECTED)
+        net.Connect(serverHost.c_str(), serverPort);
 
-    CellElement currElem = (CellElement) playerIndex;
+    // Reset asks the server for a game
+    Reset();
+}
 
-    for (int i = 0; i < 8; i++)
+void Game::LeaveOnline()
+{
+    if (!online)
+        return;
+
+    online = false;
+    netMatch = 0;
+    pendingMove = -1;
+    net.Disconnect();
+}
+
+void Game::NewOnlineGame()
+{
+    // Giving up on the last one if it's still going
+    if (netMatch != 0 && confirmed.status == MatchStatus::PLAYING)
     {
-        if (board[winLines[i][0]] == currElem &&
-            board[winLines[i][1]] == currElem &&
-            board[winLines[i][2]] == currElem)
-            return true;
+        Message resign = {};
+        resign.type  = MessageType::RESIGN;
+        resign.match = netMatch;
+        net.Send(resign);
     }
 
-    return false;
+    netMatch = 0;
+    pendingMove = -1;
+    match.Start(match.board.size, match.board.winLength);
+    confirmed = match;
+    StartRecording();
+
+    Message message = {};
+    message.type      = MessageType::NEW_GAME;
+    message.size      = (u8) match.board.size;
+    message.winLength = (u8) match.board.winLength;
+    message.level     = HUMAN_OPPONENT;
+    message.player    = 0;
+    net.Send(message);
+}
+
+bool Game::IsOnlineTurn()
+{
+    return netMatch != 0 && pendingMove < 0 && match.status == MatchStatus::PLAYING &&
+           match.board.playerIndex == netPlayer;
+}
+
+// Shows the move straight away, the server gets to say whether it stands
+void Game::PlaceOnline(int index)
+{
+    if (!IsOnlineTurn() || !match.Play(index))
+        return;
+
+    pendingMove = index;
+    pendingInputTime = frameInputTime;
+    timingDisplay = true;
+
+    Message message = {};
+    message.type       = MessageType::PLACE;
+    message.match      = netMatch;
+    message.moveNumber = (u16) (match.board.moveCount - 1);
+    message.cell       = (u16) index;
+    net.Send(message);
+}
+
+// Never waits, whatever the network thread has picked up gets handled
+// and the rest comes on a later frame
+void Game::UpdateNetwork(Application* app)
+{
+    if (!online)
+        return;
+
+    // The frame drawn last was the first to show what the input did
+    frameInputTime = app->inputTime;
+    if (timingDisplay)
+    {
+        inputToDisplay = (app->presentTime - pendingInputTime) * 1000.0;
+        timingDisplay = false;
+    }
+    if (timingConfirmed)
+    {
+        inputToConfirmed = (app->presentTime - confirmedInputTime) * 1000.0;
+        timingConfirmed = false;
+    }
+
+    netMessages.clear();
+    net.Receive(netMessages);
+
+    for (const Message& message : netMessages)
+    {
+        if (message.type == MessageType::STARTED)
+        {
+            netMatch = message.match;
+            netPlayer = message.player;
+            match.Start(message.size, message.winLength);
+            confirmed = match;
+            pendingMove = -1;
+            StartRecording();
+            continue;
+        }
+
+        // Anything else about an older match is stale
+        if (message.match != netMatch)
+            continue;
+
+        if (message.type == MessageType::ERROR)
+        {   // Turned down, back to what the server has
+            match = confirmed;
+            pendingMove = -1;
+            continue;
+        }
+
+        if (message.type != MessageType::STATE)
+            continue;
+
+        if (message.cell != NO_CELL)
+        {
+            if (confirmed.Play(message.cell))
+                record.moves.push_back(message.cell);
+
+            if (pendingMove >= 0 && message.cell == pendingMove && message.moveNumber == confirmed.board.moveCount)
+            {
+                pendingMove = -1;
+                confirmedInputTime = pendingInputTime;
+                timingConfirmed = true;
+            }
+            else
+            {
+                match.Play(message.cell);
+            }
+        }
+
+        // Resigning or leaving ends it without a move
+        confirmed.status = (MatchStatus) message.status;
+        match.status = confirmed.status;
+
+        if (confirmed.status != MatchStatus::PLAYING && !pause.isEndScreen)
+        {
+            int winner = confirmed.status == MatchStatus::CROSS_WON ? 0 : (confirmed.status == MatchStatus::CIRCLE_WON ? 1 : -1);
+            FinishRound(winner);
+
+            if (message.cell == NO_CELL)
+                pause.text = "Opponent left";
+        }
+    }
 }
\ No newline at end of file
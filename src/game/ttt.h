@@ -1,15 +1,44 @@
 #pragma once
 
+#include <string>
 #include "platform/application.h"
 #include "engine/ui.h"
 #include "engine/shader.h"
 #include "engine/sprite.h"
+#include "engine/camera.h"
+#include "engine/batch.h"
+#include "board.h"
+#include "match.h"
+#include "clock.h"
+#include "nnue.h"
+#include "player.h"
+#include "ponder.h"
+#include "analysis.h"
+#include "puzzle.h"
+#include "connect4.h"
+#include "infinite.h"
+#include "monitor.h"
+#include "replay.h"
+#include "search.h"
+#include "universal/random.h"
+#include "net/client.h"
 
-enum class CellElement
+enum class Variant
 {
-    CROSS,
-    CIRCLE,
-    EMPTY,
+    TIC_TAC_TOE,
+    CONNECT_FOUR,
+    UNBOUNDED,      // Gomoku on the infinite board
+
+    NUM_VARIANTS,
+};
+
+// What the pause and end screens show
+struct PauseState
+{
+    std::string text;
+    bool isPaused;
+    bool isEndScreen;
+    bool inMainMenu;
 };
 
 struct Game
@@ -18,25 +47,126 @@ struct Game
     SpriteAtlas atlas;
     Sprite sprites[2];
     Shader spriteShader;
+    Camera camera;
+    PauseState pause;
 
-    CellElement board[9];
+    Variant variant;
+    Match match;
+    ConnectFour connectFour;
+    ConnectFourSolver connectFourSolver;
+    InfiniteBoard infiniteBoard;
+    Board window;                   // What the computer sees of infiniteBoard
+    std::vector<InfiniteElement> visibleElements;
+    Network network;
+    ComputerPlayer computer;
+    Searcher searcher;
+    TranspositionTable table;
+    Ponderer ponderer;
+    Analysis analysis;
+    std::vector<s32> hintScores;
+    bool showHints;
+    Random random;
     int playerScores[2];
-    int playerIndex;
     bool vsComputer;
+    int computerIndex;
+    int level;
+    int clockSetting;
+    TimeControl timeControl;
+
+    PuzzleSet puzzleSet;
+    bool inPuzzle;
+    bool puzzleSolved;
+    int puzzleIndex;
+    int puzzleMovesLeft;
+
+    // Online games against another player through "tttcli server". Moves
+    // show up as soon as they're clicked and the server confirms them later.
+    NetClient net;
+    std::string serverHost;
+    u16 serverPort;
+    std::vector<Message> netMessages;
+    bool online;
+    u32 netMatch;                   // 0 while waiting for an opponent
+    int netPlayer;
+    Match confirmed;                // The match as the server last said it was
+    s32 pendingMove;                // Placed but not confirmed, -1 if none
+    f64 pendingInputTime;           // When the click that placed it was polled
+    f64 confirmedInputTime;
+    f64 frameInputTime;
+    bool timingDisplay;
+    bool timingConfirmed;
+
+    // Watch view, a grid of computer games drawn with one instanced draw
+    // for the boards and one for the pieces however many there are
+    bool watching;
+    int watchSetting;
+    GameMonitor monitor;
+    QuadBatch gridBoards;
+    QuadBatch gridPieces;
+    std::vector<CellElement> gridCells;
+    std::vector<MatchStatus> gridResults;
+
+    // Every finished Tic Tac Toe game goes in the replay log. Replays in
+    // the menu steps through them, drawn by Render like a live game.
+    ReplayLog replayLog;
+    ReplayGame record;              // The game being played, moves so far
+    ReplayCursor replay;
+    bool replaying;
+    u64 replayGame;
+    s32 replayMove;
+
+    // Debug overlay, milliseconds
+    bool showNetStats;
+    f64 inputToDisplay;
+    f64 inputToConfirmed;
 
     void Init(Application* app);
     void Reset();
     void NextRound();
+    void StartClock();
+    void SetLevel(int value);
+    void ToggleHints();
+    void StartPuzzle(int index);
+    void SetVariant(Variant value);
+    void FitCamera();
+    void UpdateCamera(Application* app);
+    void UpdateNetwork(Application* app);
+    void StartOnline();
+    void NewOnlineGame();
+    void LeaveOnline();
+    bool IsOnlineTurn();
+    void StartRecording();
+    void SaveRecording();
+    void StartReplays();
+    void StopReplays();
+    void ShowReplay(u64 game, s32 move);
+    void UpdateReplay(Application* app);
+    void StartWatching();
+    void StopWatching();
     bool IsPaused();
     void SetPause(bool value);
 
-    bool IsDraw();
-    bool PlayerWon();
-
     void Update();
     void Render(Application* app);
+    void RenderGrid(Application* app);
     void DrawCell(Application* app, int i, int j);
 
+    // The board as Render sees it, x is the column and y the row
+    // counting from the bottom. Rows and columns are 0 when unbounded.
+    int GetRows();
+    int GetColumns();
+    CellElement GetCell(int x, int y);
+    bool CanPlaceAt(int x, int y);
+    void PlaceAt(int x, int y);
+    int GetPlayerToMove();
+
+    void FinishRound(int winner);
+    void FinishOnTime();
     void PlaceElement(int index);
     void PlaceElementComp();
+    void PlaceOnline(int index);
+    void DropDisc(int column);
+    void DropDiscComp();
+    void PlaceStone(int x, int y);
+    void PlaceStoneComp();
 };
\ No newline at end of file
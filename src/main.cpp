@@ -5,8 +5,12 @@
 
 Game game;
 
-int main(void)
+int main(int argc, const char* argv[])
 {
+    CL_Args args = ParseCommandLineArguments(argc, argv);
+    game.serverHost = args.host;
+    game.serverPort = (u16) args.port;
+
     Application app("Tic Tac Toe", 400, 400, false, false);
     app.SetWindowIcon("res/icons/icon.png");
     app.SetVsync(true);
@@ -21,6 +25,16 @@ int main(void)
         if (app->GetKeyDown(KEY(ESCAPE)))
             game.SetPause(!game.IsPaused());
 
+        if (app->GetKeyDown(KEY(H)))
+            game.ToggleHints();
+
+        if (app->GetKeyDown(KEY(F3)))
+            game.showNetStats = !game.showNetStats;
+
+        game.UpdateCamera(app);
+        game.UpdateNetwork(app);
+        game.UpdateReplay(app);
+
         game.Update();
     };
 
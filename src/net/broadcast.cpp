@@ -0,0 +1,93 @@
+#include "broadcast.h"
+
+#include <cstring>
+#include <vector>
+#include "universal/types.h"
+#include "game/board.h"
+#include "game/match.h"
+#include "protocol.h"
+
+void SpectatorRing::Init(size_t capacity)
+{
+    data.resize(capacity);
+    start = 0;
+    used = 0;
+}
+
+void SpectatorRing::Free()
+{
+    data.clear();
+    data.shrink_to_fit();
+    start = 0;
+    used = 0;
+}
+
+bool SpectatorRing::Push(const u8 bytes[], size_t size)
+{
+    if (size > data.size() - used)
+        return false;
+
+    size_t end = (start + used) % data.size();
+    size_t first = size < data.size() - end ? size : data.size() - end;
+
+    memcpy(data.data() + end, bytes, first);
+    memcpy(data.data(), bytes + first, size - first);
+    used += size;
+    return true;
+}
+
+const u8* SpectatorRing::Peek(size_t& size) const
+{
+    size = used < data.size() - start ? used : data.size() - start;
+    return data.data() + start;
+}
+
+void SpectatorRing::Pop(size_t size)
+{
+    start = (start + size) % data.size();
+    used -= size;
+}
+
+void SpectatorFeed::Start(u32 id, const Match& match)
+{
+    const Board& board = match.board;
+
+    Message message = {};
+    message.type       = MessageType::BOARD;
+    message.match      = id;
+    message.size       = (u8) board.size;
+    message.winLength  = (u8) board.winLength;
+    message.moveNumber = (u16) board.moveCount;
+    message.cell       = match.lastMove >= 0 ? (u16) match.lastMove : NO_CELL;
+    message.status     = (u8) match.status;
+    message.player     = (u8) board.playerIndex;
+    PackCells(board.cells.data(), board.numCells, message.cells);
+
+    keyframe.clear();
+    EncodeMessage(message, keyframe);
+    deltas.clear();
+    numDeltas = 0;
+}
+
+void SpectatorFeed::AddMove(u32 id, const Match& match)
+{
+    Message message = {};
+    message.type       = MessageType::STATE;
+    message.match      = id;
+    message.moveNumber = (u16) match.board.moveCount;
+    message.cell       = match.lastMove >= 0 ? (u16) match.lastMove : NO_CELL;
+    message.status     = (u8) match.status;
+
+    latest.clear();
+    EncodeMessage(message, latest);
+
+    // Late joiners would otherwise get more and more moves to catch up on
+    if (numDeltas >= KEYFRAME_INTERVAL)
+    {
+        Start(id, match);
+        return;
+    }
+
+    deltas.insert(deltas.end(), latest.begin(), latest.end());
+    numDeltas++;
+}
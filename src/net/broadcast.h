@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "universal/types.h"
+#include "game/match.h"
+
+// Outgoing bytes for a spectating connection. It never grows, so a viewer
+// that stops reading can't make the server hold on to more and more. When
+// it's full the viewer is caught up from keyframes once it has drained.
+struct SpectatorRing
+{
+    std::vector<u8> data;
+    size_t start;
+    size_t used;
+
+    void Init(size_t capacity);
+    void Free();
+
+    // All of it or nothing, false if it doesn't fit
+    bool Push(const u8 bytes[], size_t size);
+
+    // The bytes at the front that are next to each other in memory
+    const u8* Peek(size_t& size) const;
+    void Pop(size_t size);
+};
+
+// What the spectators of one match are sent, encoded once however many of
+// them there are. A viewer joining late gets the keyframe and the moves
+// after it, never more than KEYFRAME_INTERVAL of them.
+struct SpectatorFeed
+{
+    static constexpr s32 KEYFRAME_INTERVAL = 16;
+
+    std::vector<u8> keyframe;   // BOARD frame
+    std::vector<u8> deltas;     // STATE frames since the keyframe
+    std::vector<u8> latest;     // STATE frame for the last move
+    s32 numDeltas;
+    std::vector<u32> watchers;
+
+    // Keyframe for where the match is now
+    void Start(u32 id, const Match& match);
+
+    // Encodes the move just made, or the end of the match, into latest
+    void AddMove(u32 id, const Match& match);
+};
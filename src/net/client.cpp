@@ -0,0 +1,192 @@
+#include "client.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "platform/socket.h"
+#include "protocol.h"
+
+static f64 Now()
+{
+    using namespace std::chrono;
+    return duration<f64>(steady_clock::now().time_since_epoch()).count();
+}
+
+NetClient::~NetClient()
+{
+    Disconnect();
+}
+
+void NetClient::Connect(const char serverHost[], u16 serverPort)
+{
+    Disconnect();
+
+    host = serverHost;
+    port = serverPort;
+    outgoing.clear();
+    incoming.clear();
+    lastRoundTrip = 0.0;
+    timedMatch = 0;
+
+    if (!InitSockets() || !MakeSocketPair(wakeSockets))
+    {
+        status = NetStatus::FAILED;
+        return;
+    }
+
+    SetNonBlocking(wakeSockets[0]);
+    SetNonBlocking(wakeSockets[1]);
+
+    stopping = false;
+    status = NetStatus::CONNECTING;
+    thread = std::thread([this]() { Run(); });
+}
+
+void NetClient::Disconnect()
+{
+    if (!thread.joinable())
+        return;
+
+    stopping = true;
+    u8 byte = 1;
+    SendSome(wakeSockets[1], &byte, 1);
+    thread.join();
+
+    CloseSocket(wakeSockets[0]);
+    CloseSocket(wakeSockets[1]);
+    status = NetStatus::OFFLINE;
+}
+
+void NetClient::Send(const Message& message)
+{
+    bool wasEmpty;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wasEmpty = outgoing.empty();
+        outgoing.push_back(message);
+    }
+
+    if (wasEmpty)
+    {
+        u8 byte = 1;
+        SendSome(wakeSockets[1], &byte, 1);
+    }
+}
+
+void NetClient::Receive(std::vector<Message>& messages)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    messages.insert(messages.end(), incoming.begin(), incoming.end());
+    incoming.clear();
+}
+
+void NetClient::Run()
+{
+    // Connecting blocks, which is why it happens here
+    socket = ConnectTcp(host.c_str(), port);
+    if (socket == NO_SOCKET)
+    {
+        status = NetStatus::FAILED;
+        return;
+    }
+
+    SetNonBlocking(socket);
+    SetNoDelay(socket);
+    status = NetStatus::CONNECTED;
+
+    Poller poller;
+    poller.Init();
+    poller.Add(socket, 0);
+    poller.Add(wakeSockets[0], 1);
+
+    std::vector<u8> in, out;
+    std::vector<Message> toSend;
+    PollEvent events[2];
+
+    while (!stopping)
+    {
+        s32 numEvents = poller.Wait(events, 2, 100);
+        bool broken = false;
+
+        for (s32 i = 0; i < numEvents; i++)
+        {
+            if (events[i].data == 1)
+            {
+                u8 drain[64];
+                while (RecvSome(wakeSockets[0], drain, sizeof(drain)) > 0);
+                continue;
+            }
+
+            u8 buffer[4096];
+            s32 received;
+            while ((received = RecvSome(socket, buffer, sizeof(buffer))) > 0)
+                in.insert(in.end(), buffer, buffer + received);
+
+            broken = received < 0;
+        }
+
+        {   // Whatever came in goes to the game, whatever it queued goes out
+            size_t offset = 0;
+            Message message;
+            s32 length;
+            f64 now = Now();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            while ((length = DecodeMessage(in.data() + offset, (s32) (in.size() - offset), message)) > 0)
+            {
+                offset += length;
+                incoming.push_back(message);
+
+                if (message.type == MessageType::STATE && timedMatch == message.match &&
+                    message.moveNumber == timedMoveNumber)
+                {
+                    lastRoundTrip = (now - timedSince) * 1000.0;
+                    timedMatch = 0;
+                }
+            }
+
+            broken = broken || length < 0;
+            in.erase(in.begin(), in.begin() + offset);
+            toSend.swap(outgoing);
+        }
+
+        for (const Message& message : toSend)
+        {
+            EncodeMessage(message, out);
+
+            if (message.type == MessageType::PLACE)
+            {
+                timedMatch = message.match;
+                timedMoveNumber = message.moveNumber + 1;
+                timedSince = Now();
+            }
+        }
+
+        toSend.clear();
+
+        // A few bytes at a time never fill the socket buffer, but don't lose them if they do
+        while (!out.empty())
+        {
+            s32 sent = SendSome(socket, out.data(), (s32) out.size());
+            if (sent < 0)
+                broken = true;
+            if (sent <= 0)
+                break;
+
+            out.erase(out.begin(), out.begin() + sent);
+        }
+
+        if (broken)
+        {
+            status = NetStatus::FAILED;
+            break;
+        }
+    }
+
+    poller.Free();
+    CloseSocket(socket);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "platform/socket.h"
+#include "protocol.h"
+
+enum class NetStatus : u8
+{
+    OFFLINE,
+    CONNECTING,
+    CONNECTED,
+    FAILED,         // Couldn't connect or the connection dropped
+};
+
+// A connection to the game server run on its own thread, so whoever
+// uses it never waits on the network. Messages to send are queued and
+// the ones that came in are picked up whenever it suits.
+struct NetClient
+{
+    std::atomic<NetStatus> status;
+    std::string host;
+    u16 port;
+
+    Socket socket;
+    Socket wakeSockets[2];      // Send writes to [1] so the thread notices on [0]
+    std::thread thread;
+    std::atomic<bool> stopping;
+
+    std::mutex mutex;
+    std::vector<Message> outgoing;
+    std::vector<Message> incoming;
+
+    // Round trip from a PLACE going out to its STATE coming back,
+    // timed on the network thread. Milliseconds, 0 until there is one.
+    std::atomic<f64> lastRoundTrip;
+    u32 timedMatch;
+    u16 timedMoveNumber;
+    f64 timedSince;
+
+    ~NetClient();
+
+    // Returns right away, status says how it goes
+    void Connect(const char serverHost[], u16 serverPort);
+    void Disconnect();
+
+    void Send(const Message& message);
+
+    // Moves everything received since last time into messages
+    void Receive(std::vector<Message>& messages);
+
+    void Run();
+};
@@ -0,0 +1,361 @@
+#include "journal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "universal/types.h"
+#include "platform/fileio.h"
+#include "game/board.h"
+#include "game/match.h"
+
+static const u32 SNAPSHOT_VERSION = 1;
+static const s32 RECORD_SIZE = 16;
+
+static f64 Now()
+{
+    using namespace std::chrono;
+    return duration<f64>(steady_clock::now().time_since_epoch()).count();
+}
+
+// FNV-1a, enough to spot a torn or half written record
+static u32 Checksum(const u8 data[], size_t size)
+{
+    u32 hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 16777619u;
+
+    return hash;
+}
+
+static void PutU16(u8* out, u16 value)
+{
+    out[0] = (u8) value;
+    out[1] = (u8) (value >> 8);
+}
+
+static void PutU32(u8* out, u32 value)
+{
+    for (int i = 0; i < 4; i++)
+        out[i] = (u8) (value >> (8 * i));
+}
+
+static u16 GetU16(const u8* data)
+{
+    return (u16) (data[0] | (data[1] << 8));
+}
+
+static u32 GetU32(const u8* data)
+{
+    return (u32) data[0] | ((u32) data[1] << 8) | ((u32) data[2] << 16) | ((u32) data[3] << 24);
+}
+
+static bool FileExists(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    fclose(file);
+    return true;
+}
+
+static bool LoadSnapshot(const std::vector<Byte>& data, std::unordered_map<u32, JournaledMatch>& matches,
+                         u32& firstSegment, u32& nextMatch)
+{
+    if (data.size() < 24 || memcmp(data.data(), "TTTJ", 4) != 0 || GetU32(&data[4]) != SNAPSHOT_VERSION ||
+        GetU32(&data[data.size() - 4]) != Checksum(data.data(), data.size() - 4))
+    {
+        return false;
+    }
+
+    firstSegment = GetU32(&data[8]);
+    nextMatch = GetU32(&data[12]);
+    u32 count = GetU32(&data[16]);
+
+    std::vector<CellElement> cells;
+    size_t offset = 20;
+
+    for (u32 i = 0; i < count; i++)
+    {
+        if (offset + 9 > data.size() - 4)
+            return false;
+
+        const u8* entry = &data[offset];
+        u32 id = GetU32(entry);
+        s32 size = entry[4];
+        s32 winLength = entry[5];
+        s32 numCells = size * size;
+        size_t packedSize = (numCells * 2 + 7) / 8;
+
+        if (size < 1 || size > Board::MAX_SIZE || offset + 9 + packedSize > data.size() - 4)
+            return false;
+
+        cells.resize(numCells);
+        for (s32 c = 0; c < numCells; c++)
+            cells[c] = (CellElement) ((entry[9 + c / 4] >> (2 * (c % 4))) & 3);
+
+        JournaledMatch& journaled = matches[id];
+        journaled.match.Start(size, winLength);
+        journaled.match.SetPosition(cells.data(), entry[8]);
+        journaled.level  = entry[6];
+        journaled.humans = entry[7];
+
+        offset += 9 + packedSize;
+    }
+
+    return true;
+}
+
+static void Replay(const u8 record[], std::unordered_map<u32, JournaledMatch>& matches, u32& nextMatch)
+{
+    u32 id = GetU32(record + 4);
+
+    switch ((JournalRecord) record[0])
+    {
+        case JournalRecord::START:
+        {
+            JournaledMatch& journaled = matches[id];
+            journaled.match.Start(record[1], record[2]);
+            journaled.level  = record[3];
+            journaled.humans = (u8) GetU16(record + 8);
+
+            // Ids only go up, apart from wrapping round
+            nextMatch = id > nextMatch ? id : nextMatch;
+        } break;
+
+        case JournalRecord::MOVE:
+        {
+            auto it = matches.find(id);
+            if (it != matches.end() && it->second.match.board.moveCount == GetU16(record + 10))
+                it->second.match.Play(GetU16(record + 8));
+        } break;
+
+        case JournalRecord::END:
+        {
+            matches.erase(id);
+        } break;
+    }
+}
+
+std::string Journal::GetSegmentPath(u32 index) const
+{
+    char name[32];
+    sprintf(name, ".%06u.wal", index);
+    return prefix + name;
+}
+
+bool Journal::Open(const char path[], std::unordered_map<u32, JournaledMatch>& matches, u32& nextMatch)
+{
+    prefix = path;
+    snapshotSegment = 1;
+    nextMatch = 0;
+
+    std::string snapshotPath = prefix + ".snapshot";
+    if (FileExists(snapshotPath) && !LoadSnapshot(LoadBinaryFile(snapshotPath.c_str()), matches, snapshotSegment, nextMatch))
+        return false;
+
+    // Every segment after the snapshot in order. A crash can leave a torn
+    // record at the end of one, the rest of that segment is skipped.
+    for (segment = snapshotSegment; FileExists(GetSegmentPath(segment)); segment++)
+    {
+        std::vector<Byte> data = LoadBinaryFile(GetSegmentPath(segment).c_str());
+
+        for (size_t offset = 0; offset + RECORD_SIZE <= data.size(); offset += RECORD_SIZE)
+        {
+            const u8* record = &data[offset];
+            if (GetU32(record + 12) != Checksum(record, 12))
+                break;
+
+            Replay(record, matches, nextMatch);
+        }
+    }
+
+    // Never append after what might be a torn record
+    file = fopen(GetSegmentPath(segment).c_str(), "wb");
+    if (!file)
+        return false;
+
+    pending.clear();
+    snapshot.clear();
+    stopping = false;
+    records = batches = syncMicros = snapshots = 0;
+    failed = false;
+
+    thread = std::thread([this]() { Write(); });
+    return true;
+}
+
+void Journal::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    wake.notify_one();
+    thread.join();
+    fclose(file);
+}
+
+void Journal::Append(JournalRecord type, u8 a, u8 b, u8 c, u32 match, u16 x, u16 y)
+{
+    u8 record[RECORD_SIZE];
+    record[0] = (u8) type;
+    record[1] = a;
+    record[2] = b;
+    record[3] = c;
+    PutU32(record + 4, match);
+    PutU16(record + 8, x);
+    PutU16(record + 10, y);
+    PutU32(record + 12, Checksum(record, 12));
+
+    bool wasEmpty;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wasEmpty = pending.empty();
+        pending.insert(pending.end(), record, record + RECORD_SIZE);
+    }
+
+    // While the writer is busy it'll find these when it's done
+    if (wasEmpty)
+        wake.notify_one();
+}
+
+void Journal::LogStart(u32 match, s32 size, s32 winLength, u8 level, u8 humans)
+{
+    Append(JournalRecord::START, (u8) size, (u8) winLength, level, match, humans, 0);
+}
+
+void Journal::LogMove(u32 match, s32 cell, s32 moveNumber)
+{
+    Append(JournalRecord::MOVE, 0, 0, 0, match, (u16) cell, (u16) moveNumber);
+}
+
+void Journal::LogEnd(u32 match, MatchStatus status)
+{
+    Append(JournalRecord::END, (u8) status, 0, 0, match, 0, 0);
+}
+
+void Journal::BeginSnapshot(u32 nextMatch, u32 count)
+{
+    building.assign(20, 0);
+    memcpy(building.data(), "TTTJ", 4);
+    PutU32(&building[4], SNAPSHOT_VERSION);
+    PutU32(&building[12], nextMatch);
+    PutU32(&building[16], count);
+}
+
+void Journal::AddToSnapshot(u32 id, const Match& match, u8 level, u8 humans)
+{
+    const Board& board = match.board;
+    size_t offset = building.size();
+    building.resize(offset + 9 + (board.numCells * 2 + 7) / 8, 0);
+
+    u8* entry = &building[offset];
+    PutU32(entry, id);
+    entry[4] = (u8) board.size;
+    entry[5] = (u8) board.winLength;
+    entry[6] = level;
+    entry[7] = humans;
+    entry[8] = (u8) board.playerIndex;
+
+    for (s32 c = 0; c < board.numCells; c++)
+        entry[9 + c / 4] |= (u8) board.cells[c] << (2 * (c % 4));
+}
+
+void Journal::EndSnapshot()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // An older one nobody has written yet is out of date anyway
+        snapshot.swap(building);
+        snapshotCut = pending.size();
+    }
+
+    building.clear();
+    wake.notify_one();
+}
+
+// To a temporary file first so there's always one whole snapshot on disk
+void Journal::WriteSnapshot(std::vector<u8>& data)
+{
+    PutU32(&data[8], segment);
+    u8 checksum[4];
+    PutU32(checksum, Checksum(data.data(), data.size()));
+    data.insert(data.end(), checksum, checksum + 4);
+
+    std::string path = prefix + ".snapshot";
+    std::string temporary = path + ".tmp";
+
+    FILE* out = fopen(temporary.c_str(), "wb");
+    bool written = out && fwrite(data.data(), 1, data.size(), out) == data.size() && FlushToDisk(out);
+    if (out)
+        fclose(out);
+
+    if (!written || !RenameFile(temporary.c_str(), path.c_str()))
+    {
+        failed = true;
+        return;
+    }
+
+    // Only now are the segments before it not needed
+    for (u32 old = snapshotSegment; old < segment; old++)
+        remove(GetSegmentPath(old).c_str());
+
+    snapshotSegment = segment;
+    snapshots++;
+}
+
+void Journal::Write()
+{
+    while (true)
+    {
+        size_t cut;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !pending.empty() || !snapshot.empty(); });
+
+            if (pending.empty() && snapshot.empty())
+                return;
+
+            writing.swap(pending);
+            pending.clear();
+            snapshotWriting.swap(snapshot);
+            snapshot.clear();
+            cut = snapshotWriting.empty() ? writing.size() : snapshotCut;
+        }
+
+        f64 start = Now();
+
+        // One write and one sync for the whole batch
+        bool written = fwrite(writing.data(), 1, cut, file) == cut && FlushToDisk(file);
+
+        if (!snapshotWriting.empty())
+        {   // Whatever came after the snapshot starts the next segment
+            fclose(file);
+            file = fopen(GetSegmentPath(++segment).c_str(), "wb");
+
+            written = written && file && fwrite(writing.data() + cut, 1, writing.size() - cut, file) == writing.size() - cut &&
+                      FlushToDisk(file);
+
+            if (written)
+                WriteSnapshot(snapshotWriting);
+        }
+
+        if (!written)
+            failed = true;
+
+        records += writing.size() / RECORD_SIZE;
+        batches++;
+        syncMicros += (u64) ((Now() - start) * 1e6);
+        writing.clear();
+    }
+}
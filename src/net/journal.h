@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "universal/types.h"
+#include "game/match.h"
+
+// Write-ahead log of everything that happens to the server's matches, plus
+// snapshots of all the live ones now and then so the log can be thrown away.
+//
+// The log is split into segments, "<prefix>.NNNNNN.wal", of 16 byte records:
+//
+//   u8 type, u8 a, u8 b, u8 c, u32 match, u16 x, u16 y, u32 checksum
+//
+//   START   a size, b winLength, c level, x human sides (bit per side)
+//   MOVE    x cell, y moves made before it
+//   END     a status
+//
+// A snapshot, "<prefix>.snapshot", holds every live match and the first
+// segment that isn't in it:
+//
+//   "TTTJ", u32 version, u32 next segment, u32 next match id, u32 matches
+//   per match: u32 id, u8 size, u8 winLength, u8 level, u8 human sides,
+//              u8 player to move, cells packed 2 bits each
+//   u32 checksum of everything before it
+//
+// All little endian. Recovering reads the snapshot and replays the segments
+// after it, stopping at the first torn or corrupt record.
+
+enum class JournalRecord : u8
+{
+    START = 1,
+    MOVE,
+    END,
+};
+
+struct JournaledMatch
+{
+    Match match;
+    u8 level;
+    u8 humans;          // Bit per side, set for the sides clients play
+};
+
+// Appending never waits on the disk. A writer thread takes whatever has
+// built up, writes it and syncs it once for the whole batch (group
+// commit), so a crash loses at most the batch being written.
+struct Journal
+{
+    std::string prefix;
+    u32 segment;                // Being written to
+    u32 snapshotSegment;        // First one the current snapshot needs
+    FILE* file;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<u8> pending;
+    std::vector<u8> writing;
+    std::vector<u8> building;   // Snapshot being put together, caller's thread only
+    std::vector<u8> snapshot;   // Waiting to be written, empty if none
+    std::vector<u8> snapshotWriting;
+    size_t snapshotCut;         // Bytes of pending that come before the snapshot
+    bool stopping;
+    std::thread thread;
+
+    std::atomic<u64> records;
+    std::atomic<u64> batches;
+    std::atomic<u64> syncMicros;
+    std::atomic<u64> snapshots;
+    std::atomic<bool> failed;
+
+    // Rebuilds the matches that were live, then starts a fresh segment.
+    // False if there's a journal that can't be read.
+    bool Open(const char path[], std::unordered_map<u32, JournaledMatch>& matches, u32& nextMatch);
+    void Close();
+
+    void LogStart(u32 match, s32 size, s32 winLength, u8 level, u8 humans);
+    void LogMove(u32 match, s32 cell, s32 moveNumber);
+    void LogEnd(u32 match, MatchStatus status);
+
+    // A snapshot is built up one match at a time on the caller's thread and
+    // then handed over. Records logged after EndSnapshot aren't in it.
+    void BeginSnapshot(u32 nextMatch, u32 count);
+    void AddToSnapshot(u32 id, const Match& match, u8 level, u8 humans);
+    void EndSnapshot();
+
+    std::string GetSegmentPath(u32 index) const;
+    void Append(JournalRecord type, u8 a, u8 b, u8 c, u32 match, u16 x, u16 y);
+    void Write();
+    void WriteSnapshot(std::vector<u8>& data);
+};
@@ -0,0 +1,238 @@
+#include "matchmaker.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include "universal/types.h"
+#include "universal/histogram.h"
+
+void TicketQueue::Init(u32 capacityLog2)
+{
+    u64 capacity = 1ULL << capacityLog2;
+    slots.reset(new Slot[capacity]);
+    mask = capacity - 1;
+
+    for (u64 i = 0; i < capacity; i++)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+
+    pushPosition.store(0, std::memory_order_relaxed);
+    popPosition.store(0, std::memory_order_relaxed);
+}
+
+bool TicketQueue::Push(const Ticket& ticket)
+{
+    u64 position = pushPosition.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        Slot& slot = slots[position & mask];
+        u64 sequence = slot.sequence.load(std::memory_order_acquire);
+        s64 difference = (s64) sequence - (s64) position;
+
+        if (difference == 0)
+        {   // Free on this lap, claim it
+            if (pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                slot.ticket = ticket;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {   // Still holds last lap's ticket
+            return false;
+        }
+        else
+        {
+            position = pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool TicketQueue::Pop(Ticket& ticket)
+{
+    u64 position = popPosition.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        Slot& slot = slots[position & mask];
+        u64 sequence = slot.sequence.load(std::memory_order_acquire);
+        s64 difference = (s64) sequence - (s64) (position + 1);
+
+        if (difference == 0)
+        {
+            if (popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                ticket = slot.ticket;
+                slot.sequence.store(position + mask + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {   // Nothing written there yet
+            return false;
+        }
+        else
+        {
+            position = popPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+u64 TicketQueue::Size() const
+{
+    u64 pushed = pushPosition.load(std::memory_order_relaxed);
+    u64 popped = popPosition.load(std::memory_order_relaxed);
+    return pushed > popped ? pushed - popped : 0;
+}
+
+void Matchmaker::Init(u32 capacityLog2)
+{
+    queues.reset(new TicketQueue[NUM_QUEUES]);
+    for (s32 i = 0; i < NUM_QUEUES; i++)
+        queues[i].Init(capacityLog2);
+
+    joins = 0;
+    matches = 0;
+    rejected = 0;
+    waitTotal = 0;
+    waitMax = 0;
+    for (std::atomic<u64>& count : waitCounts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+s32 Matchmaker::GetQueueIndex(s32 variant, s32 timeControl, s32 band) const
+{
+    return (variant * NUM_TIME_CONTROLS + timeControl) * NUM_BANDS + band;
+}
+
+static s32 GetBand(u16 rating)
+{
+    s32 band = rating / Matchmaker::BAND_WIDTH;
+    return band < Matchmaker::NUM_BANDS ? band : Matchmaker::NUM_BANDS - 1;
+}
+
+void Matchmaker::AddWait(const Ticket& ticket, u64 now)
+{
+    u64 wait = now > ticket.joinedAt ? now - ticket.joinedAt : 0;
+    waitCounts[Histogram::BucketOf(wait)].fetch_add(1, std::memory_order_relaxed);
+    waitTotal.fetch_add(wait, std::memory_order_relaxed);
+
+    u64 longest = waitMax.load(std::memory_order_relaxed);
+    while (wait > longest && !waitMax.compare_exchange_weak(longest, wait, std::memory_order_relaxed));
+}
+
+void Matchmaker::Pair(const Ticket& a, const Ticket& b, u64 now)
+{
+    AddWait(a, now);
+    AddWait(b, now);
+    matches.fetch_add(1, std::memory_order_relaxed);
+
+    if (onMatch)
+        onMatch(a, b, callbackData);
+}
+
+bool Matchmaker::Join(const Ticket& ticket, u64 now)
+{
+    if (ticket.variant >= NUM_VARIANTS || ticket.timeControl >= NUM_TIME_CONTROLS)
+        return false;
+
+    joins.fetch_add(1, std::memory_order_relaxed);
+    TicketQueue& queue = queues[GetQueueIndex(ticket.variant, ticket.timeControl, GetBand(ticket.rating))];
+
+    Ticket partner;
+    if (queue.Pop(partner))
+    {
+        Pair(partner, ticket, now);
+        return true;
+    }
+
+    if (queue.Push(ticket))
+        return true;
+
+    rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+s32 Matchmaker::Sweep(u64 now)
+{
+    s32 made = 0;
+
+    for (s32 variant = 0; variant < NUM_VARIANTS; variant++)
+        for (s32 timeControl = 0; timeControl < NUM_TIME_CONTROLS; timeControl++)
+            for (s32 band = 0; band < NUM_BANDS; band++)
+            {
+                TicketQueue& queue = queues[GetQueueIndex(variant, timeControl, band)];
+
+                // Only as many as were there to start with, the ones put
+                // back at the end shouldn't come round again
+                for (u64 remaining = queue.Size(); remaining > 0; remaining--)
+                {
+                    Ticket ticket;
+                    if (!queue.Pop(ticket))
+                        break;
+
+                    u64 wait = now > ticket.joinedAt ? now - ticket.joinedAt : 0;
+                    s32 spread = widenAfter ? (s32) (wait / widenAfter) : maxSpread;
+                    spread = spread < maxSpread ? spread : maxSpread;
+
+                    // Closest bands first
+                    bool paired = false;
+                    for (s32 distance = 0; distance <= spread && !paired; distance++)
+                    {
+                        for (s32 side = -1; side <= 1 && !paired; side += 2)
+                        {
+                            s32 other = band + side * distance;
+                            if (other < 0 || other >= NUM_BANDS || (distance == 0 && side > 0))
+                                continue;
+
+                            Ticket partner;
+                            if (queues[GetQueueIndex(variant, timeControl, other)].Pop(partner))
+                            {
+                                Pair(partner, ticket, now);
+                                paired = true;
+                                made++;
+                            }
+                        }
+                    }
+
+                    // Back in the queue. If joiners filled it up meanwhile there's
+                    // someone in the same band to pair with instead.
+                    while (!paired && !queue.Push(ticket))
+                    {
+                        Ticket partner;
+                        if (queue.Pop(partner))
+                        {
+                            Pair(partner, ticket, now);
+                            paired = true;
+                            made++;
+                        }
+                    }
+                }
+            }
+
+    return made;
+}
+
+u64 Matchmaker::GetQueueDepth() const
+{
+    u64 depth = 0;
+    for (s32 i = 0; i < NUM_QUEUES; i++)
+        depth += queues[i].Size();
+
+    return depth;
+}
+
+void Matchmaker::GetWaitTimes(Histogram& out) const
+{
+    out.Clear();
+
+    for (s32 i = 0; i < Histogram::NUM_BUCKETS; i++)
+        out.counts[i] = waitCounts[i].load(std::memory_order_relaxed);
+
+    for (s32 i = 0; i < Histogram::NUM_BUCKETS; i++)
+        out.count += out.counts[i];
+
+    out.total = waitTotal.load(std::memory_order_relaxed);
+    out.max   = waitMax.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include "universal/types.h"
+#include "universal/histogram.h"
+
+// Someone looking for a game
+struct Ticket
+{
+    u32 player;
+    u16 rating;
+    u8  variant;
+    u8  timeControl;
+    u64 joinedAt;       // Microseconds, any clock as long as it's the same one
+};
+
+// Bounded queue any number of threads can push to and pop from without
+// locks (Dmitry Vyukov's MPMC ring). Each slot's sequence number says
+// whether it's ready to be written or read on the current lap.
+struct TicketQueue
+{
+    struct Slot
+    {
+        std::atomic<u64> sequence;
+        Ticket ticket;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    u64 mask;
+
+    // On their own cache lines so pushers and poppers don't slow each other down
+    u8 padding0[64];
+    std::atomic<u64> pushPosition;
+    u8 padding1[64];
+    std::atomic<u64> popPosition;
+    u8 padding2[64];
+
+    void Init(u32 capacityLog2);
+
+    bool Push(const Ticket& ticket);     // False if it's full
+    bool Pop(Ticket& ticket);           // False if it's empty
+    u64  Size() const;                  // Only a snapshot while others use it
+};
+
+// Pairs players with the same variant and time control and a similar
+// rating. There's a queue for every variant, time control and band of
+// ratings, so players joining in different places never touch the same
+// memory, and nothing ever takes a lock.
+//
+// Join pairs a player with someone already in their band straight away if
+// it can. Sweep, which any thread can call as often as it likes, pairs up
+// whoever is left, looking further out in rating the longer they've waited.
+struct Matchmaker
+{
+    static constexpr s32 NUM_VARIANTS      = 4;
+    static constexpr s32 NUM_TIME_CONTROLS = 4;
+    static constexpr s32 NUM_BANDS         = 32;
+    static constexpr s32 BAND_WIDTH        = 100;
+    static constexpr s32 NUM_QUEUES        = NUM_VARIANTS * NUM_TIME_CONTROLS * NUM_BANDS;
+
+    std::unique_ptr<TicketQueue[]> queues;
+
+    // How far out a waiting player will go, in bands either side.
+    // One more band every widenAfter microseconds of waiting.
+    s32 maxSpread;
+    u64 widenAfter;
+
+    // Called from whichever thread makes the pair
+    void (*onMatch)(const Ticket& a, const Ticket& b, void* data);
+    void* callbackData;
+
+    std::atomic<u64> joins;
+    std::atomic<u64> matches;
+    std::atomic<u64> rejected;          // Their queue was full
+
+    // Time from joining to being paired, in microseconds
+    std::atomic<u64> waitCounts[Histogram::NUM_BUCKETS];
+    std::atomic<u64> waitTotal;
+    std::atomic<u64> waitMax;
+
+    void Init(u32 capacityLog2 = 10);
+
+    // False if the player couldn't be queued, try again later
+    bool Join(const Ticket& ticket, u64 now);
+
+    // Returns the number of pairs made
+    s32 Sweep(u64 now);
+
+    u64  GetQueueDepth() const;
+    void GetWaitTimes(Histogram& out) const;
+
+    s32  GetQueueIndex(s32 variant, s32 timeControl, s32 band) const;
+    void Pair(const Ticket& a, const Ticket& b, u64 now);
+    void AddWait(const Ticket& ticket, u64 now);
+};
@@ -0,0 +1,247 @@
+#include "protocol.h"
+
+#include <cstring>
+#include <vector>
+#include "universal/types.h"
+#include "game/board.h"
+
+static void PutU16(std::vector<u8>& out, u16 value)
+{
+    out.push_back((u8) value);
+    out.push_back((u8) (value >> 8));
+}
+
+static void PutU32(std::vector<u8>& out, u32 value)
+{
+    for (int i = 0; i < 4; i++)
+        out.push_back((u8) (value >> (8 * i)));
+}
+
+static u16 GetU16(const u8 data[])
+{
+    return (u16) (data[0] | (data[1] << 8));
+}
+
+static u32 GetU32(const u8 data[])
+{
+    return (u32) data[0] | ((u32) data[1] << 8) | ((u32) data[2] << 16) | ((u32) data[3] << 24);
+}
+
+static s32 GetPayloadSize(MessageType type)
+{
+    switch (type)
+    {
+        case MessageType::NEW_GAME: return 4;
+        case MessageType::PLACE:    return 8;
+        case MessageType::RESIGN:   return 4;
+        case MessageType::RESUME:   return 5;
+        case MessageType::STARTED:  return 7;
+        case MessageType::STATE:    return 9;
+        case MessageType::ERROR:    return 5;
+        case MessageType::WATCH:    return 4;
+        case MessageType::UNWATCH:  return 4;
+        case MessageType::BOARD:    return 12;      // Before the cells
+    }
+
+    return -1;
+}
+
+static s32 GetPackedSize(s32 size)
+{
+    return (size * size + 3) / 4;
+}
+
+void PackCells(const CellElement cells[], s32 numCells, u8 packed[])
+{
+    for (s32 i = 0; i < (numCells + 3) / 4; i++)
+        packed[i] = 0;
+
+    for (s32 i = 0; i < numCells; i++)
+        packed[i / 4] |= (u8) cells[i] << (2 * (i % 4));
+}
+
+void UnpackCells(const u8 packed[], s32 numCells, CellElement cells[])
+{
+    for (s32 i = 0; i < numCells; i++)
+        cells[i] = (CellElement) ((packed[i / 4] >> (2 * (i % 4))) & 3);
+}
+
+void EncodeMessage(const Message& message, std::vector<u8>& out)
+{
+    s32 payloadSize = GetPayloadSize(message.type);
+    if (message.type == MessageType::BOARD)
+        payloadSize += GetPackedSize(message.size);
+
+    PutU16(out, (u16) payloadSize);
+    out.push_back((u8) message.type);
+
+    switch (message.type)
+    {
+        case MessageType::NEW_GAME:
+        {
+            out.push_back(message.size);
+            out.push_back(message.winLength);
+            out.push_back(message.level);
+            out.push_back(message.player);
+        } break;
+
+        case MessageType::PLACE:
+        {
+            PutU32(out, message.match);
+            PutU16(out, message.moveNumber);
+            PutU16(out, message.cell);
+        } break;
+
+        case MessageType::RESIGN:
+        {
+            PutU32(out, message.match);
+        } break;
+
+        case MessageType::RESUME:
+        {
+            PutU32(out, message.match);
+            out.push_back(message.player);
+        } break;
+
+        case MessageType::STARTED:
+        {
+            PutU32(out, message.match);
+            out.push_back(message.size);
+            out.push_back(message.winLength);
+            out.push_back(message.player);
+        } break;
+
+        case MessageType::STATE:
+        {
+            PutU32(out, message.match);
+            PutU16(out, message.moveNumber);
+            PutU16(out, message.cell);
+            out.push_back(message.status);
+        } break;
+
+        case MessageType::ERROR:
+        {
+            PutU32(out, message.match);
+            out.push_back((u8) message.error);
+        } break;
+
+        case MessageType::WATCH:
+        case MessageType::UNWATCH:
+        {
+            PutU32(out, message.match);
+        } break;
+
+        case MessageType::BOARD:
+        {
+            PutU32(out, message.match);
+            out.push_back(message.size);
+            out.push_back(message.winLength);
+            PutU16(out, message.moveNumber);
+            PutU16(out, message.cell);
+            out.push_back(message.status);
+            out.push_back(message.player);
+            out.insert(out.end(), message.cells, message.cells + GetPackedSize(message.size));
+        } break;
+    }
+}
+
+s32 DecodeMessage(const u8 data[], s32 available, Message& message)
+{
+    if (available < FRAME_HEADER_SIZE)
+        return 0;
+
+    s32 payloadSize = GetU16(data);
+    if (payloadSize > MAX_PAYLOAD_SIZE)
+        return -1;
+
+    if (available < FRAME_HEADER_SIZE + payloadSize)
+        return 0;
+
+    message.type = (MessageType) data[2];
+    s32 expectedSize = GetPayloadSize(message.type);
+
+    // A board's size says how many cells follow
+    if (message.type == MessageType::BOARD && payloadSize >= expectedSize)
+    {
+        s32 size = data[FRAME_HEADER_SIZE + 4];
+        if (size < 1 || size > Board::MAX_SIZE)
+            return -1;
+
+        expectedSize += GetPackedSize(size);
+    }
+
+    if (expectedSize != payloadSize)
+        return -1;
+
+    const u8* payload = data + FRAME_HEADER_SIZE;
+    switch (message.type)
+    {
+        case MessageType::NEW_GAME:
+        {
+            message.size      = payload[0];
+            message.winLength = payload[1];
+            message.level     = payload[2];
+            message.player    = payload[3];
+        } break;
+
+        case MessageType::PLACE:
+        {
+            message.match      = GetU32(payload);
+            message.moveNumber = GetU16(payload + 4);
+            message.cell       = GetU16(payload + 6);
+        } break;
+
+        case MessageType::RESIGN:
+        {
+            message.match = GetU32(payload);
+        } break;
+
+        case MessageType::RESUME:
+        {
+            message.match  = GetU32(payload);
+            message.player = payload[4];
+        } break;
+
+        case MessageType::STARTED:
+        {
+            message.match     = GetU32(payload);
+            message.size      = payload[4];
+            message.winLength = payload[5];
+            message.player    = payload[6];
+        } break;
+
+        case MessageType::STATE:
+        {
+            message.match      = GetU32(payload);
+            message.moveNumber = GetU16(payload + 4);
+            message.cell       = GetU16(payload + 6);
+            message.status     = payload[8];
+        } break;
+
+        case MessageType::ERROR:
+        {
+            message.match = GetU32(payload);
+            message.error = (ProtocolError) payload[4];
+        } break;
+
+        case MessageType::WATCH:
+        case MessageType::UNWATCH:
+        {
+            message.match = GetU32(payload);
+        } break;
+
+        case MessageType::BOARD:
+        {
+            message.match      = GetU32(payload);
+            message.size       = payload[4];
+            message.winLength  = payload[5];
+            message.moveNumber = GetU16(payload + 6);
+            message.cell       = GetU16(payload + 8);
+            message.status     = payload[10];
+            message.player     = payload[11];
+            memcpy(message.cells, payload + 12, payloadSize - 12);
+        } break;
+    }
+
+    return FRAME_HEADER_SIZE + payloadSize;
+}
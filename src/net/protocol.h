@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+#include "universal/types.h"
+#include "game/board.h"
+
+// Messages between game clients and the server. Every message is a frame:
+//
+//   u16 payload size, u8 type, payload
+//
+// All little endian. Payloads by type:
+//
+//   NEW_GAME   u8 size, u8 winLength, u8 level, u8 player
+//   PLACE      u32 match, u16 moveNumber, u16 cell
+//   RESIGN     u32 match
+//   RESUME     u32 match, u8 player
+//   WATCH      u32 match
+//   UNWATCH    u32 match
+//   STARTED    u32 match, u8 size, u8 winLength, u8 player
+//   STATE      u32 match, u16 moveNumber, u16 cell, u8 status
+//   ERROR      u32 match, u8 error
+//   BOARD      u32 match, u8 size, u8 winLength, u16 moveNumber, u16 cell,
+//              u8 status, u8 player to move, cells packed 2 bits each
+//
+// moveNumber in PLACE is how many moves the client has seen, so a move sent
+// for a position that's already gone is turned down instead of played.
+// STATE acknowledges every move made by either side, moveNumber counts it.
+// A STATE with no cell ends the match without a move, someone resigned or
+// went away.
+//
+// NEW_GAME with level HUMAN_OPPONENT waits for another client asking for
+// the same board, then both get STARTED. player is the side asked for,
+// the second of the two gets whichever side is left.
+//
+// RESUME takes over a side of a match nobody is playing any more, one the
+// server brought back from its journal after a restart. The reply is
+// STARTED followed by a STATE for every move made so far.
+//
+// WATCH makes the connection a spectator of the match. It gets a BOARD,
+// the position a few moves back, then the STATEs since and every STATE
+// after that until the match ends. A spectator that falls too far behind
+// is sent a fresh BOARD when it catches up.
+
+enum class MessageType : u8
+{
+    // Client to server
+    NEW_GAME = 1,
+    PLACE,
+    RESIGN,
+    RESUME,
+    WATCH,
+    UNWATCH,
+
+    // Server to client
+    STARTED = 16,
+    STATE,
+    ERROR,
+    BOARD,
+};
+
+enum class ProtocolError : u8
+{
+    NONE,
+    BAD_MESSAGE,
+    BAD_SETTINGS,
+    NO_SUCH_MATCH,
+    NOT_YOUR_TURN,
+    ILLEGAL_MOVE,
+    TOO_MANY_MATCHES,
+};
+
+const s32 FRAME_HEADER_SIZE = 3;
+const s32 MAX_PAYLOAD_SIZE  = 256;
+const u16 NO_CELL = 0xFFFF;
+const u8  HUMAN_OPPONENT = 0xFF;
+const s32 MAX_PACKED_CELLS = (Board::MAX_MOVES + 3) / 4;
+
+// Every type uses the same struct, fields that aren't in
+// its payload are left alone
+struct Message
+{
+    MessageType type;
+    u32 match;
+    u8  size;
+    u8  winLength;
+    u8  level;
+    u8  player;
+    u16 moveNumber;
+    u16 cell;
+    u8  status;         // MatchStatus
+    ProtocolError error;
+    u8  cells[MAX_PACKED_CELLS];    // CellElements, 4 to a byte from the low bits
+};
+
+void PackCells(const CellElement cells[], s32 numCells, u8 packed[]);
+void UnpackCells(const u8 packed[], s32 numCells, CellElement cells[]);
+
+// Appends the frame for message to out
+void EncodeMessage(const Message& message, std::vector<u8>& out);
+
+// Reads one frame from the start of data. Returns the bytes it took up,
+// 0 if the whole frame isn't there yet and -1 if it makes no sense.
+s32 DecodeMessage(const u8 data[], s32 available, Message& message);
@@ -0,0 +1,1071 @@
+#include "server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "platform/socket.h"
+#include "game/board.h"
+#include "game/match.h"
+#include "game/player.h"
+#include "game/search.h"
+#include "protocol.h"
+#include "journal.h"
+#include "broadcast.h"
+
+// Poller data for the two sockets that aren't connections
+static const u64 LISTENER_DATA = ~0ULL;
+static const u64 WAKE_DATA     = ~1ULL;
+
+static const s32 READ_CHUNK = 16 * 1024;
+
+// Drop clients that send faster than they read what comes back
+static const size_t MAX_OUT_BYTES = 1 << 20;
+
+// Room for the keyframe and moves of every match a spectator can watch
+static const size_t MAX_WATCHES = 16;
+static const size_t SPECTATOR_RING_SIZE = 16 * 1024;
+
+static f64 Now()
+{
+    using namespace std::chrono;
+    return duration<f64>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void AtomicMax(std::atomic<u64>& value, u64 candidate)
+{
+    u64 current = value.load(std::memory_order_relaxed);
+    while (candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed));
+}
+
+bool GameServer::Start(u16 port, s32 numWorkers, bool localOnly)
+{
+    if (!InitSockets())
+        return false;
+
+    listener = ListenTcp(port, localOnly);
+    if (listener == NO_SOCKET)
+        return false;
+
+    if (!MakeSocketPair(wakeSockets) || !poller.Init())
+    {
+        CloseSocket(listener);
+        return false;
+    }
+
+    SetNonBlocking(listener);
+    SetNonBlocking(wakeSockets[0]);
+    SetNonBlocking(wakeSockets[1]);
+    poller.Add(listener, LISTENER_DATA);
+    poller.Add(wakeSockets[0], WAKE_DATA);
+
+    nextMatch = 0;
+    stats.connections     = 0;
+    stats.liveMatches     = 0;
+    stats.matchesStarted  = 0;
+    stats.matchesFinished = 0;
+    stats.moves           = 0;
+    stats.acks            = 0;
+    stats.ackMicros       = 0;
+    stats.ackMaxMicros    = 0;
+    stats.errors          = 0;
+    stats.spectators      = 0;
+    stats.spectatorFrames = 0;
+    stats.spectatorBytes  = 0;
+    stats.catchUps        = 0;
+
+    if (maxMatchesPerConnection == 0)
+        maxMatchesPerConnection = 4096;
+
+    if (snapshotSeconds <= 0.0)
+        snapshotSeconds = 10.0;
+
+    journaling = false;
+    recoveredMatches = 0;
+
+    if (journalPath && !Recover())
+    {
+        poller.Free();
+        CloseSocket(listener);
+        CloseSocket(wakeSockets[0]);
+        CloseSocket(wakeSockets[1]);
+        return false;
+    }
+
+    stopping = false;
+    for (s32 i = 0; i < numWorkers; i++)
+        workers.emplace_back([this]() { Work(); });
+
+    loopThread = std::thread([this]() { Loop(); });
+    return true;
+}
+
+void GameServer::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+
+    jobReady.notify_all();
+    Wake();
+
+    loopThread.join();
+    for (std::thread& worker : workers)
+        worker.join();
+
+    workers.clear();
+
+    // Whatever is still live stays in the journal for next time
+    if (journaling)
+    {
+        TakeSnapshot();
+        journaling = false;
+        journal.Close();
+    }
+
+    for (u32 i = 0; i < connections.size(); i++)
+    {
+        if (connections[i].open)
+            Close(i);
+    }
+
+    poller.Free();
+    CloseSocket(listener);
+    CloseSocket(wakeSockets[0]);
+    CloseSocket(wakeSockets[1]);
+}
+
+u16 GameServer::GetPort() const
+{
+    return GetLocalPort(listener);
+}
+
+void GameServer::Wake()
+{
+    u8 byte = 1;
+    SendSome(wakeSockets[1], &byte, 1);
+}
+
+void GameServer::Loop()
+{
+    PollEvent events[256];
+
+    while (!stopping)
+    {
+        s32 numEvents = poller.Wait(events, 256, 100);
+        f64 receivedAt = Now();
+
+        for (s32 i = 0; i < numEvents; i++)
+        {
+            const PollEvent& event = events[i];
+
+            if (event.data == LISTENER_DATA)
+            {
+                Accept();
+            }
+            else if (event.data == WAKE_DATA)
+            {
+                u8 drain[256];
+                while (RecvSome(wakeSockets[0], drain, sizeof(drain)) > 0);
+
+                TakeResults();
+            }
+            else
+            {
+                u32 connection = (u32) event.data;
+                if (!connections[connection].open)
+                    continue;
+
+                if (event.readable || event.closed)
+                    Read(connection, receivedAt);
+
+                if (event.writable && connections[connection].open)
+                    Flush(connection);
+            }
+        }
+
+        // Replies go out once per wake up, however many moves came in.
+        // Closing a connection can add more to the list.
+        for (size_t i = 0; i < dirtyConnections.size(); i++)
+            Flush(dirtyConnections[i]);
+
+        dirtyConnections.clear();
+
+        if (journaling && receivedAt - lastSnapshot >= snapshotSeconds)
+            TakeSnapshot();
+    }
+}
+
+void GameServer::Accept()
+{
+    while (true)
+    {
+        Socket socket = AcceptTcp(listener);
+        if (socket == NO_SOCKET)
+            return;
+
+        SetNonBlocking(socket);
+        SetNoDelay(socket);
+
+        u32 index;
+        if (!freeConnections.empty())
+        {
+            index = freeConnections.back();
+            freeConnections.pop_back();
+        }
+        else
+        {
+            index = (u32) connections.size();
+            connections.emplace_back();
+        }
+
+        ServerConnection& connection = connections[index];
+        connection.socket = socket;
+        connection.in.clear();
+        connection.out.clear();
+        connection.outStart = 0;
+        connection.matches.clear();
+        connection.pendingAcks = 0;
+        connection.waitingToWrite = false;
+        connection.dirty = false;
+        connection.open = true;
+        connection.watching.clear();
+        connection.missedEnds.clear();
+        connection.behind = false;
+
+        poller.Add(socket, index);
+        stats.connections++;
+    }
+}
+
+void GameServer::Read(u32 index, f64 receivedAt)
+{
+    ServerConnection& connection = connections[index];
+
+    while (true)
+    {
+        size_t used = connection.in.size();
+        connection.in.resize(used + READ_CHUNK);
+
+        s32 received = RecvSome(connection.socket, connection.in.data() + used, READ_CHUNK);
+        connection.in.resize(used + (received > 0 ? received : 0));
+
+        if (received < 0)
+        {
+            Close(index);
+            return;
+        }
+
+        if (received < READ_CHUNK)
+            break;
+    }
+
+    // Handle every whole message, the rest waits for more bytes
+    size_t offset = 0;
+    while (offset < connection.in.size())
+    {
+        Message message = {};
+        s32 length = DecodeMessage(connection.in.data() + offset, (s32) (connection.in.size() - offset), message);
+        if (length == 0)
+            break;
+
+        if (length < 0)
+        {
+            Close(index);
+            return;
+        }
+
+        offset += length;
+
+        u32 acksBefore = connections[index].pendingAcks;
+        Handle(index, message);
+
+        // Handle can close the connection
+        if (!connections[index].open)
+            return;
+
+        if (acksBefore == 0 && connections[index].pendingAcks > 0)
+            connections[index].oldestAck = receivedAt;
+    }
+
+    ServerConnection& after = connections[index];
+    after.in.erase(after.in.begin(), after.in.begin() + offset);
+}
+
+void GameServer::Flush(u32 index)
+{
+    ServerConnection& connection = connections[index];
+    if (!connection.open)
+        return;
+
+    connection.dirty = false;
+
+    while (connection.outStart < connection.out.size())
+    {
+        s32 sent = SendSome(connection.socket, connection.out.data() + connection.outStart,
+                            (s32) (connection.out.size() - connection.outStart));
+        if (sent < 0)
+        {
+            Close(index);
+            return;
+        }
+
+        if (sent == 0)
+            break;
+
+        connection.outStart += sent;
+    }
+
+    bool everythingSent = connection.outStart == connection.out.size();
+    if (everythingSent)
+    {
+        connection.out.clear();
+        connection.outStart = 0;
+
+        if (connection.pendingAcks > 0)
+        {
+            u64 micros = (u64) ((Now() - connection.oldestAck) * 1e6);
+            stats.acks += connection.pendingAcks;
+            stats.ackMicros += micros * connection.pendingAcks;
+            AtomicMax(stats.ackMaxMicros, micros);
+            connection.pendingAcks = 0;
+        }
+
+        // Spectating goes out after the replies to its own messages
+        if (!SendSpectating(index))
+            return;
+
+        everythingSent = connection.spectating.used == 0;
+    }
+    else if (connection.out.size() > MAX_OUT_BYTES)
+    {
+        Close(index);
+        return;
+    }
+
+    // Only ask to hear about the socket being writable while there's a backlog
+    if (connection.waitingToWrite == everythingSent)
+    {
+        connection.waitingToWrite = !everythingSent;
+        poller.Modify(connection.socket, index, connection.waitingToWrite);
+    }
+}
+
+void GameServer::Close(u32 index)
+{
+    ServerConnection& connection = connections[index];
+
+    poller.Remove(connection.socket);
+    CloseSocket(connection.socket);
+    connection.open = false;
+
+    for (size_t i = 0; i < waitingPlayers.size(); )
+    {
+        if (waitingPlayers[i].connection == index)
+        {
+            waitingPlayers[i] = waitingPlayers.back();
+            waitingPlayers.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    // Whatever was running on them just stops, a result still with a
+    // worker is dropped when it comes back. Someone playing against this
+    // connection wins by forfeit.
+    std::vector<u32> owned;
+    owned.swap(connection.matches);
+
+    for (u32 match : owned)
+    {
+        auto it = matches.find(match);
+        if (it == matches.end())
+            continue;
+
+        ServerMatch& entry = it->second;
+        s32 leaver = 0;
+        s32 sides = 0;
+        for (s32 side = 0; side < 2; side++)
+        {
+            if (entry.connections[side] == index)
+            {
+                entry.connections[side] = NO_CONNECTION;
+                leaver = side;
+                sides++;
+            }
+        }
+
+        // Playing both sides, the one to move gives up. The end goes out
+        // to whoever is left playing and to spectators either way, or
+        // they'd be left watching a match that's gone.
+        if (!entry.match.IsOver())
+        {
+            if (sides == 2)
+                leaver = entry.match.board.playerIndex;
+
+            entry.match.status = leaver == 0 ? MatchStatus::CIRCLE_WON : MatchStatus::CROSS_WON;
+            entry.match.lastMove = -1;
+            SendState(match, entry);
+        }
+
+        EndMatch(match);
+    }
+
+    std::vector<u32> watched;
+    watched.swap(connection.watching);
+
+    for (u32 match : watched)
+        StopWatching(index, match);
+
+    connection.spectating.Free();
+    connection.missedEnds.clear();
+
+    connection.in.clear();
+    connection.in.shrink_to_fit();
+    connection.out.clear();
+    connection.out.shrink_to_fit();
+
+    freeConnections.push_back(index);
+    stats.connections--;
+}
+
+void GameServer::MarkDirty(u32 index)
+{
+    ServerConnection& connection = connections[index];
+    if (!connection.dirty)
+    {
+        connection.dirty = true;
+        dirtyConnections.push_back(index);
+    }
+}
+
+void GameServer::Send(u32 index, const Message& message)
+{
+    EncodeMessage(message, connections[index].out);
+    MarkDirty(index);
+}
+
+void GameServer::SendError(u32 connection, u32 match, ProtocolError error)
+{
+    Message message = {};
+    message.type  = MessageType::ERROR;
+    message.match = match;
+    message.error = error;
+    Send(connection, message);
+
+    stats.errors++;
+}
+
+// To every client playing in the match
+void GameServer::SendState(u32 match, const ServerMatch& entry)
+{
+    Message message = {};
+    message.type       = MessageType::STATE;
+    message.match      = match;
+    message.moveNumber = (u16) entry.match.board.moveCount;
+    message.cell       = entry.match.lastMove >= 0 ? (u16) entry.match.lastMove : NO_CELL;
+    message.status     = (u8) entry.match.status;
+
+    for (s32 side = 0; side < 2; side++)
+    {
+        // Both sides can be the same connection
+        u32 connection = entry.connections[side];
+        if (connection != NO_CONNECTION && (side == 0 || connection != entry.connections[0]))
+            Send(connection, message);
+    }
+
+    if (feeds.count(match))
+        Broadcast(match, entry);
+}
+
+void GameServer::Handle(u32 connection, const Message& message)
+{
+    switch (message.type)
+    {
+        case MessageType::NEW_GAME: StartMatch(connection, message); break;
+        case MessageType::PLACE:    PlaceForClient(connection, message); break;
+        case MessageType::RESIGN:   Resign(connection, message); break;
+        case MessageType::RESUME:   Resume(connection, message); break;
+        case MessageType::WATCH:    Watch(connection, message); break;
+
+        case MessageType::UNWATCH:
+        {
+            std::vector<u32>& watching = connections[connection].watching;
+            if (std::find(watching.begin(), watching.end(), message.match) == watching.end())
+                SendError(connection, message.match, ProtocolError::NO_SUCH_MATCH);
+            else
+                StopWatching(connection, message.match);
+        } break;
+
+        // Only the server sends the rest
+        default: SendError(connection, 0, ProtocolError::BAD_MESSAGE); break;
+    }
+}
+
+void GameServer::StartMatch(u32 connection, const Message& message)
+{
+    bool vsHuman = message.level == HUMAN_OPPONENT;
+    if (message.size < 1 || message.size > Board::MAX_SIZE || message.winLength < 1 ||
+        message.winLength > message.size || (message.level >= NUM_LEVELS && !vsHuman) || message.player > 1)
+    {
+        SendError(connection, 0, ProtocolError::BAD_SETTINGS);
+        return;
+    }
+
+    if (connections[connection].matches.size() >= maxMatchesPerConnection)
+    {
+        SendError(connection, 0, ProtocolError::TOO_MANY_MATCHES);
+        return;
+    }
+
+    if (!vsHuman)
+    {
+        u32 cross  = message.player == 0 ? connection : NO_CONNECTION;
+        u32 circle = message.player == 1 ? connection : NO_CONNECTION;
+        CreateMatch(message.size, message.winLength, cross, circle, message.level);
+        return;
+    }
+
+    // First come first served among the ones waiting for the same board
+    for (size_t i = 0; i < waitingPlayers.size(); i++)
+    {
+        WaitingPlayer waiting = waitingPlayers[i];
+        if (waiting.size != message.size || waiting.winLength != message.winLength)
+            continue;
+
+        waitingPlayers.erase(waitingPlayers.begin() + i);
+
+        u32 cross  = waiting.player == 0 ? waiting.connection : connection;
+        u32 circle = waiting.player == 0 ? connection : waiting.connection;
+        CreateMatch(message.size, message.winLength, cross, circle, HUMAN_OPPONENT);
+        return;
+    }
+
+    waitingPlayers.push_back({ connection, message.size, message.winLength, message.player });
+}
+
+u32 GameServer::CreateMatch(s32 size, s32 winLength, u32 cross, u32 circle, u8 level)
+{
+    // 0 is never a match so clients can use it for "none"
+    if (++nextMatch == 0)
+        nextMatch = 1;
+
+    u32 id = nextMatch;
+    ServerMatch& entry = matches[id];
+    entry.match.Start(size, winLength);
+    entry.connections[0] = cross;
+    entry.connections[1] = circle;
+    entry.level          = level;
+    entry.humans         = (cross != NO_CONNECTION ? 1 : 0) | (circle != NO_CONNECTION ? 2 : 0);
+    entry.thinking       = false;
+
+    if (journaling)
+        journal.LogStart(id, size, winLength, level, entry.humans);
+
+    stats.liveMatches++;
+    stats.matchesStarted++;
+
+    for (s32 side = 0; side < 2; side++)
+    {
+        u32 connection = entry.connections[side];
+        if (connection == NO_CONNECTION)
+            continue;
+
+        if (side == 0 || connection != cross)
+            connections[connection].matches.push_back(id);
+
+        Message reply = {};
+        reply.type      = MessageType::STARTED;
+        reply.match     = id;
+        reply.size      = (u8) size;
+        reply.winLength = (u8) winLength;
+        reply.player    = (u8) side;
+        Send(connection, reply);
+    }
+
+    if (!(entry.humans & 1))
+        QueueComputerMove(id, entry);
+
+    return id;
+}
+
+static bool PlaysIn(const ServerMatch& entry, u32 connection)
+{
+    return entry.connections[0] == connection || entry.connections[1] == connection;
+}
+
+void GameServer::PlaceForClient(u32 connection, const Message& message)
+{
+    auto it = matches.find(message.match);
+    if (it == matches.end() || !PlaysIn(it->second, connection))
+    {
+        SendError(connection, message.match, ProtocolError::NO_SUCH_MATCH);
+        return;
+    }
+
+    ServerMatch& entry = it->second;
+    s32 side = entry.match.board.playerIndex;
+    if (entry.thinking || entry.connections[side] != connection ||
+        message.moveNumber != entry.match.board.moveCount)
+    {
+        SendError(connection, message.match, ProtocolError::NOT_YOUR_TURN);
+        return;
+    }
+
+    if (!entry.match.Play(message.cell))
+    {
+        SendError(connection, message.match, ProtocolError::ILLEGAL_MOVE);
+        return;
+    }
+
+    // Logged but not waited on, the reply goes out before it's on disk
+    if (journaling)
+        journal.LogMove(message.match, message.cell, message.moveNumber);
+
+    stats.moves++;
+    connections[connection].pendingAcks++;
+    SendState(message.match, entry);
+
+    if (entry.match.IsOver())
+        EndMatch(message.match);
+    else if (!(entry.humans & (1 << (1 - side))))
+        QueueComputerMove(message.match, entry);
+}
+
+void GameServer::Resign(u32 connection, const Message& message)
+{
+    auto it = matches.find(message.match);
+    if (it == matches.end() || !PlaysIn(it->second, connection))
+    {
+        SendError(connection, message.match, ProtocolError::NO_SUCH_MATCH);
+        return;
+    }
+
+    // Playing both sides, it's the one to move that gives up
+    ServerMatch& entry = it->second;
+    s32 side = entry.connections[0] == connection ? 0 : 1;
+    if (entry.connections[0] == entry.connections[1])
+        side = entry.match.board.playerIndex;
+
+    entry.match.status = side == 0 ? MatchStatus::CIRCLE_WON : MatchStatus::CROSS_WON;
+    entry.match.lastMove = -1;
+    SendState(message.match, entry);
+    EndMatch(message.match);
+}
+
+void GameServer::Resume(u32 connection, const Message& message)
+{
+    auto it = matches.find(message.match);
+    if (it == matches.end() || message.player > 1 || !(it->second.humans & (1 << message.player)) ||
+        it->second.connections[message.player] != NO_CONNECTION)
+    {
+        SendError(connection, message.match, ProtocolError::NO_SUCH_MATCH);
+        return;
+    }
+
+    ServerMatch& entry = it->second;
+    if (!PlaysIn(entry, connection))
+    {
+        if (connections[connection].matches.size() >= maxMatchesPerConnection)
+        {
+            SendError(connection, message.match, ProtocolError::TOO_MANY_MATCHES);
+            return;
+        }
+
+        connections[connection].matches.push_back(message.match);
+    }
+
+    entry.connections[message.player] = connection;
+
+    const Board& board = entry.match.board;
+
+    Message reply = {};
+    reply.type      = MessageType::STARTED;
+    reply.match     = message.match;
+    reply.size      = (u8) board.size;
+    reply.winLength = (u8) board.winLength;
+    reply.player    = message.player;
+    Send(connection, reply);
+
+    // Only the position was kept, not the order the moves came in. Taking
+    // crosses and circles in turn gets to the same place, and since lines
+    // only ever grow nobody had won anywhere along the way.
+    std::vector<u16> placed[2];
+    for (s32 cell = 0; cell < board.numCells; cell++)
+    {
+        if (board.cells[cell] != CellElement::EMPTY)
+            placed[(s32) board.cells[cell]].push_back((u16) cell);
+    }
+
+    Message state = {};
+    state.type   = MessageType::STATE;
+    state.match  = message.match;
+    state.status = (u8) MatchStatus::PLAYING;
+
+    for (s32 move = 0; move < board.moveCount; move++)
+    {
+        state.moveNumber = (u16) (move + 1);
+        state.cell       = placed[move % 2][move / 2];
+        Send(connection, state);
+    }
+}
+
+bool GameServer::Recover()
+{
+    std::unordered_map<u32, JournaledMatch> recovered;
+    if (!journal.Open(journalPath, recovered, nextMatch))
+        return false;
+
+    journaling = true;
+
+    for (auto& pair : recovered)
+    {
+        const JournaledMatch& journaled = pair.second;
+
+        // Its last move got to disk but the end of the match didn't
+        if (journaled.match.IsOver())
+        {
+            journal.LogEnd(pair.first, journaled.match.status);
+            continue;
+        }
+
+        ServerMatch& entry = matches[pair.first];
+        entry.match          = journaled.match;
+        entry.connections[0] = NO_CONNECTION;
+        entry.connections[1] = NO_CONNECTION;
+        entry.level          = journaled.level;
+        entry.humans         = journaled.humans;
+        entry.thinking       = false;
+
+        stats.liveMatches++;
+
+        if (!(entry.humans & (1 << entry.match.board.playerIndex)))
+            QueueComputerMove(pair.first, entry);
+    }
+
+    recoveredMatches = (u32) matches.size();
+    lastSnapshot = Now();
+    return true;
+}
+
+void GameServer::TakeSnapshot()
+{
+    journal.BeginSnapshot(nextMatch, (u32) matches.size());
+
+    for (const auto& pair : matches)
+        journal.AddToSnapshot(pair.first, pair.second.match, pair.second.level, pair.second.humans);
+
+    journal.EndSnapshot();
+    lastSnapshot = Now();
+}
+
+void GameServer::Watch(u32 index, const Message& message)
+{
+    auto it = matches.find(message.match);
+    if (it == matches.end())
+    {
+        SendError(index, message.match, ProtocolError::NO_SUCH_MATCH);
+        return;
+    }
+
+    ServerConnection& connection = connections[index];
+    if (std::find(connection.watching.begin(), connection.watching.end(), message.match) != connection.watching.end())
+        return;
+
+    if (connection.watching.size() >= MAX_WATCHES)
+    {
+        SendError(index, message.match, ProtocolError::TOO_MANY_MATCHES);
+        return;
+    }
+
+    SpectatorFeed& feed = feeds[message.match];
+    if (feed.watchers.empty())
+        feed.Start(message.match, it->second.match);
+
+    feed.watchers.push_back(index);
+    connection.watching.push_back(message.match);
+    stats.spectators++;
+
+    if (connection.spectating.data.empty())
+        connection.spectating.Init(SPECTATOR_RING_SIZE);
+
+    Spectate(index, feed.keyframe);
+    Spectate(index, feed.deltas);
+}
+
+void GameServer::StopWatching(u32 index, u32 match)
+{
+    std::vector<u32>& watching = connections[index].watching;
+    auto watched = std::find(watching.begin(), watching.end(), match);
+    if (watched != watching.end())
+        watching.erase(watched);
+
+    auto it = feeds.find(match);
+    if (it == feeds.end())
+        return;
+
+    std::vector<u32>& watchers = it->second.watchers;
+    auto watcher = std::find(watchers.begin(), watchers.end(), index);
+    if (watcher == watchers.end())
+        return;
+
+    *watcher = watchers.back();
+    watchers.pop_back();
+    stats.spectators--;
+
+    if (watchers.empty())
+        feeds.erase(it);
+}
+
+// The move is encoded once and the same bytes go to every viewer
+void GameServer::Broadcast(u32 match, const ServerMatch& entry)
+{
+    SpectatorFeed& feed = feeds[match];
+    feed.AddMove(match, entry.match);
+
+    for (u32 watcher : feed.watchers)
+        Spectate(watcher, feed.latest);
+
+    stats.spectatorFrames++;
+}
+
+void GameServer::Spectate(u32 index, const std::vector<u8>& bytes)
+{
+    ServerConnection& connection = connections[index];
+    if (connection.behind)
+        return;
+
+    if (!connection.spectating.Push(bytes.data(), bytes.size()))
+    {
+        connection.behind = true;
+        stats.catchUps++;
+        return;
+    }
+
+    stats.spectatorBytes += bytes.size();
+    MarkDirty(index);
+}
+
+// False if the connection was closed
+bool GameServer::SendSpectating(u32 index)
+{
+    ServerConnection& connection = connections[index];
+    SpectatorRing& ring = connection.spectating;
+
+    while (true)
+    {
+        if (ring.used == 0 && connection.behind)
+            CatchUp(index);
+
+        size_t size;
+        const u8* bytes = ring.Peek(size);
+        if (size == 0)
+            return true;
+
+        s32 sent = SendSome(connection.socket, bytes, (s32) size);
+        if (sent < 0)
+        {
+            Close(index);
+            return false;
+        }
+
+        if (sent == 0)
+            return true;
+
+        ring.Pop(sent);
+    }
+}
+
+// Called with the ring empty, so whole frames are all that were dropped
+void GameServer::CatchUp(u32 index)
+{
+    ServerConnection& connection = connections[index];
+    connection.behind = false;
+
+    // Only the final boards of ones that ended, there's nothing to catch up on there
+    if (connection.missedEnds.size() <= connection.spectating.data.size())
+        connection.spectating.Push(connection.missedEnds.data(), connection.missedEnds.size());
+
+    connection.missedEnds.clear();
+
+    for (u32 match : connection.watching)
+    {
+        const SpectatorFeed& feed = feeds[match];
+        if (!connection.spectating.Push(feed.keyframe.data(), feed.keyframe.size()) ||
+            !connection.spectating.Push(feed.deltas.data(), feed.deltas.size()))
+        {
+            connection.behind = true;
+            return;
+        }
+    }
+}
+
+void GameServer::QueueComputerMove(u32 match, ServerMatch& entry)
+{
+    const Board& board = entry.match.board;
+    entry.thinking = true;
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back({ match, board.size, board.winLength, board.playerIndex, entry.level, board.cells });
+    }
+
+    jobReady.notify_one();
+}
+
+void GameServer::TakeResults()
+{
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        resultsTaken.swap(results);
+    }
+
+    for (const MoveResult& result : resultsTaken)
+    {
+        // The client may have resigned or gone away in the meantime
+        auto it = matches.find(result.match);
+        if (it == matches.end() || it->second.match.board.moveCount != result.moveCount)
+            continue;
+
+        ServerMatch& entry = it->second;
+        entry.thinking = false;
+
+        if (!entry.match.Play(result.move))
+            continue;
+
+        if (journaling)
+            journal.LogMove(result.match, result.move, result.moveCount);
+
+        stats.moves++;
+        SendState(result.match, entry);
+
+        if (entry.match.IsOver())
+            EndMatch(result.match);
+    }
+
+    resultsTaken.clear();
+}
+
+void GameServer::EndMatch(u32 match)
+{
+    auto it = matches.find(match);
+    if (it == matches.end())
+        return;
+
+    for (s32 side = 0; side < 2; side++)
+    {
+        u32 connection = it->second.connections[side];
+        if (connection == NO_CONNECTION)
+            continue;
+
+        std::vector<u32>& owned = connections[connection].matches;
+        for (size_t i = 0; i < owned.size(); i++)
+        {
+            if (owned[i] == match)
+            {
+                owned[i] = owned.back();
+                owned.pop_back();
+                break;
+            }
+        }
+    }
+
+    if (journaling)
+        journal.LogEnd(match, it->second.match.status);
+
+    auto feed = feeds.find(match);
+    if (feed != feeds.end())
+    {
+        bool encoded = false;
+
+        for (u32 watcher : feed->second.watchers)
+        {
+            ServerConnection& connection = connections[watcher];
+            connection.watching.erase(std::find(connection.watching.begin(), connection.watching.end(), match));
+
+            // The last STATE never made it into its ring, so it gets the final board
+            if (connection.behind)
+            {
+                if (!encoded)
+                    feed->second.Start(match, it->second.match);
+
+                encoded = true;
+                const std::vector<u8>& board = feed->second.keyframe;
+                connection.missedEnds.insert(connection.missedEnds.end(), board.begin(), board.end());
+            }
+        }
+
+        stats.spectators -= feed->second.watchers.size();
+        feeds.erase(feed);
+    }
+
+    matches.erase(it);
+    stats.liveMatches--;
+    stats.matchesFinished++;
+}
+
+void GameServer::Work()
+{
+    // Everything a search touches belongs to this thread
+    TranspositionTable table;
+    table.Init(16);
+
+    Searcher searcher = {};
+    searcher.table = &table;
+
+    ComputerPlayer computers[NUM_LEVELS];
+    for (s32 level = 0; level < NUM_LEVELS; level++)
+    {
+        computers[level].Parse(GetLevelSpec(level));
+        computers[level].network = network;
+    }
+
+    Random random;
+    random.Seed((u64) std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    Board board = {};
+
+    while (true)
+    {
+        MoveJob job;
+
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+            if (stopping)
+                return;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        if (board.size != job.size || board.winLength != job.winLength || board.cells.empty())
+            board.Init(job.size, job.winLength);
+
+        board.SetPosition(job.cells.data(), job.playerIndex);
+
+        // Fresh table so a level always plays the same move in the same position
+        table.Clear();
+        s32 move = computers[job.level].ChooseMove(board, searcher, random);
+
+        bool wasEmpty;
+
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            wasEmpty = results.empty();
+            results.push_back({ job.match, board.moveCount, move });
+        }
+
+        // One wake up is enough for everything queued before the loop gets to it
+        if (wasEmpty)
+            Wake();
+    }
+}
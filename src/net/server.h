@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "universal/types.h"
+#include "platform/socket.h"
+#include "game/match.h"
+#include "game/nnue.h"
+#include "protocol.h"
+#include "journal.h"
+#include "broadcast.h"
+
+// Counters for the stats line, safe to read from any thread
+struct ServerStats
+{
+    std::atomic<u64> connections;       // Open right now
+    std::atomic<u64> liveMatches;
+    std::atomic<u64> matchesStarted;
+    std::atomic<u64> matchesFinished;
+    std::atomic<u64> moves;             // Both sides
+    std::atomic<u64> acks;              // Client moves acknowledged
+    std::atomic<u64> ackMicros;         // Total time from reading a move to sending its STATE
+    std::atomic<u64> ackMaxMicros;
+    std::atomic<u64> errors;
+    std::atomic<u64> spectators;        // Watching right now, counted once per match
+    std::atomic<u64> spectatorFrames;   // Encoded for spectators, once for all of them
+    std::atomic<u64> spectatorBytes;    // Sent to spectators
+    std::atomic<u64> catchUps;          // Spectators that fell behind
+};
+
+struct ServerConnection
+{
+    Socket socket;
+    std::vector<u8> in;
+    std::vector<u8> out;
+    size_t outStart;            // Bytes of out already sent
+    std::vector<u32> matches;
+    u32 pendingAcks;            // STATE replies to client moves not sent yet
+    f64 oldestAck;              // When the first of those moves was read
+    bool waitingToWrite;
+    bool dirty;                 // Has something in out
+    bool open;
+
+    std::vector<u32> watching;
+    SpectatorRing spectating;
+    std::vector<u8> missedEnds; // BOARDs of watched matches that ended while it was behind
+    bool behind;                // Ring overflowed, gets keyframes once it has drained
+};
+
+const u32 NO_CONNECTION = ~0U;
+
+struct ServerMatch
+{
+    Match match;
+    u32 connections[2];         // For each side, NO_CONNECTION if nobody is playing it
+    u8  level;
+    u8  humans;                 // Bit per side, set for the sides clients play
+    bool thinking;              // A worker has the position
+};
+
+// A client waiting for someone to play against
+struct WaitingPlayer
+{
+    u32 connection;
+    u8  size;
+    u8  winLength;
+    u8  player;
+};
+
+// A computer move to work out. The worker gets a copy of the
+// position, the event loop keeps the match.
+struct MoveJob
+{
+    u32 match;
+    s32 size;
+    s32 winLength;
+    s32 playerIndex;
+    u8  level;
+    std::vector<CellElement> cells;
+};
+
+struct MoveResult
+{
+    u32 match;
+    s32 moveCount;              // Position the move was worked out for
+    s32 move;
+};
+
+// Hosts any number of matches between clients and the computer, or
+// between two clients with the server passing moves along. One thread
+// runs the event loop and owns every match and connection, so none of that
+// needs locks. Computer moves go to a pool of workers and come back through
+// a queue, the loop never waits on a search.
+struct GameServer
+{
+    Poller poller;
+    Socket listener;
+    Socket wakeSockets[2];      // Workers write to [1] to wake the loop up on [0]
+
+    std::vector<ServerConnection> connections;
+    std::vector<u32> freeConnections;
+    std::vector<u32> dirtyConnections;
+    std::unordered_map<u32, ServerMatch> matches;
+    std::vector<WaitingPlayer> waitingPlayers;
+    std::unordered_map<u32, SpectatorFeed> feeds;  // Only for matches someone is watching
+    u32 nextMatch;
+    u32 maxMatchesPerConnection;
+
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::deque<MoveJob> jobs;
+    std::mutex resultMutex;
+    std::vector<MoveResult> results;
+    std::vector<MoveResult> resultsTaken;
+
+    const Network* network;     // Can be null
+    const char* journalPath;    // Can be null, nothing is kept across restarts then
+    f64 snapshotSeconds;
+    Journal journal;
+    bool journaling;
+    f64 lastSnapshot;
+    u32 recoveredMatches;
+
+    std::vector<std::thread> workers;
+    std::thread loopThread;
+    std::atomic<bool> stopping;
+    ServerStats stats;
+
+    // Starts the event loop and numWorkers workers and returns right away.
+    // Set network, journalPath, snapshotSeconds (0 for 10) and
+    // maxMatchesPerConnection (0 for 4096) first. With a journal, the
+    // matches that were live when the server last stopped are brought back
+    // waiting for their clients to RESUME them.
+    bool Start(u16 port, s32 numWorkers, bool localOnly = false);
+    void Stop();
+
+    u16 GetPort() const;
+
+    void Loop();
+    void Work();
+    void Wake();
+
+    void Accept();
+    void Read(u32 connection, f64 receivedAt);
+    void Flush(u32 connection);
+    void Close(u32 connection);
+    void MarkDirty(u32 connection);
+    void Send(u32 connection, const Message& message);
+    void SendError(u32 connection, u32 match, ProtocolError error);
+    void SendState(u32 match, const ServerMatch& entry);
+
+    void Handle(u32 connection, const Message& message);
+    void StartMatch(u32 connection, const Message& message);
+    u32  CreateMatch(s32 size, s32 winLength, u32 cross, u32 circle, u8 level);
+    void PlaceForClient(u32 connection, const Message& message);
+    void Resign(u32 connection, const Message& message);
+    void Resume(u32 connection, const Message& message);
+    bool Recover();
+    void TakeSnapshot();
+
+    void Watch(u32 connection, const Message& message);
+    void StopWatching(u32 connection, u32 match);
+    void Broadcast(u32 match, const ServerMatch& entry);
+    void Spectate(u32 connection, const std::vector<u8>& bytes);
+    bool SendSpectating(u32 connection);
+    void CatchUp(u32 connection);
+    void QueueComputerMove(u32 match, ServerMatch& entry);
+    void TakeResults();
+    void EndMatch(u32 match);
+};
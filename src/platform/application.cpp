@@ -30,6 +30,12 @@ void Application::CursorPositionCallback(GLFWwindow* window, f64 xpos, f64 ypos)
     app->mouseY = ypos / app->screenHeight * app->refScreenHeight;
 }
 
+void Application::ScrollCallback(GLFWwindow* window, f64 xoffset, f64 yoffset)
+{
+    Application* app = (Application*) glfwGetWindowUserPointer(window);
+    app->scrollY += yoffset;
+}
+
 void Application::FramebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
     Application* app = (Application*) glfwGetWindowUserPointer(window);
@@ -60,6 +66,7 @@ Application::Application(const char title[], int width, int height, bool fullscr
     refScreenWidth  = screenWidth  = width;
     refScreenHeight = screenHeight = height;
     vsyncOn = false;
+    scrollY = 0.0;
 
     onInit = onUpdate = onRender = DoNothing;
 
@@ -67,6 +74,7 @@ Application::Application(const char title[], int width, int height, bool fullscr
 
     glfwSetWindowUserPointer(window, this);
     glfwSetCursorPosCallback(window, CursorPositionCallback);
+    glfwSetScrollCallback(window, ScrollCallback);
     glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
 
     if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress))
@@ -120,6 +128,7 @@ void Application::Run()
     onInit(this);
 
     f64 prevTime = glfwGetTime();
+    inputTime = presentTime = prevTime;
 
     while (!glfwWindowShouldClose(window))
     {
@@ -133,7 +142,11 @@ void Application::Run()
         onRender(this);
 
         glfwSwapBuffers(window);
+        presentTime = glfwGetTime();
+
+        scrollY = 0.0;
         glfwPollEvents();
+        inputTime = glfwGetTime();
 
         prevTime = time;
     }
@@ -34,8 +34,11 @@ struct Application
     bool vsyncOn;
 
     f64 mouseX, mouseY;
+    f64 scrollY;        // Mouse wheel movement since the last frame, up is positive
     f64 deltaTime;
     f64 time;
+    f64 inputTime;      // When the input handled this frame was polled
+    f64 presentTime;    // When the last frame finished swapping buffers
 
     void (*onInit)(Application* app);
     void (*onUpdate)(Application* app);
@@ -45,5 +48,6 @@ struct Application
     static bool Initialize();
     static void DoNothing(Application*);
     static void CursorPositionCallback(GLFWwindow* window, f64 xpos, f64 ypos);
+    static void ScrollCallback(GLFWwindow* window, f64 xoffset, f64 yoffset);
     static void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
 };
\ No newline at end of file
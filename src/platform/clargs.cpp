@@ -1,11 +1,14 @@
 #include "clargs.h"
 
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 
 CL_Args ParseCommandLineArguments(int argc, const char* argv[])
 {
     CL_Args args = { 0 };
+    args.host = "127.0.0.1";
+    args.port = 7474;
 
     for (int i = 1; i < argc; i++)
     {
@@ -23,6 +26,18 @@ CL_Args ParseCommandLineArguments(int argc, const char* argv[])
                 continue;
             }
 
+            if (strcmp(argv[i], "-host") == 0 && i + 1 < argc)
+            {
+                args.host = argv[++i];
+                continue;
+            }
+
+            if (strcmp(argv[i], "-port") == 0 && i + 1 < argc)
+            {
+                args.port = atoi(argv[++i]);
+                continue;
+            }
+
             std::cout << "Flag '" << argv[i] << "' not recognised" << std::endl;
         }
         else
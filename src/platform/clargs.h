@@ -4,6 +4,8 @@ struct CL_Args
 {
     bool debug;
     bool fullscreen;
+    const char* host;   // Game server for online games
+    int port;
 };
 
 CL_Args ParseCommandLineArguments(int argc, const char* argv[]);
\ No newline at end of file
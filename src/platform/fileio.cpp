@@ -2,6 +2,13 @@
 
 #include <stdio.h>
 #include <fstream>
+#ifdef _WIN32
+    #include <io.h>
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
 #include <string>
 #include <vector>
 #include "universal/types.h"
@@ -45,4 +52,45 @@ std::vector<Byte> LoadBinaryFile(const char filepath[])
 
     fclose(file);
     return std::move(contents);
-}
\ No newline at end of file
+}
+
+bool FlushToDisk(FILE* file)
+{
+    if (fflush(file) != 0)
+        return false;
+
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool RenameFile(const char from[], const char to[])
+{
+#ifdef _WIN32
+    // rename won't overwrite on Windows
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+bool SeekFile(FILE* file, u64 offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, (s64) offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t) offset, SEEK_SET) == 0;
+#endif
+}
+
+u64 GetFileLength(FILE* file)
+{
+#ifdef _WIN32
+    _fseeki64(file, 0, SEEK_END);
+    return (u64) _ftelli64(file);
+#else
+    fseeko(file, 0, SEEK_END);
+    return (u64) ftello(file);
+#endif
+}
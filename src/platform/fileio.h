@@ -1,8 +1,20 @@
 #pragma once
 
+#include <cstdio>
 #include <string>
 #include <vector>
 #include "universal/types.h"
 
 std::string LoadFile(const char filepath[]);
-std::vector<Byte> LoadBinaryFile(const char filepath[]);
\ No newline at end of file
+std::vector<Byte> LoadBinaryFile(const char filepath[]);
+
+// Flushes file and waits until the OS has it on disk
+bool FlushToDisk(FILE* file);
+
+// Moves from over to, replacing to if it exists
+bool RenameFile(const char from[], const char to[]);
+// 64 bit offsets, plain fseek stops at 2 GB on Windows
+bool SeekFile(FILE* file, u64 offset);
+
+// Leaves the position at the end
+u64 GetFileLength(FILE* file);
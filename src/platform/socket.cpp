@@ -0,0 +1,315 @@
+#include "socket.h"
+
+#include <vector>
+#include "universal/types.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+
+    typedef int socklen_t;
+    #define poll WSAPoll
+#else
+    #include <arpa/inet.h>
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+
+    #ifdef __linux__
+        #include <sys/epoll.h>
+    #endif
+#endif
+
+#ifdef MSG_NOSIGNAL
+    #define SEND_FLAGS MSG_NOSIGNAL
+#else
+    #define SEND_FLAGS 0
+#endif
+
+static bool WouldBlock()
+{
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+bool InitSockets()
+{
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+Socket ListenTcp(u16 port, bool localOnly, s32 backlog)
+{
+    Socket listener = (Socket) socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == NO_SOCKET)
+        return NO_SOCKET;
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*) &reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(localOnly ? INADDR_LOOPBACK : INADDR_ANY);
+
+    if (bind(listener, (const sockaddr*) &address, sizeof(address)) != 0 || listen(listener, backlog) != 0)
+    {
+        CloseSocket(listener);
+        return NO_SOCKET;
+    }
+
+    return listener;
+}
+
+Socket AcceptTcp(Socket listener)
+{
+    Socket client = (Socket) accept(listener, nullptr, nullptr);
+    return client;
+}
+
+Socket ConnectTcp(const char host[], u16 port)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0 || !found)
+        return NO_SOCKET;
+
+    sockaddr_in address = *(const sockaddr_in*) found->ai_addr;
+    address.sin_port = htons(port);
+    freeaddrinfo(found);
+
+    Socket connection = (Socket) socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (connection == NO_SOCKET)
+        return NO_SOCKET;
+
+    if (connect(connection, (const sockaddr*) &address, sizeof(address)) != 0)
+    {
+        CloseSocket(connection);
+        return NO_SOCKET;
+    }
+
+    return connection;
+}
+
+u16 GetLocalPort(Socket socket)
+{
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    getsockname(socket, (sockaddr*) &address, &length);
+    return ntohs(address.sin_port);
+}
+
+void SetNonBlocking(Socket socket)
+{
+#ifdef _WIN32
+    u_long enable = 1;
+    ioctlsocket(socket, FIONBIO, &enable);
+#else
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+void SetNoDelay(Socket socket)
+{
+    int enable = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*) &enable, sizeof(enable));
+}
+
+void CloseSocket(Socket socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+s32 SendSome(Socket socket, const void* data, s32 size)
+{
+    s32 sent = (s32) send(socket, (const char*) data, size, SEND_FLAGS);
+    if (sent < 0)
+        return WouldBlock() ? 0 : -1;
+
+    return sent;
+}
+
+s32 RecvSome(Socket socket, void* data, s32 size)
+{
+    s32 received = (s32) recv(socket, (char*) data, size, 0);
+    if (received < 0)
+        return WouldBlock() ? 0 : -1;
+
+    // 0 from recv means the other side closed the connection
+    return received == 0 ? -1 : received;
+}
+
+bool MakeSocketPair(Socket pair[2])
+{
+    Socket listener = ListenTcp(0, true, 1);
+    if (listener == NO_SOCKET)
+        return false;
+
+    pair[0] = ConnectTcp("127.0.0.1", GetLocalPort(listener));
+    pair[1] = pair[0] != NO_SOCKET ? AcceptTcp(listener) : NO_SOCKET;
+    CloseSocket(listener);
+
+    if (pair[1] == NO_SOCKET)
+    {
+        if (pair[0] != NO_SOCKET)
+            CloseSocket(pair[0]);
+
+        return false;
+    }
+
+    SetNoDelay(pair[0]);
+    SetNoDelay(pair[1]);
+    return true;
+}
+
+#ifdef __linux__
+
+bool Poller::Init()
+{
+    epollFd = epoll_create1(0);
+    return epollFd >= 0;
+}
+
+void Poller::Free()
+{
+    close(epollFd);
+}
+
+static void Control(int epollFd, int operation, Socket socket, u64 data, bool wantWrite)
+{
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? (u32) EPOLLOUT : 0u);
+    event.data.u64 = data;
+    epoll_ctl(epollFd, operation, socket, &event);
+}
+
+void Poller::Add(Socket socket, u64 data, bool wantWrite)
+{
+    Control(epollFd, EPOLL_CTL_ADD, socket, data, wantWrite);
+}
+
+void Poller::Modify(Socket socket, u64 data, bool wantWrite)
+{
+    Control(epollFd, EPOLL_CTL_MOD, socket, data, wantWrite);
+}
+
+void Poller::Remove(Socket socket)
+{
+    epoll_event unused = {};
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, socket, &unused);
+}
+
+s32 Poller::Wait(PollEvent events[], s32 maxEvents, s32 timeoutMs)
+{
+    epoll_event ready[256];
+    if (maxEvents > 256)
+        maxEvents = 256;
+
+    s32 count = epoll_wait(epollFd, ready, maxEvents, timeoutMs);
+    for (s32 i = 0; i < count; i++)
+    {
+        events[i].data     = ready[i].data.u64;
+        events[i].readable = (ready[i].events & EPOLLIN) != 0;
+        events[i].writable = (ready[i].events & EPOLLOUT) != 0;
+        events[i].closed   = (ready[i].events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) != 0;
+    }
+
+    return count < 0 ? 0 : count;
+}
+
+#else
+
+bool Poller::Init()
+{
+    entries.clear();
+    return true;
+}
+
+void Poller::Free()
+{
+    entries.clear();
+}
+
+void Poller::Add(Socket socket, u64 data, bool wantWrite)
+{
+    entries.push_back({ socket, data, wantWrite });
+}
+
+void Poller::Modify(Socket socket, u64 data, bool wantWrite)
+{
+    for (Entry& entry : entries)
+    {
+        if (entry.socket == socket)
+        {
+            entry.data = data;
+            entry.wantWrite = wantWrite;
+            return;
+        }
+    }
+}
+
+void Poller::Remove(Socket socket)
+{
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (entries[i].socket == socket)
+        {
+            entries[i] = entries.back();
+            entries.pop_back();
+            return;
+        }
+    }
+}
+
+s32 Poller::Wait(PollEvent events[], s32 maxEvents, s32 timeoutMs)
+{
+    std::vector<pollfd> fds(entries.size());
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        fds[i].fd = entries[i].socket;
+        fds[i].events = POLLIN | (entries[i].wantWrite ? POLLOUT : 0);
+        fds[i].revents = 0;
+    }
+
+    if (poll(fds.data(), (unsigned long) fds.size(), timeoutMs) <= 0)
+        return 0;
+
+    s32 count = 0;
+    for (size_t i = 0; i < fds.size() && count < maxEvents; i++)
+    {
+        if (fds[i].revents == 0)
+            continue;
+
+        events[count].data     = entries[i].data;
+        events[count].readable = (fds[i].revents & POLLIN) != 0;
+        events[count].writable = (fds[i].revents & POLLOUT) != 0;
+        events[count].closed   = (fds[i].revents & (POLLHUP | POLLERR | POLLNVAL)) != 0;
+        count++;
+    }
+
+    return count;
+}
+
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "universal/types.h"
+
+// Thin layer over BSD sockets and Winsock so the server and clients don't
+// need to know which one they're on. Only TCP, only what the game uses.
+
+#ifdef _WIN32
+typedef uintptr_t Socket;
+#else
+typedef int Socket;
+#endif
+
+const Socket NO_SOCKET = (Socket) ~(Socket) 0;
+
+// Call once before anything else, Winsock needs it
+bool InitSockets();
+
+// Listens on every interface, or only loopback when localOnly is set.
+// Port 0 picks a free one, GetLocalPort says which.
+Socket ListenTcp(u16 port, bool localOnly = false, s32 backlog = 1024);
+Socket AcceptTcp(Socket listener);
+Socket ConnectTcp(const char host[], u16 port);
+u16    GetLocalPort(Socket socket);
+
+void SetNonBlocking(Socket socket);
+void SetNoDelay(Socket socket);     // Small messages go out immediately
+void CloseSocket(Socket socket);
+
+// Bytes sent or received. 0 if the socket would block, -1 if the
+// connection is closed or broken.
+s32 SendSome(Socket socket, const void* data, s32 size);
+s32 RecvSome(Socket socket, void* data, s32 size);
+
+// Two connected loopback sockets, other threads write to one to
+// wake up a Poller waiting on the other
+bool MakeSocketPair(Socket pair[2]);
+
+struct PollEvent
+{
+    u64  data;          // Whatever was passed to Add
+    bool readable;
+    bool writable;
+    bool closed;
+};
+
+// Waits on many sockets at once. epoll on Linux, poll (WSAPoll on
+// Windows) everywhere else, which is slower with lots of sockets.
+struct Poller
+{
+#ifdef __linux__
+    int epollFd;
+#else
+    struct Entry
+    {
+        Socket socket;
+        u64 data;
+        bool wantWrite;
+    };
+
+    std::vector<Entry> entries;
+#endif
+
+    bool Init();
+    void Free();
+
+    void Add(Socket socket, u64 data, bool wantWrite = false);
+    void Modify(Socket socket, u64 data, bool wantWrite);
+    void Remove(Socket socket);
+
+    // Returns the number of events filled in, timeout -1 waits forever
+    s32 Wait(PollEvent events[], s32 maxEvents, s32 timeoutMs);
+};
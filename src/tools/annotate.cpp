@@ -0,0 +1,212 @@
+#include "tools.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "universal/types.h"
+#include "game/board.h"
+#include "game/search.h"
+#include "game/nnue.h"
+#include "game/annotate.h"
+
+// Annotates a file of positions, one a line in the format described in
+// src/game/annotate.h, writing one line of results for every line read.
+// Lines are read and written a batch at a time, so files of any size go
+// through in a fixed amount of memory. Blank lines stay blank and lines
+// that aren't a position come out as "error".
+
+// Kind of line in the batch, otherwise an index into the positions
+static const s32 BLANK_LINE = -1;
+static const s32 BAD_LINE   = -2;
+
+// Positions of two variants that use the same cell numbers go through one
+// batch, and so one table, taking turns. Every 3x3 position up to two moves
+// in is solved to the end, so its score has to match a search on its own
+// whatever the 4x4 positions around it left in the table.
+static int RunMixedCheck(s32 numThreads, s32 hashLog2)
+{
+    std::vector<Board> boards;
+    Board small, large;
+    small.Init(3, 3);
+    large.Init(4, 3);
+
+    s32 cells[2];
+    for (s32 plies = 0; plies <= 2; plies++)
+    {
+        for (s32 first = 0; first < (plies > 0 ? 9 : 1); first++)
+        {
+            for (s32 second = 0; second < (plies > 1 ? 9 : 1); second++)
+            {
+                cells[0] = first;
+                cells[1] = second;
+                if (plies > 1 && first == second)
+                    continue;
+
+                small.Clear();
+                large.Clear();
+                for (s32 i = 0; i < plies; i++)
+                {
+                    small.MakeMove(cells[i]);
+                    large.MakeMove(cells[i]);
+                }
+
+                boards.push_back(large);
+                boards.push_back(small);
+            }
+        }
+    }
+
+    SearchLimits limits = {};
+    limits.depth = 9;
+
+    static Annotator annotator;
+    annotator.Init(numThreads, hashLog2, limits, nullptr);
+
+    std::vector<Annotation> results(boards.size());
+    annotator.Analyse(boards.data(), results.data(), (s64) boards.size());
+    annotator.Shutdown();
+
+    u64 mismatches = 0;
+    for (size_t i = 1; i < boards.size(); i += 2)
+    {
+        Searcher searcher = {};
+        SearchResult alone = searcher.Search(boards[i], limits);
+        mismatches += alone.score != results[i].score;
+    }
+
+    printf("positions   %llu\n", (u64) boards.size());
+    printf("mismatches  %llu\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+int RunAnnotate(int argc, const char* argv[])
+{
+    const char* inPath  = GetFlag(argc, argv, "-in", "-");
+    const char* outPath = GetFlag(argc, argv, "-out", "-");
+    s64 batchSize       = GetFlagInt(argc, argv, "-batch", 4096);
+    s32 hashLog2        = (s32) GetFlagInt(argc, argv, "-hash", 22);
+    s32 numThreads      = GetThreadCount(argc, argv);
+
+    SearchLimits limits;
+    limits.depth = (s32) GetFlagInt(argc, argv, "-depth", 0);
+    limits.nodes = (u64) GetFlagInt(argc, argv, "-nodes", 100000);
+    limits.time  = 0.0;
+
+    if (batchSize < 1 || hashLog2 < 10 || hashLog2 > 32)
+    {
+        printf("Invalid batch or hash size\n");
+        return 1;
+    }
+
+    if (HasFlag(argc, argv, "-check"))
+        return RunMixedCheck(numThreads, hashLog2);
+
+    static Network network = {};
+    const char* netPath = GetFlag(argc, argv, "-net", nullptr);
+    if (netPath && !network.Load(netPath))
+    {
+        printf("Failed to load network '%s'\n", netPath);
+        return 1;
+    }
+
+    FILE* in = strcmp(inPath, "-") == 0 ? stdin : fopen(inPath, "rb");
+    FILE* out = strcmp(outPath, "-") == 0 ? stdout : fopen(outPath, "wb");
+    if (!in || !out)
+    {
+        printf("Can't open '%s' or '%s'\n", inPath, outPath);
+        return 1;
+    }
+
+    static Annotator annotator;
+    annotator.Init(numThreads, hashLog2, limits, netPath ? &network : nullptr);
+
+    // Reused for every batch, the boards keep their cells between them
+    std::vector<Board> boards(batchSize);
+    std::vector<Annotation> results(batchSize);
+    std::vector<s32> lines(batchSize);
+    std::string text;
+    char line[8192];
+
+    u64 numPositions = 0, numErrors = 0, nodes = 0;
+    f64 start = GetSeconds();
+    bool atEnd = false;
+
+    while (!atEnd)
+    {
+        s64 numLines = 0, numBoards = 0;
+
+        while (numLines < batchSize)
+        {
+            if (!fgets(line, sizeof(line), in))
+            {
+                atEnd = true;
+                break;
+            }
+
+            // Longer than any real position, the rest of it is thrown away
+            size_t length = strlen(line);
+            bool tooLong = length > 0 && line[length - 1] != '\n' && !feof(in);
+            bool whole = !tooLong;
+            while (!whole && fgets(line, sizeof(line), in))
+            {
+                length = strlen(line);
+                whole = line[length - 1] == '\n';
+            }
+
+            if (tooLong)
+                lines[numLines++] = BAD_LINE;
+            else if (strspn(line, " \t\r\n") == strlen(line))
+                lines[numLines++] = BLANK_LINE;
+            else if (ParsePosition(line, boards[numBoards]))
+                lines[numLines++] = (s32) numBoards++;
+            else
+                lines[numLines++] = BAD_LINE;
+        }
+
+        annotator.Analyse(boards.data(), results.data(), numBoards);
+
+        for (s64 i = 0; i < numLines; i++)
+        {
+            if (lines[i] == BLANK_LINE)
+            {
+                fputs("\n", out);
+                continue;
+            }
+
+            if (lines[i] == BAD_LINE)
+            {
+                fputs("error\n", out);
+                numErrors++;
+                continue;
+            }
+
+            const Annotation& result = results[lines[i]];
+            FormatAnnotation(result, boards[lines[i]].size, text);
+            fputs(text.c_str(), out);
+            fputs("\n", out);
+            nodes += result.nodes;
+        }
+
+        numPositions += numBoards;
+        fflush(out);
+    }
+
+    f64 elapsed = GetSeconds() - start;
+    annotator.Shutdown();
+
+    if (in != stdin)
+        fclose(in);
+    if (out != stdout)
+        fclose(out);
+
+    // Results might be going to stdout, so the numbers go to stderr
+    fprintf(stderr, "positions  %llu\n", numPositions);
+    fprintf(stderr, "errors     %llu\n", numErrors);
+    fprintf(stderr, "threads    %d\n", annotator.numThreads);
+    fprintf(stderr, "time       %.3f s\n", elapsed);
+    fprintf(stderr, "pos/sec    %.0f\n", elapsed > 0.0 ? numPositions / elapsed : 0.0);
+    fprintf(stderr, "nodes/sec  %.0f\n", elapsed > 0.0 ? nodes / elapsed : 0.0);
+
+    return 0;
+}
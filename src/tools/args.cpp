@@ -0,0 +1,56 @@
+#include "tools.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "universal/types.h"
+
+bool HasFlag(int argc, const char* argv[], const char name[])
+{
+    for (int i = 0; i < argc; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+const char* GetFlag(int argc, const char* argv[], const char name[], const char defaultValue[])
+{
+    for (int i = 0; i < argc - 1; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+            return argv[i + 1];
+    }
+
+    return defaultValue;
+}
+
+s64 GetFlagInt(int argc, const char* argv[], const char name[], s64 defaultValue)
+{
+    const char* value = GetFlag(argc, argv, name, nullptr);
+    return value ? strtoll(value, nullptr, 10) : defaultValue;
+}
+
+f64 GetFlagFloat(int argc, const char* argv[], const char name[], f64 defaultValue)
+{
+    const char* value = GetFlag(argc, argv, name, nullptr);
+    return value ? strtod(value, nullptr) : defaultValue;
+}
+
+s32 GetThreadCount(int argc, const char* argv[])
+{
+    s32 threads = (s32) GetFlagInt(argc, argv, "-threads", 0);
+    if (threads <= 0)
+        threads = (s32) std::thread::hardware_concurrency();
+
+    return threads > 0 ? threads : 1;
+}
+
+f64 GetSeconds()
+{
+    using namespace std::chrono;
+    return duration<f64>(steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,174 @@
+#include "tools.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "universal/histogram.h"
+#include "game/board.h"
+#include "game/clock.h"
+#include "game/match.h"
+#include "game/player.h"
+#include "game/search.h"
+
+// Many timed games at once, each on its own thread and usually far more
+// of them than there are cores, so the clocks run under real scheduling
+// pressure. For every move it checks that the clock charged the time that
+// actually went by since the last press, and how far past its budget the
+// search went. Overruns and games lost on time grow with the load, the
+// charged time has to stay right however busy the machine is.
+
+struct ClockedGame
+{
+    Histogram chargeErrors;     // Microseconds between what was charged and what went by
+    Histogram overruns;         // Microseconds a move took over its budget, 0 if it didn't
+    u64 moves;
+    bool flagged;
+};
+
+static void PlayClockedGame(ClockedGame& game, const ComputerPlayer& agent, const TimeControl& control,
+                            s32 size, s32 winLength, u64 seed)
+{
+    TranspositionTable table;
+    table.Init(16);
+
+    Searcher searcher = {};
+    searcher.table = &table;
+
+    Random random;
+    random.Seed(seed);
+
+    game.chargeErrors.Clear();
+    game.overruns.Clear();
+    game.moves = 0;
+    game.flagged = false;
+
+    Match match = {};
+    match.Start(size, winLength);
+    match.StartClock(control);
+
+    const GameClock& clock = match.clock;
+    f64 lastPress = GetMonotonicTime();
+
+    while (!match.IsOver())
+    {
+        s32 side = match.board.playerIndex;
+        s32 movesLeft = (match.board.numCells - match.board.moveCount + 1) / 2;
+
+        f64 before = clock.remaining[side];
+        f64 budget = clock.GetBudget(GetMonotonicTime(), movesLeft);
+
+        table.Clear();
+        s32 move = agent.ChooseMove(match, searcher, random);
+
+        if (!match.Play(move))
+        {
+            game.flagged = match.IsOver();
+            break;
+        }
+
+        // Read straight after the press, so the turn as measured here and as
+        // the clock saw it differ only by the instructions in between
+        f64 now = GetMonotonicTime();
+        f64 used = now - lastPress;
+        lastPress = now;
+
+        // With a fixed time per move the clock starts over, nothing to compare
+        if (control.perMove == 0.0)
+        {
+            f64 error = used - (before + control.increment - clock.remaining[side]);
+            game.chargeErrors.Add((u64) ((error > 0.0 ? error : -error) * 1e6));
+        }
+
+        game.overruns.Add(used > budget ? (u64) ((used - budget) * 1e6) : 0);
+        game.moves++;
+    }
+}
+
+int RunClocks(int argc, const char* argv[])
+{
+    s32 numGames      = (s32) GetFlagInt(argc, argv, "-games", 256);
+    s32 size          = (s32) GetFlagInt(argc, argv, "-size", 7);
+    s32 winLength     = (s32) GetFlagInt(argc, argv, "-win", 5);
+    const char* tc    = GetFlag(argc, argv, "-tc", "2+0.02");
+    const char* spec  = GetFlag(argc, argv, "-agent", "search:nodes=0");
+    u64 seed          = (u64) GetFlagInt(argc, argv, "-seed", 1);
+
+    TimeControl control;
+    if (!control.Parse(tc) || !control.IsTimed())
+    {
+        printf("Invalid time control '%s'\n", tc);
+        return 1;
+    }
+
+    ComputerPlayer agent;
+    if (!agent.Parse(spec))
+    {
+        printf("Invalid agent '%s'\n", spec);
+        return 1;
+    }
+
+    if (numGames < 1 || size < 1 || size > Board::MAX_SIZE || winLength < 1 || winLength > size)
+    {
+        printf("Invalid games, size or win length\n");
+        return 1;
+    }
+
+    // How fine the clock is, the smallest step between two readings
+    f64 resolution = 1.0;
+    for (s32 i = 0; i < 100000; i++)
+    {
+        f64 a = GetMonotonicTime();
+        f64 b;
+        while ((b = GetMonotonicTime()) == a);
+
+        resolution = std::min(resolution, b - a);
+    }
+
+    std::vector<ClockedGame> games(numGames);
+    std::vector<std::thread> threads;
+    f64 start = GetSeconds();
+
+    for (s32 i = 0; i < numGames; i++)
+    {
+        threads.emplace_back(PlayClockedGame, std::ref(games[i]), std::cref(agent), std::cref(control),
+                             size, winLength, seed * 0x9E3779B97F4A7C15ULL + i + 1);
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    f64 elapsed = GetSeconds() - start;
+
+    static Histogram chargeErrors;
+    static Histogram overruns;
+    chargeErrors.Clear();
+    overruns.Clear();
+
+    u64 moves = 0, flagged = 0;
+    for (const ClockedGame& game : games)
+    {
+        chargeErrors.Merge(game.chargeErrors);
+        overruns.Merge(game.overruns);
+        moves += game.moves;
+        flagged += game.flagged ? 1 : 0;
+    }
+
+    printf("games         %d at once on %u cores\n", numGames, std::thread::hardware_concurrency());
+    printf("control       %s\n", tc);
+    printf("agent         %s\n", spec);
+    printf("resolution    %.3f us\n", resolution * 1e6);
+    printf("moves         %llu in %.2f s\n", moves, elapsed);
+    printf("charge p50    %llu us off\n", chargeErrors.Percentile(0.5));
+    printf("charge p99    %llu us off\n", chargeErrors.Percentile(0.99));
+    printf("charge max    %llu us off\n", chargeErrors.max);
+    printf("overrun p50   %llu us\n", overruns.Percentile(0.5));
+    printf("overrun p99   %llu us\n", overruns.Percentile(0.99));
+    printf("overrun max   %llu us\n", overruns.max);
+    printf("lost on time  %llu\n", flagged);
+
+    // Losing on time is down to how busy the machine is, the clock being off isn't
+    return chargeErrors.max < 1000 ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+#include "tools.h"
+
+#include <cstdio>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "game/connect4.h"
+
+// Solves one Connect Four position given as columns from 1, or benchmarks
+// the solver on random positions a number of moves into the game. Early
+// positions are a lot harder: a couple of discs in can take minutes.
+int RunConnectFour(int argc, const char* argv[])
+{
+    const char* moves = GetFlag(argc, argv, "-moves", nullptr);
+    s32 numPositions  = (s32) GetFlagInt(argc, argv, "-bench", 100);
+    s32 plies         = (s32) GetFlagInt(argc, argv, "-plies", 20);
+    s32 hashLog2      = (s32) GetFlagInt(argc, argv, "-hash", 22);
+    u64 seed          = (u64) GetFlagInt(argc, argv, "-seed", 1);
+    bool weak         = HasFlag(argc, argv, "-weak");
+
+    ConnectFourSolver solver;
+    solver.Init(hashLog2);
+
+    if (moves)
+    {
+        ConnectFour position;
+        position.Clear();
+        if (!position.PlaySequence(moves))
+        {
+            printf("Invalid or finished position '%s'\n", moves);
+            return 1;
+        }
+
+        f64 start = GetSeconds();
+        s32 score = 0;
+        s32 column = solver.BestMove(position, &score);
+        f64 elapsed = GetSeconds() - start;
+
+        printf("score       %d\n", score);
+        printf("bestmove    %d\n", column + 1);
+        printf("nodes       %llu\n", solver.nodes);
+        printf("time        %.3f s\n", elapsed);
+        printf("nodes/sec   %.0f\n", elapsed > 0.0 ? solver.nodes / elapsed : 0.0);
+        return 0;
+    }
+
+    if (plies < 0 || plies >= ConnectFour::NUM_CELLS)
+    {
+        printf("Invalid number of plies\n");
+        return 1;
+    }
+
+    // Random games that are still going after plies moves
+    Random random;
+    random.Seed(seed);
+
+    std::vector<ConnectFour> positions;
+    while ((s32) positions.size() < numPositions)
+    {
+        ConnectFour position;
+        position.Clear();
+
+        while (position.moveCount < plies)
+        {
+            s32 column = random.Range(ConnectFour::WIDTH);
+            if (!position.CanPlay(column))
+                continue;
+            if (position.IsWinningMove(column))
+                break;
+
+            position.Play(column);
+        }
+
+        if (position.moveCount == plies)
+            positions.push_back(position);
+    }
+
+    u64 totalNodes = 0;
+    f64 slowest = 0.0;
+    s32 results[3] = {};
+    f64 start = GetSeconds();
+
+    for (const ConnectFour& position : positions)
+    {
+        f64 positionStart = GetSeconds();
+        s32 score = solver.Solve(position, weak);
+        f64 elapsed = GetSeconds() - positionStart;
+
+        totalNodes += solver.nodes;
+        slowest = elapsed > slowest ? elapsed : slowest;
+        results[score < 0 ? 0 : (score == 0 ? 1 : 2)]++;
+    }
+
+    f64 elapsed = GetSeconds() - start;
+
+    printf("%s solve of %d positions after %d moves\n", weak ? "weak" : "strong", numPositions, plies);
+    printf("wins/draws/losses %d / %d / %d for the player to move\n", results[2], results[1], results[0]);
+    printf("nodes       %llu\n", totalNodes);
+    printf("mean nodes  %.0f\n", (f64) totalNodes / numPositions);
+    printf("mean time   %.3f ms\n", elapsed * 1000.0 / numPositions);
+    printf("slowest     %.3f ms\n", slowest * 1000.0);
+    printf("time        %.3f s\n", elapsed);
+    printf("nodes/sec   %.0f\n", elapsed > 0.0 ? totalNodes / elapsed : 0.0);
+
+    return 0;
+}
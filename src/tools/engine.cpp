@@ -0,0 +1,245 @@
+#include "tools.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "universal/types.h"
+#include "game/board.h"
+#include "game/search.h"
+#include "game/nnue.h"
+#include "game/annotate.h"
+
+// Line based protocol on stdin/stdout for driving the computer player
+// from other programs. Cells are written as a column letter and a row
+// number, "a1" being the top left.
+//
+//   ttt                              -> id name ..., tttok
+//   isready                          -> readyok
+//   variant <size> <winLength>       new game on that board
+//   position [moves <cell> ...]      empty board plus these moves, none
+//                                    after one that ends the game
+//   go [depth N] [nodes N] [movetime ms] [infinite]
+//                                    -> info depth D score S nodes N nps N time ms
+//                                    -> bestmove <cell>, or none if the game is over
+//                                    infinite drops any limits before it, the
+//                                    search runs until stop or it's solved
+//   stop                             finish the search now
+//   show                             prints the board
+//   quit
+//
+// Scores are "cp <n>" for heuristic values and "win <plies>" when a
+// forced result was found, negative if the player to move loses.
+
+static struct
+{
+    std::mutex outputMutex;
+    std::atomic<bool> stopSignal;
+    std::thread searchThread;
+
+    Board board;
+    bool gameOver;      // The last move made a line
+    TranspositionTable table;
+    Network network;
+} engine;
+
+static void Send(const char format[], ...)
+{
+    std::lock_guard<std::mutex> lock(engine.outputMutex);
+
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+
+    printf("\n");
+    fflush(stdout);
+}
+
+static std::string ScoreText(s32 score)
+{
+    char buffer[32];
+    if (score >= WIN_SCORE - Board::MAX_MOVES)
+        sprintf(buffer, "win %d", WIN_SCORE - score);
+    else if (score <= -(WIN_SCORE - Board::MAX_MOVES))
+        sprintf(buffer, "win -%d", WIN_SCORE + score);
+    else
+        sprintf(buffer, "cp %d", score);
+
+    return buffer;
+}
+
+static void OnIteration(const SearchResult& result, void* data)
+{
+    f64 elapsed = GetSeconds() - *(f64*) data;
+    u64 nps = elapsed > 0.0 ? (u64) (result.nodes / elapsed) : 0;
+
+    Send("info depth %d score %s nodes %llu nps %llu time %llu pv %s", result.depth,
+         ScoreText(result.score).c_str(), result.nodes, nps, (u64) (elapsed * 1000.0),
+         CellName(result.move, engine.board.size).c_str());
+}
+
+static void StopSearch()
+{
+    engine.stopSignal = true;
+    if (engine.searchThread.joinable())
+        engine.searchThread.join();
+}
+
+static void StartSearch(const SearchLimits& limits)
+{
+    StopSearch();
+
+    if (engine.gameOver || engine.board.IsFull())
+    {
+        Send("bestmove none");
+        return;
+    }
+
+    engine.stopSignal = false;
+    engine.searchThread = std::thread([limits]()
+    {
+        // Searches a copy so the main thread can keep reading commands
+        Board board = engine.board;
+        f64 start = GetSeconds();
+
+        Searcher searcher = {};
+        searcher.table = &engine.table;
+        searcher.network = &engine.network;
+        searcher.stopSignal = &engine.stopSignal;
+        searcher.onIteration = OnIteration;
+        searcher.callbackData = &start;
+
+        SearchResult result = searcher.Search(board, limits);
+        Send("bestmove %s", CellName(result.move, board.size).c_str());
+    });
+}
+
+static void NewGame(s32 size, s32 winLength)
+{
+    StopSearch();
+    engine.board.Init(size, winLength);
+    engine.gameOver = false;
+    engine.table.Clear();
+}
+
+int RunEngine(int argc, const char* argv[])
+{
+    engine.table.Init((s32) GetFlagInt(argc, argv, "-hash", 20));
+    engine.network = {};
+
+    const char* netPath = GetFlag(argc, argv, "-net", nullptr);
+    if (netPath && !engine.network.Load(netPath))
+        Send("info string failed to load network '%s'", netPath);
+
+    NewGame(3, 3);
+
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        std::istringstream stream(line);
+        std::string command;
+        stream >> command;
+
+        if (command == "ttt")
+        {
+            Send("id name Tic Tac Toe");
+            Send("tttok");
+        }
+        else if (command == "isready")
+        {
+            Send("readyok");
+        }
+        else if (command == "variant")
+        {
+            s32 size = 3, winLength = 3;
+            stream >> size >> winLength;
+
+            if (size < 1 || size > Board::MAX_SIZE || winLength < 1)
+                Send("info string invalid variant");
+            else
+                NewGame(size, winLength);
+        }
+        else if (command == "position")
+        {
+            StopSearch();
+            engine.board.Clear();
+            engine.gameOver = false;
+
+            std::string token;
+            stream >> token;
+            if (token != "moves")
+                continue;
+
+            while (stream >> token)
+            {
+                s32 cell = ParseCell(token.c_str(), (s32) token.size(), engine.board.size);
+                if (engine.gameOver || cell < 0 || engine.board.cells[cell] != CellElement::EMPTY)
+                {
+                    Send("info string illegal move %s", token.c_str());
+                    break;
+                }
+
+                engine.board.MakeMove(cell);
+                engine.gameOver = engine.board.WonThrough(cell);
+            }
+        }
+        else if (command == "go")
+        {
+            SearchLimits limits = {};
+            std::string token;
+
+            while (stream >> token)
+            {
+                if (token == "depth")
+                    stream >> limits.depth;
+                else if (token == "nodes")
+                    stream >> limits.nodes;
+                else if (token == "movetime")
+                {
+                    f64 milliseconds = 0.0;
+                    stream >> milliseconds;
+                    limits.time = milliseconds / 1000.0;
+                }
+                else if (token == "infinite")
+                    limits = {};
+            }
+
+            StartSearch(limits);
+        }
+        else if (command == "stop")
+        {
+            StopSearch();
+        }
+        else if (command == "show")
+        {
+            std::lock_guard<std::mutex> lock(engine.outputMutex);
+
+            const Board& board = engine.board;
+            for (s32 row = 0; row < board.size; row++)
+            {
+                for (s32 col = 0; col < board.size; col++)
+                    putchar("XO."[(int) board.cells[row * board.size + col]]);
+                putchar('\n');
+            }
+            fflush(stdout);
+        }
+        else if (command == "quit")
+        {
+            break;
+        }
+        else if (!command.empty())
+        {
+            Send("info string unknown command %s", command.c_str());
+        }
+    }
+
+    StopSearch();
+    return 0;
+}
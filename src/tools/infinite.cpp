@@ -0,0 +1,84 @@
+#include "tools.h"
+
+#include <cstdio>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "game/infinite.h"
+
+// Plays a long random game on the infinite board, the way a community game
+// wanders: mostly next to the last few moves, sometimes somewhere new.
+// Wins are checked after every move but the game goes on regardless.
+int RunInfinite(int argc, const char* argv[])
+{
+    u64 numMoves   = (u64) GetFlagInt(argc, argv, "-moves", 100000);
+    s32 winLength  = (s32) GetFlagInt(argc, argv, "-win", 5);
+    s32 jumpChance = (s32) GetFlagInt(argc, argv, "-jump", 1);
+    s32 jumpSize   = (s32) GetFlagInt(argc, argv, "-spread", 1000);
+    u64 seed       = (u64) GetFlagInt(argc, argv, "-seed", 1);
+
+    InfiniteBoard board;
+    board.Init(winLength);
+
+    Random random;
+    random.Seed(seed);
+
+    s32 x = 0, y = 0;
+    s32 minX = 0, minY = 0, maxX = 0, maxY = 0;
+    u64 wins = 0;
+
+    f64 start = GetSeconds();
+    while (board.moves.size() < numMoves)
+    {
+        if (random.Range(100) < jumpChance)
+        {
+            x += random.Range(2 * jumpSize + 1) - jumpSize;
+            y += random.Range(2 * jumpSize + 1) - jumpSize;
+        }
+        else
+        {
+            x += random.Range(5) - 2;
+            y += random.Range(5) - 2;
+        }
+
+        if (!board.MakeMove(x, y))
+            continue;
+
+        wins += board.WonThrough(x, y) ? 1 : 0;
+
+        minX = x < minX ? x : minX;
+        minY = y < minY ? y : minY;
+        maxX = x > maxX ? x : maxX;
+        maxY = y > maxY ? y : maxY;
+    }
+    f64 elapsed = GetSeconds() - start;
+
+    // Roughly what the hash map holds: a node per chunk plus the buckets
+    u64 chunkBytes = (u64) board.chunks.size() * (sizeof(InfiniteBoard::Chunk) + sizeof(u64) + 2 * sizeof(void*)) +
+                     (u64) board.chunks.bucket_count() * sizeof(void*);
+    u64 historyBytes = (u64) board.moves.capacity() * sizeof(InfiniteElement);
+    f64 denseCells = (f64) (maxX - minX + 1) * (f64) (maxY - minY + 1);
+
+    // Drawing a screenful only touches the chunks it overlaps
+    std::vector<InfiniteElement> visible;
+    f64 viewStart = GetSeconds();
+    const s32 viewRepeat = 1000;
+    for (s32 i = 0; i < viewRepeat; i++)
+    {
+        visible.clear();
+        board.GetElementsIn(x - 50, y - 50, x + 50, y + 50, visible);
+    }
+    f64 viewTime = (GetSeconds() - viewStart) / viewRepeat;
+
+    printf("moves       %llu\n", (u64) board.moves.size());
+    printf("lines won   %llu\n", wins);
+    printf("extent      %d x %d\n", maxX - minX + 1, maxY - minY + 1);
+    printf("chunks      %llu of %dx%d\n", (u64) board.chunks.size(), InfiniteBoard::CHUNK_SIZE, InfiniteBoard::CHUNK_SIZE);
+    printf("chunk bytes %llu (%.1f per move)\n", chunkBytes, (f64) chunkBytes / board.moves.size());
+    printf("history     %llu bytes\n", historyBytes);
+    printf("dense bytes %.0f for the same extent\n", denseCells);
+    printf("moves/sec   %.0f, with a win check each\n", board.moves.size() / elapsed);
+    printf("101x101 view %.1f us, %llu elements\n", viewTime * 1e6, (u64) visible.size());
+
+    return 0;
+}
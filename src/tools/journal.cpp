@@ -0,0 +1,166 @@
+#include "tools.h"
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "game/board.h"
+#include "game/match.h"
+#include "game/player.h"
+#include "net/journal.h"
+
+// Checks the journal the server keeps. Logs a lot of made up matches the
+// way the server would, snapshotting part way through, then recovers them
+// from the snapshot and the log after it and compares every board.
+
+static void Snapshot(Journal& journal, const std::unordered_map<u32, JournaledMatch>& matches, u32 nextMatch)
+{
+    journal.BeginSnapshot(nextMatch, (u32) matches.size());
+
+    for (const auto& pair : matches)
+        journal.AddToSnapshot(pair.first, pair.second.match, pair.second.level, pair.second.humans);
+
+    journal.EndSnapshot();
+}
+
+int RunJournal(int argc, const char* argv[])
+{
+    s64 numMatches  = GetFlagInt(argc, argv, "-matches", 100000);
+    s32 size        = (s32) GetFlagInt(argc, argv, "-size", 3);
+    s32 winLength   = (s32) GetFlagInt(argc, argv, "-win", size);
+    s32 numRounds   = (s32) GetFlagInt(argc, argv, "-moves", 6);
+    const char* path = GetFlag(argc, argv, "-path", "journal_check");
+
+    if (size < 1 || size > Board::MAX_SIZE || winLength < 1 || winLength > size || numMatches < 1)
+    {
+        printf("Invalid size, win length or matches\n");
+        return 1;
+    }
+
+    Random random;
+    random.Seed((u64) GetFlagInt(argc, argv, "-seed", 1));
+
+    static Journal journal;
+    std::unordered_map<u32, JournaledMatch> expected;
+    u32 nextMatch = 0;
+
+    if (!journal.Open(path, expected, nextMatch) || !expected.empty())
+    {
+        printf("'%s' already has a journal or can't be written\n", path);
+        return 1;
+    }
+
+    // Everything starts, then a move in every live match per round. Some
+    // end along the way, the rest are what recovery has to bring back.
+    f64 start = GetSeconds();
+
+    for (s64 i = 0; i < numMatches; i++)
+    {
+        u32 id = ++nextMatch;
+        JournaledMatch& entry = expected[id];
+        entry.match.Start(size, winLength);
+        entry.level  = (u8) random.Range(NUM_LEVELS);
+        entry.humans = (u8) (1 + random.Range(3));
+
+        journal.LogStart(id, size, winLength, entry.level, entry.humans);
+    }
+
+    std::vector<s32> empty;
+    std::vector<u32> ended;
+
+    for (s32 round = 0; round < numRounds; round++)
+    {
+        if (round == numRounds / 2)
+            Snapshot(journal, expected, nextMatch);
+
+        for (auto& pair : expected)
+        {
+            Match& match = pair.second.match;
+
+            empty.clear();
+            for (s32 cell = 0; cell < match.board.numCells; cell++)
+            {
+                if (match.board.cells[cell] == CellElement::EMPTY)
+                    empty.push_back(cell);
+            }
+
+            s32 cell = empty[random.Range((s32) empty.size())];
+            journal.LogMove(pair.first, cell, match.board.moveCount);
+            match.Play(cell);
+
+            if (match.IsOver())
+            {
+                journal.LogEnd(pair.first, match.status);
+                ended.push_back(pair.first);
+            }
+        }
+
+        for (u32 id : ended)
+            expected.erase(id);
+
+        ended.clear();
+    }
+
+    f64 logTime = GetSeconds() - start;
+    journal.Close();
+    f64 closeTime = GetSeconds() - start;
+
+    u64 records = journal.records;
+    u64 batches = journal.batches;
+    u64 snapshots = journal.snapshots;
+    bool failed = journal.failed;
+
+    start = GetSeconds();
+    std::unordered_map<u32, JournaledMatch> recovered;
+    u32 recoveredNext = 0;
+    bool opened = journal.Open(path, recovered, recoveredNext);
+    f64 recoverTime = GetSeconds() - start;
+
+    u64 mismatches = 0;
+    for (const auto& pair : expected)
+    {
+        auto it = recovered.find(pair.first);
+        if (it == recovered.end())
+        {
+            mismatches++;
+            continue;
+        }
+
+        const Board& want = pair.second.match.board;
+        const Board& got  = it->second.match.board;
+        if (want.cells != got.cells || want.playerIndex != got.playerIndex || want.moveCount != got.moveCount ||
+            pair.second.level != it->second.level || pair.second.humans != it->second.humans)
+        {
+            mismatches++;
+        }
+    }
+
+    mismatches += recovered.size() > expected.size() ? recovered.size() - expected.size() : 0;
+
+    if (opened)
+    {
+        journal.Close();
+        failed = failed || journal.failed;
+
+        remove((std::string(path) + ".snapshot").c_str());
+        for (u32 segment = journal.snapshotSegment; segment <= journal.segment; segment++)
+            remove(journal.GetSegmentPath(segment).c_str());
+    }
+
+    printf("matches     %lld\n", numMatches);
+    printf("live        %llu\n", (u64) expected.size());
+    printf("records     %llu\n", records);
+    printf("syncs       %llu\n", batches);
+    printf("per sync    %.1f records\n", batches ? (f64) records / batches : 0.0);
+    printf("logging     %.3f s (%.0f records/sec)\n", logTime, records / logTime);
+    printf("snapshots   %llu\n", snapshots);
+    printf("on disk     %.3f s\n", closeTime);
+    printf("recovered   %llu\n", (u64) recovered.size());
+    printf("recovery    %.3f s\n", recoverTime);
+    printf("mismatches  %llu\n", mismatches);
+    printf("failed      %s\n", failed || !opened ? "yes" : "no");
+
+    return opened && !failed && mismatches == 0 && recoveredNext == nextMatch ? 0 : 1;
+}
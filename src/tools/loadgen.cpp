@@ -0,0 +1,543 @@
+#include "tools.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "universal/histogram.h"
+#include "platform/socket.h"
+#include "game/board.h"
+#include "game/match.h"
+#include "game/player.h"
+#include "game/search.h"
+#include "net/protocol.h"
+#include "net/server.h"
+
+// Simulated players for sizing a server. Every player has its own
+// connection and plays games against the server's computer one after the
+// other, waiting a think time drawn from a distribution before each move.
+// The time from sending a move to getting its STATE back is the round trip
+// that goes into the histograms.
+//
+// The report has one "key value" per line in the same order every run so
+// two of them can be diffed, then the same numbers for every second.
+
+enum class ThinkKind
+{
+    FIXED,      // fixed:ms
+    UNIFORM,    // uniform:min:max
+    EXPONENTIAL,// exp:mean
+};
+
+struct ThinkTime
+{
+    ThinkKind kind;
+    f64 a;
+    f64 b;
+
+    // Written as "fixed:20", "uniform:10:50" or "exp:20", all in ms.
+    // A plain number is the same as fixed.
+    bool Parse(const char spec[])
+    {
+        char* end;
+        a = b = 0.0;
+
+        if (strncmp(spec, "exp:", 4) == 0)
+        {
+            kind = ThinkKind::EXPONENTIAL;
+            a = strtod(spec + 4, &end);
+        }
+        else if (strncmp(spec, "uniform:", 8) == 0)
+        {
+            kind = ThinkKind::UNIFORM;
+            a = strtod(spec + 8, &end);
+            if (*end != ':')
+                return false;
+
+            b = strtod(end + 1, &end);
+        }
+        else
+        {
+            kind = ThinkKind::FIXED;
+            a = strtod(strncmp(spec, "fixed:", 6) == 0 ? spec + 6 : spec, &end);
+        }
+
+        return *end == '\0' && a >= 0.0 && b >= 0.0;
+    }
+
+    // Seconds
+    f64 Sample(Random& random) const
+    {
+        switch (kind)
+        {
+            case ThinkKind::FIXED:       return a / 1000.0;
+            case ThinkKind::UNIFORM:     return (a + (b - a) * random.Unit()) / 1000.0;
+            case ThinkKind::EXPONENTIAL: return -std::log(1.0 - random.Unit()) * a / 1000.0;
+        }
+
+        return 0.0;
+    }
+};
+
+struct SimPlayer
+{
+    Socket socket;
+    std::vector<u8> in;
+    std::vector<u8> out;
+    Match match;
+    u32 matchId;
+    s32 side;
+    bool waitingForAck;
+    f64 sentAt;
+    f64 moveAt;         // When the scheduled move is due, 0 if there isn't one
+    bool open;
+};
+
+struct LoadSettings
+{
+    s32 size;
+    s32 winLength;
+    u8  level;
+    ThinkTime think;
+    ComputerPlayer agent;
+    f64 seconds;
+};
+
+struct LoadThread
+{
+    std::vector<SimPlayer> players;
+    std::vector<Histogram> seconds;     // One per second of the run
+    Histogram total;
+    u64 games;
+    u64 moves;
+    u64 errors;
+    u64 failedConnections;
+};
+
+// Everything the progress line needs while the threads run
+static std::atomic<u64> liveMoves;
+static std::atomic<u64> liveGames;
+static std::atomic<u64> liveErrors;
+
+// Every player connects before the clock starts so connecting
+// doesn't get counted as round trip time
+static std::atomic<s32> threadsConnected;
+static std::atomic<bool> go;
+static f64 start;
+
+static void SendMessage(SimPlayer& player, const Message& message)
+{
+    EncodeMessage(message, player.out);
+
+    s32 sent = SendSome(player.socket, player.out.data(), (s32) player.out.size());
+    if (sent < 0)
+        player.open = false;
+    else
+        player.out.erase(player.out.begin(), player.out.begin() + sent);
+}
+
+static void StartGame(SimPlayer& player, const LoadSettings& settings, Random& random)
+{
+    player.side = random.Range(2);
+    player.matchId = 0;
+    player.waitingForAck = false;
+    player.moveAt = 0.0;
+
+    Message message = {};
+    message.type      = MessageType::NEW_GAME;
+    message.size      = (u8) settings.size;
+    message.winLength = (u8) settings.winLength;
+    message.level     = settings.level;
+    message.player    = (u8) player.side;
+    SendMessage(player, message);
+}
+
+static void RunLoadThread(LoadThread& thread, u16 port, const char host[], s32 numPlayers,
+                          const LoadSettings& settings, u64 seed)
+{
+    Random random;
+    random.Seed(seed);
+
+    TranspositionTable table;
+    table.Init(14);
+
+    Searcher searcher = {};
+    searcher.table = &table;
+
+    Poller poller;
+    poller.Init();
+
+    thread.players.resize(numPlayers);
+    thread.total.Clear();
+    thread.games = thread.moves = thread.errors = thread.failedConnections = 0;
+
+    // Moves waiting on their think time, soonest first
+    typedef std::pair<f64, u32> Timer;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+
+    for (s32 i = 0; i < numPlayers; i++)
+    {
+        SimPlayer& player = thread.players[i];
+        player.socket = ConnectTcp(host, port);
+        player.open = player.socket != NO_SOCKET;
+
+        if (!player.open)
+        {
+            thread.failedConnections++;
+            continue;
+        }
+
+        SetNonBlocking(player.socket);
+        SetNoDelay(player.socket);
+        poller.Add(player.socket, i);
+    }
+
+    threadsConnected++;
+    while (!go)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    for (SimPlayer& player : thread.players)
+    {
+        if (!player.open)
+            continue;
+
+        player.match.Start(settings.size, settings.winLength);
+        StartGame(player, settings, random);
+    }
+
+    auto AddToSecond = [&](f64 now, u64 micros)
+    {
+        size_t second = (size_t) (now - start);
+        while (thread.seconds.size() <= second)
+        {
+            thread.seconds.emplace_back();
+            thread.seconds.back().Clear();
+        }
+
+        thread.seconds[second].Add(micros);
+        thread.total.Add(micros);
+    };
+
+    auto ScheduleMove = [&](SimPlayer& player, u32 index, f64 now)
+    {
+        player.moveAt = now + settings.think.Sample(random);
+        timers.push({ player.moveAt, index });
+    };
+
+    PollEvent events[256];
+    while (true)
+    {
+        f64 now = GetSeconds();
+        if (now - start >= settings.seconds)
+            break;
+
+        s32 timeout = 50;
+        if (!timers.empty())
+            timeout = std::min(timeout, std::max(0, (s32) std::ceil((timers.top().first - now) * 1000.0)));
+
+        s32 numEvents = poller.Wait(events, 256, timeout);
+        now = GetSeconds();
+
+        for (s32 e = 0; e < numEvents; e++)
+        {
+            u32 index = (u32) events[e].data;
+            SimPlayer& player = thread.players[index];
+            if (!player.open)
+                continue;
+
+            u8 buffer[4096];
+            s32 received;
+            while ((received = RecvSome(player.socket, buffer, sizeof(buffer))) > 0)
+                player.in.insert(player.in.end(), buffer, buffer + received);
+
+            if (received < 0)
+                player.open = false;
+
+            size_t offset = 0;
+            Message message;
+            s32 length;
+            while ((length = DecodeMessage(player.in.data() + offset, (s32) (player.in.size() - offset), message)) > 0)
+            {
+                offset += length;
+
+                if (message.type == MessageType::STARTED)
+                {
+                    player.matchId = message.match;
+                    player.match.Start(settings.size, settings.winLength);
+
+                    if (player.side == 0)
+                        ScheduleMove(player, index, now);
+                }
+                else if (message.type == MessageType::STATE && message.match == player.matchId)
+                {
+                    // Our own move coming back, or the computer's reply
+                    if (player.waitingForAck && message.moveNumber == player.match.board.moveCount)
+                    {
+                        AddToSecond(now, (u64) ((now - player.sentAt) * 1e6));
+                        player.waitingForAck = false;
+                        thread.moves++;
+                        liveMoves++;
+                    }
+                    else if (message.cell != NO_CELL)
+                    {
+                        player.match.Play(message.cell);
+                    }
+
+                    if (message.status != (u8) MatchStatus::PLAYING)
+                    {
+                        thread.games++;
+                        liveGames++;
+                        StartGame(player, settings, random);
+                    }
+                    else if (!player.waitingForAck && player.match.board.playerIndex == player.side)
+                    {
+                        ScheduleMove(player, index, now);
+                    }
+                }
+                else if (message.type == MessageType::ERROR)
+                {
+                    thread.errors++;
+                    liveErrors++;
+                }
+            }
+
+            if (length < 0)
+                player.open = false;
+
+            player.in.erase(player.in.begin(), player.in.begin() + offset);
+
+            if (!player.open)
+            {
+                poller.Remove(player.socket);
+                CloseSocket(player.socket);
+            }
+        }
+
+        // Moves whose think time is up
+        while (!timers.empty() && timers.top().first <= now)
+        {
+            Timer timer = timers.top();
+            timers.pop();
+
+            SimPlayer& player = thread.players[timer.second];
+            if (!player.open || player.moveAt != timer.first)
+                continue;
+
+            player.moveAt = 0.0;
+
+            Board& board = player.match.board;
+            s32 moveNumber = board.moveCount;
+            s32 move = settings.agent.ChooseMove(board, searcher, random);
+
+            player.match.Play(move);
+            player.waitingForAck = true;
+            player.sentAt = GetSeconds();
+
+            Message message = {};
+            message.type       = MessageType::PLACE;
+            message.match      = player.matchId;
+            message.moveNumber = (u16) moveNumber;
+            message.cell       = (u16) move;
+            SendMessage(player, message);
+        }
+    }
+
+    for (SimPlayer& player : thread.players)
+    {
+        if (player.open)
+            CloseSocket(player.socket);
+    }
+
+    poller.Free();
+}
+
+static void PrintLatencies(FILE* file, const char name[], const Histogram& histogram)
+{
+    fprintf(file, "%s_p50      %llu\n", name, histogram.Percentile(0.5));
+    fprintf(file, "%s_p90      %llu\n", name, histogram.Percentile(0.9));
+    fprintf(file, "%s_p99      %llu\n", name, histogram.Percentile(0.99));
+    fprintf(file, "%s_p999     %llu\n", name, histogram.Percentile(0.999));
+    fprintf(file, "%s_max      %llu\n", name, histogram.max);
+    fprintf(file, "%s_mean     %.1f\n", name, histogram.Mean());
+}
+
+int RunLoadGen(int argc, const char* argv[])
+{
+    const char* host  = GetFlag(argc, argv, "-host", "127.0.0.1");
+    u16 port          = (u16) GetFlagInt(argc, argv, "-port", 7474);
+    s32 numPlayers    = (s32) GetFlagInt(argc, argv, "-players", 1000);
+    const char* think = GetFlag(argc, argv, "-think", "exp:100");
+    const char* agent = GetFlag(argc, argv, "-agent", "random");
+    u64 seed          = (u64) GetFlagInt(argc, argv, "-seed", 1);
+    const char* out   = GetFlag(argc, argv, "-report", nullptr);
+    s32 numThreads    = GetThreadCount(argc, argv);
+
+    LoadSettings settings;
+    settings.size      = (s32) GetFlagInt(argc, argv, "-size", 3);
+    settings.winLength = (s32) GetFlagInt(argc, argv, "-win", settings.size);
+    settings.level     = (u8) GetFlagInt(argc, argv, "-level", 0);
+    settings.seconds   = GetFlagFloat(argc, argv, "-seconds", 10.0);
+
+    if (!settings.think.Parse(think))
+    {
+        printf("Invalid think time '%s'\n", think);
+        return 1;
+    }
+
+    if (!settings.agent.Parse(agent))
+    {
+        printf("Invalid agent '%s'\n", agent);
+        return 1;
+    }
+
+    if (numPlayers < 1 || settings.size < 1 || settings.size > Board::MAX_SIZE || settings.level >= NUM_LEVELS)
+    {
+        printf("Invalid players, size or level\n");
+        return 1;
+    }
+
+    InitSockets();
+    numThreads = std::min(numThreads, numPlayers);
+
+    // -serve runs a server in this process, for quick runs on one machine
+    static GameServer server;
+    bool serve = HasFlag(argc, argv, "-serve");
+    if (serve)
+    {
+        server.network = nullptr;
+        server.maxMatchesPerConnection = 0;
+
+        if (!server.Start(0, (s32) GetFlagInt(argc, argv, "-workers", 2), true))
+        {
+            printf("Failed to start the server\n");
+            return 1;
+        }
+
+        port = server.GetPort();
+    }
+
+    liveMoves = liveGames = liveErrors = 0;
+    threadsConnected = 0;
+    go = false;
+
+    std::vector<LoadThread> loadThreads(numThreads);
+    std::vector<std::thread> threads;
+
+    for (s32 t = 0; t < numThreads; t++)
+    {
+        s32 count = numPlayers / numThreads + (t < numPlayers % numThreads ? 1 : 0);
+        threads.emplace_back(RunLoadThread, std::ref(loadThreads[t]), port, host, count,
+                             std::cref(settings), seed * 0x9E3779B97F4A7C15ULL + t + 1);
+    }
+
+    while (threadsConnected < numThreads)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    start = GetSeconds();
+    go = true;
+
+    // Live throughput while the players run
+    u64 lastMoves = 0;
+    f64 lastTime = start;
+
+    while (GetSeconds() - start < settings.seconds)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        f64 now = GetSeconds();
+        if (now - lastTime < 1.0)
+            continue;
+
+        u64 moves = liveMoves;
+        printf("%7.1f s  %llu moves  %.0f moves/sec  %llu games  %llu errors\n",
+               now - start, moves, (moves - lastMoves) / (now - lastTime), liveGames.load(), liveErrors.load());
+        fflush(stdout);
+
+        lastMoves = moves;
+        lastTime = now;
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    if (serve)
+        server.Stop();
+
+    // Put the threads' numbers together
+    static Histogram total;
+    total.Clear();
+
+    std::vector<Histogram> seconds;
+    u64 games = 0, moves = 0, errors = 0, failed = 0;
+
+    for (const LoadThread& thread : loadThreads)
+    {
+        total.Merge(thread.total);
+        games  += thread.games;
+        moves  += thread.moves;
+        errors += thread.errors;
+        failed += thread.failedConnections;
+
+        for (size_t s = 0; s < thread.seconds.size(); s++)
+        {
+            while (seconds.size() <= s)
+            {
+                seconds.emplace_back();
+                seconds.back().Clear();
+            }
+
+            seconds[s].Merge(thread.seconds[s]);
+        }
+    }
+
+    FILE* file = stdout;
+    if (out && !(file = fopen(out, "w")))
+    {
+        printf("Failed to open '%s'\n", out);
+        return 1;
+    }
+
+    if (file != stdout)
+        printf("\n");
+
+    fprintf(file, "players        %d\n", numPlayers);
+    fprintf(file, "threads        %d\n", numThreads);
+    fprintf(file, "seconds        %.1f\n", settings.seconds);
+    fprintf(file, "think          %s\n", think);
+    fprintf(file, "agent          %s\n", agent);
+    fprintf(file, "board          %dx%d win %d\n", settings.size, settings.size, settings.winLength);
+    fprintf(file, "level          %d\n", settings.level);
+    fprintf(file, "connect_failed %llu\n", failed);
+    fprintf(file, "errors         %llu\n", errors);
+    fprintf(file, "games          %llu\n", games);
+    fprintf(file, "moves          %llu\n", moves);
+    fprintf(file, "moves_per_sec  %.0f\n", moves / settings.seconds);
+    PrintLatencies(file, "rtt_us", total);
+
+    fprintf(file, "\nsecond  moves     p50_us    p99_us    p999_us   max_us\n");
+    for (size_t s = 0; s < seconds.size(); s++)
+    {
+        const Histogram& second = seconds[s];
+        fprintf(file, "%-7d %-9llu %-9llu %-9llu %-9llu %llu\n", (s32) s, second.count,
+                second.Percentile(0.5), second.Percentile(0.99), second.Percentile(0.999), second.max);
+    }
+
+    if (file != stdout)
+    {
+        fclose(file);
+        PrintLatencies(stdout, "rtt_us", total);
+        printf("report written to %s\n", out);
+    }
+
+    return 0;
+}
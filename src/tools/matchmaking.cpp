@@ -0,0 +1,217 @@
+#include "tools.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "universal/histogram.h"
+#include "net/matchmaker.h"
+
+// Simulated lobby for the matchmaker. Join threads bring players in at a
+// set rate, or as fast as they can, while a sweeper pairs up whoever is
+// left waiting. Every pair is checked: same variant and time control,
+// ratings within the allowed spread and nobody paired twice.
+
+struct LobbyCheck
+{
+    std::unique_ptr<std::atomic<u8>[]> paired;
+    s32 maxSpread;
+    std::atomic<u64> duplicates;
+    std::atomic<u64> badPairs;
+};
+
+static void CheckPair(const Ticket& a, const Ticket& b, void* data)
+{
+    LobbyCheck& check = *(LobbyCheck*) data;
+
+    if (check.paired[a.player].exchange(1) || check.paired[b.player].exchange(1))
+        check.duplicates++;
+
+    s32 bandA = a.rating / Matchmaker::BAND_WIDTH;
+    s32 bandB = b.rating / Matchmaker::BAND_WIDTH;
+    bandA = bandA < Matchmaker::NUM_BANDS ? bandA : Matchmaker::NUM_BANDS - 1;
+    bandB = bandB < Matchmaker::NUM_BANDS ? bandB : Matchmaker::NUM_BANDS - 1;
+
+    if (a.variant != b.variant || a.timeControl != b.timeControl || std::abs(bandA - bandB) > check.maxSpread)
+        check.badPairs++;
+}
+
+static u64 GetMicros()
+{
+    return (u64) (GetSeconds() * 1e6);
+}
+
+int RunMatchmaking(int argc, const char* argv[])
+{
+    s64 numPlayers    = GetFlagInt(argc, argv, "-players", 200000);
+    f64 rate          = GetFlagFloat(argc, argv, "-rate", 0.0);
+    s32 numVariants   = (s32) GetFlagInt(argc, argv, "-variants", 3);
+    s32 numControls   = (s32) GetFlagInt(argc, argv, "-controls", 4);
+    s32 spread        = (s32) GetFlagInt(argc, argv, "-spread", 3);
+    f64 widenMs       = GetFlagFloat(argc, argv, "-widen", 200.0);
+    u64 seed          = (u64) GetFlagInt(argc, argv, "-seed", 1);
+    s32 numThreads    = GetThreadCount(argc, argv);
+
+    if (numPlayers < 2 || numVariants < 1 || numVariants > Matchmaker::NUM_VARIANTS ||
+        numControls < 1 || numControls > Matchmaker::NUM_TIME_CONTROLS)
+    {
+        printf("Invalid players, variants or time controls\n");
+        return 1;
+    }
+
+    static LobbyCheck check;
+    check.paired.reset(new std::atomic<u8>[numPlayers]);
+    for (s64 i = 0; i < numPlayers; i++)
+        check.paired[i].store(0, std::memory_order_relaxed);
+
+    check.maxSpread = spread;
+    check.duplicates = 0;
+    check.badPairs = 0;
+
+    static Matchmaker matchmaker;
+    matchmaker.Init((u32) GetFlagInt(argc, argv, "-capacity", 12));
+    matchmaker.maxSpread = spread;
+    matchmaker.widenAfter = (u64) (widenMs * 1000.0);
+    matchmaker.onMatch = CheckPair;
+    matchmaker.callbackData = &check;
+
+    std::atomic<s64> nextPlayer { 0 };
+    std::atomic<s32> joining { numThreads };
+    std::atomic<bool> sweeping { true };
+    std::vector<std::thread> threads;
+    std::vector<f64> finishTimes(numThreads);
+    f64 start = GetSeconds();
+
+    for (s32 t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            Random random;
+            random.Seed(seed * 0x9E3779B97F4A7C15ULL + t + 1);
+
+            // Each thread's share of the rate, joined in small batches
+            f64 perThread = rate / numThreads;
+            s64 joined = 0;
+
+            while (true)
+            {
+                if (rate > 0.0)
+                {
+                    f64 due = (GetSeconds() - start) * perThread;
+                    if (joined >= (s64) due)
+                    {
+                        std::this_thread::sleep_for(std::chrono::microseconds(500));
+                        continue;
+                    }
+                }
+
+                s64 player = nextPlayer++;
+                if (player >= numPlayers)
+                    break;
+
+                // Ratings bunched around 1500 like a real lobby, Box-Muller for the curve
+                f64 normal = std::sqrt(-2.0 * std::log(1.0 - random.Unit())) * std::cos(6.283185307179586 * random.Unit());
+                f64 rating = 1500.0 + 350.0 * normal;
+                rating = rating < 0.0 ? 0.0 : (rating > 3199.0 ? 3199.0 : rating);
+
+                Ticket ticket;
+                ticket.player      = (u32) player;
+                ticket.rating      = (u16) rating;
+                ticket.variant     = (u8) random.Range(numVariants);
+                ticket.timeControl = (u8) random.Range(numControls);
+                ticket.joinedAt    = GetMicros();
+
+                while (!matchmaker.Join(ticket, ticket.joinedAt))
+                    std::this_thread::yield();
+
+                joined++;
+            }
+
+            finishTimes[t] = GetSeconds();
+            joining--;
+        });
+    }
+
+    // Pairs up whoever Join couldn't, and more of them the longer they wait
+    std::thread sweeper([&]()
+    {
+        while (sweeping)
+        {
+            if (matchmaker.Sweep(GetMicros()) == 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    // Live numbers until everyone has joined and nobody more can be paired
+    u64 lastJoins = 0, lastMatches = 0;
+    f64 lastTime = start;
+    f64 settledSince = 0.0;
+    static Histogram waits;
+
+    while (true)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        f64 now = GetSeconds();
+
+        // Done once the queues stop changing with every player in
+        u64 matches = matchmaker.matches;
+        if (joining == 0)
+        {
+            if (settledSince == 0.0 || matches != lastMatches)
+                settledSince = now;
+
+            if (now - settledSince > (widenMs / 1000.0) * (spread + 1) + 0.5)
+                break;
+        }
+
+        if (now - lastTime < 1.0)
+            continue;
+
+        u64 joins = matchmaker.joins;
+        matchmaker.GetWaitTimes(waits);
+
+        printf("%7.1f s  %.0f joins/sec  %.0f matches/sec  depth %llu  wait p50 %llu us  p99 %llu us\n",
+               now - start, (joins - lastJoins) / (now - lastTime), (matches - lastMatches) / (now - lastTime),
+               matchmaker.GetQueueDepth(), waits.Percentile(0.5), waits.Percentile(0.99));
+        fflush(stdout);
+
+        lastJoins = joins;
+        lastMatches = matches;
+        lastTime = now;
+    }
+
+    sweeping = false;
+    sweeper.join();
+
+    f64 joinTime = 0.0;
+    for (s32 t = 0; t < numThreads; t++)
+    {
+        threads[t].join();
+        joinTime = finishTimes[t] - start > joinTime ? finishTimes[t] - start : joinTime;
+    }
+
+    matchmaker.GetWaitTimes(waits);
+    u64 matches = matchmaker.matches;
+
+    printf("players     %lld\n", numPlayers);
+    printf("threads     %d\n", numThreads);
+    printf("matches     %llu\n", matches);
+    printf("waiting     %llu\n", matchmaker.GetQueueDepth());
+    printf("rejected    %llu\n", matchmaker.rejected.load());
+    printf("duplicates  %llu\n", check.duplicates.load());
+    printf("bad pairs   %llu\n", check.badPairs.load());
+    printf("join time   %.3f s\n", joinTime);
+    printf("joins/sec   %.0f\n", numPlayers / joinTime);
+    printf("wait p50    %llu us\n", waits.Percentile(0.5));
+    printf("wait p99    %llu us\n", waits.Percentile(0.99));
+    printf("wait p999   %llu us\n", waits.Percentile(0.999));
+    printf("wait max    %llu us\n", waits.max);
+
+    return check.duplicates == 0 && check.badPairs == 0 ? 0 : 1;
+}
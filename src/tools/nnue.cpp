@@ -0,0 +1,154 @@
+#include "tools.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "game/board.h"
+#include "game/nnue.h"
+
+// Checks the SSE2/AVX2 network code against the plain loops it stands in
+// for. Random weights, random positions: the accumulator built from
+// scratch, the one kept up to date move by move and the evaluation on top
+// of both have to come out exactly the same either way. Evaluations are
+// also compared on accumulators filled with any s16 at all, so the
+// clamping is covered from end to end.
+
+static s16 RandomValue(Random& random, s32 low, s32 high)
+{
+    return (s16) (low + random.Range(high - low + 1));
+}
+
+static void RandomiseNetwork(Network& network, s32 size, Random& random)
+{
+    network.boardSize = size;
+    network.featureWeights.resize((size_t) size * size * 2 * NNUE_HIDDEN);
+
+    for (s16& weight : network.featureWeights)
+        weight = RandomValue(random, -200, 200);
+    for (s32 i = 0; i < NNUE_HIDDEN; i++)
+        network.featureBias[i] = RandomValue(random, -500, 500);
+
+    // Same ranges as the weight file, int8 for both layers
+    for (s32 o = 0; o < NNUE_L1; o++)
+    {
+        for (s32 i = 0; i < NNUE_HIDDEN; i++)
+            network.l1Weights[o][i] = RandomValue(random, -128, 127);
+
+        network.l1Bias[o]    = random.Range(1 << 16) - (1 << 15);
+        network.l2Weights[o] = RandomValue(random, -128, 127);
+    }
+
+    network.l2Bias = random.Range(2001) - 1000;
+    network.loaded = true;
+}
+
+static bool SameAccumulator(const Accumulator& a, const Accumulator& b)
+{
+    return memcmp(a.values, b.values, sizeof(a.values)) == 0;
+}
+
+int RunNetworkCheck(int argc, const char* argv[])
+{
+    s64 numNetworks  = GetFlagInt(argc, argv, "-networks", 20);
+    s64 numPositions = GetFlagInt(argc, argv, "-positions", 5000);
+    s32 size         = (s32) GetFlagInt(argc, argv, "-size", 15);
+    u64 seed         = (u64) GetFlagInt(argc, argv, "-seed", 1);
+
+    if (size < 1 || size > Board::MAX_SIZE)
+    {
+        printf("Invalid size\n");
+        return 1;
+    }
+
+    Random random;
+    random.Seed(seed);
+
+    std::unique_ptr<Network> network(new Network {});
+    Board board;
+    board.Init(size, size < 5 ? size : 5);
+
+    u64 refreshMismatches = 0, updateMismatches = 0, evaluateMismatches = 0;
+    u64 evaluations = 0;
+    s32 moves[Board::MAX_MOVES];
+    f64 start = GetSeconds();
+
+    for (s64 n = 0; n < numNetworks; n++)
+    {
+        RandomiseNetwork(*network, size, random);
+
+        for (s64 p = 0; p < numPositions; p++)
+        {
+            // Random elements, moves made in order so some can be taken back
+            board.Clear((s32) random.Range(2));
+            s32 numMoves = random.Range(board.numCells + 1);
+            s32 played[Board::MAX_MOVES];
+
+            for (s32 i = 0; i < numMoves; i++)
+            {
+                s32 numEmpty = board.GenerateMoves(moves);
+                played[i] = moves[random.Range(numEmpty)];
+                board.MakeMove(played[i]);
+            }
+
+            Accumulator vector, scalar;
+            network->Refresh(vector, board);
+            network->RefreshScalar(scalar, board);
+            refreshMismatches += !SameAccumulator(vector, scalar);
+
+            // Taken back one by one the way the search does, then checked
+            // against a fresh scalar build of what's left
+            s32 undo = numMoves ? random.Range(numMoves + 1) : 0;
+            for (s32 i = 0; i < undo; i++)
+            {
+                s32 cell = played[numMoves - 1 - i];
+                network->RemoveElement(vector, cell, (s32) board.cells[cell]);
+                board.UndoMove(cell);
+            }
+
+            network->RefreshScalar(scalar, board);
+            updateMismatches += !SameAccumulator(vector, scalar);
+
+            // Forward again from there
+            for (s32 i = numMoves - undo; i < numMoves; i++)
+            {
+                network->AddElement(vector, played[i], board.playerIndex);
+                board.MakeMove(played[i]);
+            }
+
+            network->RefreshScalar(scalar, board);
+            updateMismatches += !SameAccumulator(vector, scalar);
+
+            for (s32 player = 0; player < 2; player++)
+            {
+                evaluateMismatches += network->Evaluate(vector, player) != network->EvaluateScalar(vector, player);
+                evaluations++;
+            }
+
+            Accumulator wild;
+            for (s32 perspective = 0; perspective < 2; perspective++)
+                for (s32 i = 0; i < NNUE_HIDDEN; i++)
+                    wild.values[perspective][i] = (s16) random.Next();
+
+            for (s32 player = 0; player < 2; player++)
+            {
+                evaluateMismatches += network->Evaluate(wild, player) != network->EvaluateScalar(wild, player);
+                evaluations++;
+            }
+        }
+    }
+
+    f64 elapsed = GetSeconds() - start;
+
+    printf("kernels      %s\n", GetNetworkKernels());
+    printf("networks     %lld\n", numNetworks);
+    printf("positions    %lld\n", numNetworks * numPositions);
+    printf("evaluations  %llu\n", evaluations);
+    printf("time         %.3f s\n", elapsed);
+    printf("refresh      %llu mismatches\n", refreshMismatches);
+    printf("update       %llu mismatches\n", updateMismatches);
+    printf("evaluate     %llu mismatches\n", evaluateMismatches);
+
+    return refreshMismatches == 0 && updateMismatches == 0 && evaluateMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,358 @@
+#include "tools.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "universal/types.h"
+#include "game/board.h"
+#include "game/fixed_board.h"
+
+// Enumerates every game from the current position up to a depth.
+// Full 3x3 should give 255168 games: 131184 / 77904 wins and 46080 draws,
+// and 765 positions that aren't rotations or reflections of each other.
+// Works on Board or any FixedBoard, they have the same interface.
+
+struct PerftCounts
+{
+    u64 nodes;      // Positions visited, not counting the root
+    u64 games;      // Positions where the game ended
+    u64 wins[2];
+    u64 draws;
+    u64 leaves;     // Unfinished positions cut off by the depth
+
+    void Add(const PerftCounts& other)
+    {
+        nodes    += other.nodes;
+        games    += other.games;
+        wins[0]  += other.wins[0];
+        wins[1]  += other.wins[1];
+        draws    += other.draws;
+        leaves   += other.leaves;
+    }
+};
+
+template <typename BoardType>
+static void Perft(BoardType& board, s32 depth, PerftCounts& counts)
+{
+    if (depth == 0)
+    {
+        counts.leaves++;
+        return;
+    }
+
+    s32 moves[BoardType::MAX_MOVES];
+    s32 numMoves = board.GenerateMoves(moves);
+
+    for (s32 i = 0; i < numMoves; i++)
+    {
+        s32 player = board.playerIndex;
+        board.MakeMove(moves[i]);
+        counts.nodes++;
+
+        if (board.WonThrough(moves[i]))
+        {
+            counts.games++;
+            counts.wins[player]++;
+        }
+        else if (board.IsFull())
+        {
+            counts.games++;
+            counts.draws++;
+        }
+        else
+        {
+            Perft(board, depth - 1, counts);
+        }
+
+        board.UndoMove(moves[i]);
+    }
+}
+
+// Adds the canonical hash of every position up to depth moves from board.
+// All the ways to a position take the same number of moves, so one that's
+// already in seen has had everything after it added as well.
+template <typename BoardType>
+static void CountUnique(BoardType& board, s32 depth, std::unordered_set<u64>& seen)
+{
+    if (!seen.insert(board.CanonicalHash()).second || depth == 0)
+        return;
+
+    s32 moves[BoardType::MAX_MOVES];
+    s32 numMoves = board.GenerateMoves(moves);
+
+    for (s32 i = 0; i < numMoves; i++)
+    {
+        board.MakeMove(moves[i]);
+
+        if (board.WonThrough(moves[i]) || board.IsFull())
+            seen.insert(board.CanonicalHash());
+        else
+            CountUnique(board, depth - 1, seen);
+
+        board.UndoMove(moves[i]);
+    }
+}
+
+// Collects every unfinished line of splitDepth moves as a separate piece of
+// work. Games that end before that are counted here directly.
+template <typename BoardType>
+static void SplitWork(BoardType& board, s32 splitDepth, std::vector<s32>& line,
+                      std::vector<std::vector<s32>>& work, PerftCounts& counts)
+{
+    if (splitDepth == 0)
+    {
+        work.push_back(line);
+        return;
+    }
+
+    s32 moves[BoardType::MAX_MOVES];
+    s32 numMoves = board.GenerateMoves(moves);
+
+    for (s32 i = 0; i < numMoves; i++)
+    {
+        s32 player = board.playerIndex;
+        board.MakeMove(moves[i]);
+        counts.nodes++;
+
+        if (board.WonThrough(moves[i]))
+        {
+            counts.games++;
+            counts.wins[player]++;
+        }
+        else if (board.IsFull())
+        {
+            counts.games++;
+            counts.draws++;
+        }
+        else
+        {
+            line.push_back(moves[i]);
+            SplitWork(board, splitDepth - 1, line, work, counts);
+            line.pop_back();
+        }
+
+        board.UndoMove(moves[i]);
+    }
+}
+
+template <typename BoardType>
+static PerftCounts PerftParallel(const BoardType& root, s32 depth, s32 splitDepth, s32 numThreads)
+{
+    PerftCounts total = {};
+
+    if (splitDepth >= depth)
+        splitDepth = depth - 1;
+
+    BoardType board = root;
+    std::vector<s32> line;
+    std::vector<std::vector<s32>> work;
+    SplitWork(board, splitDepth, line, work, total);
+
+    // Threads grab the next piece of work until there is none left
+    std::atomic<size_t> nextWork { 0 };
+    std::vector<PerftCounts> threadCounts(numThreads, PerftCounts {});
+    std::vector<std::thread> threads;
+
+    for (s32 t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            BoardType local = root;
+            PerftCounts& counts = threadCounts[t];
+
+            for (size_t w = nextWork++; w < work.size(); w = nextWork++)
+            {
+                for (s32 move : work[w])
+                    local.MakeMove(move);
+
+                Perft(local, depth - splitDepth, counts);
+
+                for (size_t m = work[w].size(); m > 0; m--)
+                    local.UndoMove(work[w][m - 1]);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (const PerftCounts& counts : threadCounts)
+        total.Add(counts);
+
+    return total;
+}
+
+int RunPerft(int argc, const char* argv[])
+{
+    s32 size       = (s32) GetFlagInt(argc, argv, "-size", 3);
+    s32 winLength  = (s32) GetFlagInt(argc, argv, "-win", size);
+    s32 depth      = (s32) GetFlagInt(argc, argv, "-depth", size * size);
+    s32 splitDepth = (s32) GetFlagInt(argc, argv, "-split", 2);
+    s32 numThreads = GetThreadCount(argc, argv);
+    bool fixed     = HasFlag(argc, argv, "-fixed");
+    bool unique    = HasFlag(argc, argv, "-unique");
+
+    if (size < 1 || size > Board::MAX_SIZE || depth < 1)
+    {
+        printf("Invalid size or depth\n");
+        return 1;
+    }
+
+    auto run = [&](const auto& board)
+    {
+        PerftCounts counts = {};
+        if (numThreads == 1)
+        {
+            auto local = board;
+            Perft(local, depth, counts);
+        }
+        else
+        {
+            counts = PerftParallel(board, depth, splitDepth, numThreads);
+        }
+        return counts;
+    };
+
+    f64 start = GetSeconds();
+    PerftCounts counts = {};
+    if (fixed)
+    {
+        if (!WithFixedBoard(size, winLength, [&](const auto& board) { counts = run(board); }))
+        {
+            printf("No fixed board for %dx%d, %d in a row\n", size, size, winLength);
+            return 1;
+        }
+    }
+    else
+    {
+        Board board;
+        board.Init(size, winLength);
+        counts = run(board);
+    }
+    f64 elapsed = GetSeconds() - start;
+
+    // Not timed, it goes through the same positions with a set to fill
+    u64 numUnique = 0;
+    auto countUnique = [&](const auto& board)
+    {
+        auto local = board;
+        std::unordered_set<u64> seen;
+        CountUnique(local, depth, seen);
+        numUnique = seen.size();
+    };
+
+    if (unique && fixed)
+    {
+        WithFixedBoard(size, winLength, countUnique);
+    }
+    else if (unique)
+    {
+        Board board;
+        board.Init(size, winLength);
+        countUnique(board);
+    }
+
+    printf("perft %dx%d, %d in a row, depth %d, %d thread(s)%s\n", size, size, winLength, depth, numThreads,
+           fixed ? ", fixed board" : "");
+    printf("nodes       %llu\n", counts.nodes);
+    printf("games       %llu\n", counts.games);
+    printf("cross wins  %llu\n", counts.wins[0]);
+    printf("circle wins %llu\n", counts.wins[1]);
+    printf("draws       %llu\n", counts.draws);
+    printf("leaves      %llu\n", counts.leaves);
+    if (unique)
+        printf("unique      %llu\n", numUnique);
+    printf("time        %.3f s\n", elapsed);
+    printf("nodes/sec   %.0f\n", elapsed > 0.0 ? counts.nodes / elapsed : 0.0);
+
+    return 0;
+}
+
+
+// Perft on one thread with Board and with FixedBoard for each variant that
+// has one, to keep track of what the compile time tables are worth
+int RunBench(int argc, const char* argv[])
+{
+    static const struct
+    {
+        s32 size;
+        s32 winLength;
+        s32 depth;
+    } variants[] = {
+        { 3, 3, 9 },
+        { 4, 3, 7 },
+        { 4, 4, 7 },
+        { 5, 4, 5 },
+        { 5, 5, 5 },
+    };
+
+    s32 repeat = (s32) GetFlagInt(argc, argv, "-repeat", 3);
+
+    printf("%-12s %6s %12s %10s %14s %14s %8s\n", "variant", "depth", "nodes", "unique", "Board n/s", "Fixed n/s", "gain");
+
+    bool allMatch = true;
+    for (const auto& variant : variants)
+    {
+        // Best of a few runs, the first one also warms up the caches
+        f64 runtimeTime = 0.0, fixedTime = 0.0;
+        PerftCounts runtimeCounts = {}, fixedCounts = {};
+
+        for (s32 r = 0; r < repeat; r++)
+        {
+            Board board;
+            board.Init(variant.size, variant.winLength);
+
+            PerftCounts counts = {};
+            f64 start = GetSeconds();
+            Perft(board, variant.depth, counts);
+            f64 elapsed = GetSeconds() - start;
+
+            if (r == 0 || elapsed < runtimeTime)
+                runtimeTime = elapsed;
+            runtimeCounts = counts;
+
+            WithFixedBoard(variant.size, variant.winLength, [&](auto& fixedBoard)
+            {
+                PerftCounts counts = {};
+                f64 start = GetSeconds();
+                Perft(fixedBoard, variant.depth, counts);
+                f64 elapsed = GetSeconds() - start;
+
+                if (r == 0 || elapsed < fixedTime)
+                    fixedTime = elapsed;
+                fixedCounts = counts;
+            });
+        }
+
+        // Positions up to symmetry, the same number whichever board's
+        // symmetries and hash keys find them
+        std::unordered_set<u64> runtimeUnique, fixedUnique;
+        {
+            Board board;
+            board.Init(variant.size, variant.winLength);
+            CountUnique(board, variant.depth, runtimeUnique);
+        }
+        WithFixedBoard(variant.size, variant.winLength, [&](auto& fixedBoard)
+        {
+            CountUnique(fixedBoard, variant.depth, fixedUnique);
+        });
+
+        // Both have to agree on every count or the speed means nothing
+        bool match = runtimeCounts.nodes == fixedCounts.nodes && runtimeCounts.games == fixedCounts.games &&
+                     runtimeCounts.wins[0] == fixedCounts.wins[0] && runtimeCounts.wins[1] == fixedCounts.wins[1] &&
+                     runtimeCounts.draws == fixedCounts.draws && runtimeCounts.leaves == fixedCounts.leaves &&
+                     runtimeUnique.size() == fixedUnique.size();
+        allMatch = allMatch && match;
+
+        char name[16];
+        sprintf(name, "%dx%d k=%d", variant.size, variant.size, variant.winLength);
+
+        printf("%-12s %6d %12llu %10zu %14.0f %14.0f %7.2fx%s\n", name, variant.depth, runtimeCounts.nodes, runtimeUnique.size(),
+               runtimeCounts.nodes / runtimeTime, fixedCounts.nodes / fixedTime, runtimeTime / fixedTime,
+               match ? "" : "  MISMATCH");
+    }
+
+    return allMatch ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include "tools.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "game/board.h"
+#include "game/fixed_board.h"
+#include "game/search.h"
+#include "game/puzzle.h"
+
+// Canonical hashes of every position looked at so far. Split into shards
+// with their own locks so the workers hardly ever wait on each other.
+struct SeenSet
+{
+    static const s32 NUM_SHARDS = 64;
+
+    std::mutex locks[NUM_SHARDS];
+    std::unordered_set<u64> shards[NUM_SHARDS];
+
+    // False if some thread already claimed key
+    bool Insert(u64 key)
+    {
+        s32 shard = (s32) (key >> 58);
+        std::lock_guard<std::mutex> lock(locks[shard]);
+        return shards[shard].insert(key).second;
+    }
+};
+
+static bool ComesFirst(const Puzzle& a, const Puzzle& b)
+{
+    if (a.moves != b.moves)
+        return a.moves < b.moves;
+
+    return a.cells < b.cells;
+}
+
+int RunPuzzles(int argc, const char* argv[])
+{
+    s32 size         = (s32) GetFlagInt(argc, argv, "-size", 3);
+    s32 winLength    = (s32) GetFlagInt(argc, argv, "-win", size);
+    s32 minMoves     = (s32) GetFlagInt(argc, argv, "-min", 2);
+    s32 maxMoves     = (s32) GetFlagInt(argc, argv, "-max", 3);
+    u64 count        = (u64) GetFlagInt(argc, argv, "-count", 1000);
+    u64 maxPositions = (u64) GetFlagInt(argc, argv, "-positions", 1000000);
+    s32 randomChance = (s32) GetFlagInt(argc, argv, "-random", 50);
+    u64 seed         = (u64) GetFlagInt(argc, argv, "-seed", 1);
+    const char* out  = GetFlag(argc, argv, "-out", "puzzles.ttp");
+    s32 numThreads   = GetThreadCount(argc, argv);
+
+    if (size < 1 || size > Board::MAX_SIZE || minMoves < 1 || maxMoves < minMoves)
+    {
+        printf("Invalid size or move range\n");
+        return 1;
+    }
+
+    Board root;
+    root.Init(size, winLength);
+
+    // Games are numbered and each one's moves depend only on its number, so
+    // the positions are the same however the games are spread over threads.
+    // Every canonical position is checked once by whichever thread gets to
+    // it first and puzzles are kept in canonical orientation.
+    struct GameRecord
+    {
+        u64 index;
+        std::vector<u64> positions;     // Canonical hashes in order of play
+    };
+
+    SeenSet seen;
+    std::mutex foundMutex;
+    std::vector<GameRecord> games;
+    std::unordered_map<u64, Puzzle> found;
+    std::atomic<u64> nextGame { 0 };
+    std::atomic<u64> numFound { 0 };
+    std::atomic<u64> visited { 0 };
+    std::atomic<u64> examined { 0 };
+    std::atomic<u64> verified { 0 };
+    std::atomic<s32> running { numThreads };
+
+    std::vector<std::thread> threads;
+    for (s32 t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([&]()
+        {
+            Board board = root;
+            Random random;
+
+            // Plays the self-play moves. The table is cleared for every game
+            // so a game's moves don't depend on the ones played before it.
+            TranspositionTable table;
+            table.Init(16);
+            Searcher player = {};
+            player.table = &table;
+
+            // Throws out positions that clearly aren't wins before the
+            // exhaustive check. No table, so the answer only depends on the
+            // position.
+            Searcher filter = {};
+
+            SearchLimits playLimits = { 0, 200, 0 };
+            SearchLimits filterLimits = { 2 * maxMoves - 1, 0, 0 };
+
+            // The exhaustive check runs on the compile time board when
+            // this variant has one
+            PuzzleSolver solver;
+            s32 solution = -1;
+            s32 solutionMoves = 0;
+
+            auto solve = [&](auto& position)
+            {
+                solver.Clear();
+                solution = -1;
+
+                for (s32 n = minMoves; n <= maxMoves && solution < 0; n++)
+                {
+                    solution = solver.FindUniqueSolution(position, n);
+                    solutionMoves = n;
+                }
+            };
+
+            s32 moves[Board::MAX_MOVES];
+
+            // A game that's started is always finished, the games kept at
+            // the end have to be complete
+            while (numFound < count && visited < maxPositions)
+            {
+                GameRecord record;
+                record.index = nextGame++;
+
+                board.Clear();
+                table.Clear();
+                random.Seed(seed * 0x9E3779B97F4A7C15ULL + record.index + 1);
+
+                // Every position of a game is a candidate, the game is a mix
+                // of random moves and quick self-play ones
+                while (true)
+                {
+                    visited++;
+
+                    s32 symmetry;
+                    u64 key = board.CanonicalHash(&symmetry);
+                    record.positions.push_back(key);
+
+                    if (seen.Insert(key))
+                    {
+                        examined++;
+
+                        SearchResult result = filter.Search(board, filterLimits);
+                        if (result.score > 0 && IsWinScore(result.score))
+                        {
+                            verified++;
+
+                            bool fixed = WithFixedBoard(size, winLength, [&](auto& fixedBoard)
+                            {
+                                fixedBoard.SetPosition(board.cells.data(), board.playerIndex);
+                                solve(fixedBoard);
+                            });
+                            if (!fixed)
+                                solve(board);
+
+                            if (solution >= 0)
+                            {
+                                Puzzle puzzle;
+                                puzzle.cells.resize(board.numCells);
+                                puzzle.playerIndex = board.playerIndex;
+                                puzzle.moves = solutionMoves;
+                                puzzle.solution = board.Transform(solution, symmetry);
+                                CanonicalPosition(board, puzzle.cells.data());
+
+                                std::lock_guard<std::mutex> lock(foundMutex);
+                                found[key] = puzzle;
+                                numFound = found.size();
+                            }
+                        }
+                    }
+
+                    s32 move;
+                    if ((s32) random.Range(100) < randomChance)
+                    {
+                        s32 numMoves = board.GenerateMoves(moves);
+                        move = moves[random.Range(numMoves)];
+                    }
+                    else
+                    {
+                        move = player.Search(board, playLimits).move;
+                    }
+
+                    board.MakeMove(move);
+                    if (board.WonThrough(move) || board.IsFull())
+                        break;
+                }
+
+                std::lock_guard<std::mutex> lock(foundMutex);
+                games.push_back(std::move(record));
+            }
+
+            running--;
+        });
+    }
+
+    // Live progress while the workers run
+    f64 start = GetSeconds();
+    f64 lastTime = start;
+
+    while (running > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        f64 now = GetSeconds();
+        if (now - lastTime < 1.0)
+            continue;
+
+        printf("%7.1f s  %llu positions  %llu new  %llu verified  %llu puzzles\n",
+               now - start, (u64) visited, (u64) examined, (u64) verified, (u64) numFound);
+        fflush(stdout);
+
+        lastTime = now;
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    // The threads overshoot by however many games were in flight when they
+    // stopped. Going through the games in order up to the position limit, or
+    // until there are enough puzzles, gives the same candidates every run.
+    std::sort(games.begin(), games.end(), [](const GameRecord& a, const GameRecord& b)
+    {
+        return a.index < b.index;
+    });
+
+    std::vector<Puzzle> puzzles;
+    std::unordered_set<u64> taken;
+    u64 positions = 0;
+
+    for (const GameRecord& record : games)
+    {
+        for (u64 key : record.positions)
+        {
+            if (positions >= maxPositions || puzzles.size() >= count)
+                break;
+
+            positions++;
+
+            auto it = found.find(key);
+            if (it != found.end() && taken.insert(key).second)
+                puzzles.push_back(it->second);
+        }
+    }
+
+    std::sort(puzzles.begin(), puzzles.end(), ComesFirst);
+    if (puzzles.size() > count)
+        puzzles.resize((size_t) count);
+
+    PuzzleSet set;
+    set.size = size;
+    set.winLength = winLength;
+    set.puzzles = puzzles;
+
+    if (!set.Save(out))
+    {
+        printf("Failed to open '%s'\n", out);
+        return 1;
+    }
+
+    f64 elapsed = GetSeconds() - start;
+
+    printf("positions   %llu\n", positions);
+    printf("new         %llu\n", (u64) examined);
+    printf("verified    %llu\n", (u64) verified);
+    printf("puzzles     %llu\n", (u64) puzzles.size());
+    for (s32 n = minMoves; n <= maxMoves; n++)
+    {
+        u64 withN = std::count_if(puzzles.begin(), puzzles.end(), [n](const Puzzle& p) { return p.moves == n; });
+        printf("  win in %d  %llu\n", n, withN);
+    }
+    printf("time        %.3f s\n", elapsed);
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include "tools.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "universal/histogram.h"
+#include "game/board.h"
+#include "game/match.h"
+#include "game/replay.h"
+
+// Checks the replay log the game keeps. Writes a lot of random games, then
+// reads random ones back through the sparse index and scrubs to a random
+// move in each, comparing against the game played again from its seed.
+// Also tears the last record the way a crash would, rebuilds the index and
+// swaps in the index of another log to check it isn't trusted.
+
+static void PlayRandomGame(u64 seed, s32 size, s32 winLength, ReplayGame& out)
+{
+    Random random;
+    random.Seed(seed);
+
+    Match match;
+    match.Start(size, winLength, (s32) random.Range(2));
+
+    out.size        = size;
+    out.winLength   = winLength;
+    out.firstPlayer = match.board.playerIndex;
+    out.moves.clear();
+
+    s32 moves[Board::MAX_MOVES];
+    while (!match.IsOver())
+    {
+        s32 numMoves = match.board.GenerateMoves(moves);
+        s32 move = moves[random.Range(numMoves)];
+        match.Play(move);
+        out.moves.push_back((u16) move);
+    }
+
+    out.status = match.status;
+}
+
+static u64 GameSeed(u64 seed, u64 game)
+{
+    return seed * 0x9E3779B97F4A7C15ULL + game + 1;
+}
+
+int RunReplays(int argc, const char* argv[])
+{
+    s64 numGames    = GetFlagInt(argc, argv, "-games", 1000000);
+    s32 size        = (s32) GetFlagInt(argc, argv, "-size", 3);
+    s32 winLength   = (s32) GetFlagInt(argc, argv, "-win", size);
+    s64 numSeeks    = GetFlagInt(argc, argv, "-seeks", 100000);
+    u64 seed        = (u64) GetFlagInt(argc, argv, "-seed", 1);
+    std::string path = GetFlag(argc, argv, "-path", "replay_check.ttr");
+    std::string indexPath = path + ".idx";
+
+    if (size < 1 || size > Board::MAX_SIZE || winLength < 1 || winLength > size || numGames < 1)
+    {
+        printf("Invalid size, win length or games\n");
+        return 1;
+    }
+
+    static ReplayLog log;
+    if (!log.Open(path.c_str()) || log.numGames != 0)
+    {
+        printf("'%s' already has games or can't be written\n", path.c_str());
+        return 1;
+    }
+
+    ReplayGame game, read;
+    bool failed = false;
+
+    f64 start = GetSeconds();
+    for (s64 i = 0; i < numGames; i++)
+    {
+        PlayRandomGame(GameSeed(seed, i), size, winLength, game);
+        failed = !log.Append(game) || failed;
+    }
+    f64 writeTime = GetSeconds() - start;
+    u64 bytes = log.end;
+    log.Close();
+
+    start = GetSeconds();
+    bool opened = log.Open(path.c_str());
+    f64 openTime = GetSeconds() - start;
+    failed = failed || !opened || log.numGames != (u64) numGames;
+
+    // Random games, each scrubbed to a random move
+    Random random;
+    random.Seed(seed);
+    static Histogram seeks;
+    seeks.Clear();
+    ReplayCursor cursor;
+    Match shown, expected;
+    u64 mismatches = 0;
+
+    for (s64 i = 0; i < numSeeks && opened; i++)
+    {
+        u64 index = random.Range((s32) numGames);
+        PlayRandomGame(GameSeed(seed, index), size, winLength, game);
+        s32 move = (s32) random.Range((s32) game.moves.size() + 1);
+
+        f64 seekStart = GetSeconds();
+        bool ok = log.Read(index, read);
+        if (ok)
+        {
+            cursor.Load(read);
+            cursor.Seek(move, shown);
+        }
+        seeks.Add((u64) ((GetSeconds() - seekStart) * 1e6));
+
+        expected.Start(size, winLength, game.firstPlayer);
+        for (s32 m = 0; m < move; m++)
+            expected.Play(game.moves[m]);
+
+        if (!ok || read.moves != game.moves || read.status != game.status ||
+            shown.board.cells != expected.board.cells || shown.board.playerIndex != expected.board.playerIndex ||
+            shown.status != expected.status || shown.lastMove != expected.lastMove)
+        {
+            mismatches++;
+        }
+    }
+
+    // A record half written when the game was killed
+    log.Close();
+    FILE* file = fopen(path.c_str(), "ab");
+    if (file)
+    {
+        const u8 torn[5] = { (u8) size, (u8) winLength, 0, 1, 200 };
+        fwrite(torn, 1, sizeof(torn), file);
+        fclose(file);
+    }
+
+    bool tornOk = log.Open(path.c_str()) && log.numGames == (u64) numGames;
+    PlayRandomGame(GameSeed(seed, numGames), size, winLength, game);
+    tornOk = tornOk && log.Append(game);
+    log.Close();
+    tornOk = tornOk && log.Open(path.c_str()) && log.numGames == (u64) numGames + 1 &&
+             log.Read(numGames, read) && read.moves == game.moves;
+    log.Close();
+
+    // Without the index it's rebuilt by reading the whole log once
+    remove(indexPath.c_str());
+    start = GetSeconds();
+    bool rebuilt = log.Open(path.c_str()) && log.numGames == (u64) numGames + 1;
+    f64 rebuildTime = GetSeconds() - start;
+    rebuilt = rebuilt && log.Read(numGames / 2, read);
+    log.Close();
+
+    // The index of a different log of the same length, as if one file
+    // had been swapped without the other
+    std::string otherPath = path + ".other";
+    bool foreignOk = log.Open(otherPath.c_str()) && log.numGames == 0;
+    for (s64 i = 0; i <= numGames && foreignOk; i++)
+    {
+        PlayRandomGame(GameSeed(seed + 1, i), size, winLength, game);
+        foreignOk = log.Append(game);
+    }
+    log.Close();
+
+    remove(indexPath.c_str());
+    foreignOk = foreignOk && rename((otherPath + ".idx").c_str(), indexPath.c_str()) == 0;
+    foreignOk = foreignOk && log.Open(path.c_str()) && log.numGames == (u64) numGames + 1;
+    for (s64 i = 0; i < 1000 && foreignOk; i++)
+    {
+        u64 index = random.Range((s32) numGames);
+        PlayRandomGame(GameSeed(seed, index), size, winLength, game);
+        foreignOk = log.Read(index, read) && read.moves == game.moves;
+    }
+    log.Close();
+
+    remove(path.c_str());
+    remove(indexPath.c_str());
+    remove(otherPath.c_str());
+    remove((otherPath + ".idx").c_str());
+
+    printf("games        %lld\n", numGames);
+    printf("log          %.1f MB, %.1f bytes a game\n", bytes / 1e6, (f64) bytes / numGames);
+    printf("index        %llu keys\n", (u64) ((numGames + ReplayLog::GAMES_PER_KEY - 1) / ReplayLog::GAMES_PER_KEY));
+    printf("writing      %.3f s (%.0f games/sec)\n", writeTime, numGames / writeTime);
+    printf("opening      %.3f s\n", openTime);
+    printf("seek p50     %llu us\n", seeks.Percentile(0.5));
+    printf("seek p99     %llu us\n", seeks.Percentile(0.99));
+    printf("seek max     %llu us\n", seeks.max);
+    printf("mismatches   %llu\n", mismatches);
+    printf("torn tail    %s\n", tornOk ? "ok" : "FAILED");
+    printf("rebuild      %.3f s%s\n", rebuildTime, rebuilt ? "" : " FAILED");
+    printf("other index  %s\n", foreignOk ? "ok" : "FAILED");
+
+    return !failed && mismatches == 0 && tornOk && rebuilt && foreignOk ? 0 : 1;
+}
@@ -0,0 +1,533 @@
+#include "tools.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "game/board.h"
+#include "game/search.h"
+#include "game/nnue.h"
+
+// Self-play samples of (position, search score, game result) for training
+// evaluation functions. Samples go into shards of a fixed number of records:
+//
+//   shard header:  "TTTS", u32 version, u8 size, u8 winLength,
+//                  u16 unused, u32 sampleCount
+//   record:        u8 flags: bit 0 player to move, bits 1-2 result for
+//                     that player plus one (0 loss, 1 draw, 2 win),
+//                     bit 3 set when the whole board follows
+//                  search score, zigzag varint
+//                  whole board: cells packed 2 bits each, row by row
+//                  otherwise: varint count, then varint cell * 3 + element
+//                     for each cell that differs from the record before
+//
+// All little endian, varints 7 bits a byte low bits first. The first record
+// of a shard always has the whole board, so shards decode on their own.
+// Samples from one game follow each other, so most records are a move
+// or two on from the last one and take a few bytes. The index file lists
+// "<shard file> <samples> <bytes>" for every shard, one per line.
+
+static const u32 SHARD_VERSION  = 2;
+static const s32 MAX_DELTA      = 8;    // Changed cells before a whole board is cheaper
+static const u8  FLAG_FULL      = 8;
+
+static void PutU32(u8* out, u32 value)
+{
+    for (int i = 0; i < 4; i++)
+        out[i] = (u8) (value >> (8 * i));
+}
+
+static void PutVarint(std::vector<u8>& out, u32 value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((u8) (value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((u8) value);
+}
+
+static bool GetVarint(const u8*& at, const u8* end, u32& value)
+{
+    value = 0;
+    for (s32 shift = 0; shift < 35 && at < end; shift += 7)
+    {
+        u8 byte = *at++;
+        value |= (u32) (byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+static u32 ZigZag(s32 value)
+{
+    return ((u32) value << 1) ^ (u32) (value >> 31);
+}
+
+static s32 UnZigZag(u32 value)
+{
+    return (s32) (value >> 1) ^ -(s32) (value & 1);
+}
+
+static s32 GetCell(const u8* packed, s32 index)
+{
+    return (packed[index / 4] >> (2 * (index % 4))) & 3;
+}
+
+// Records as the workers make them, the same size every time:
+// u8 player to move, s8 result, s32 score, cells packed 2 bits each
+static u32 GetRecordSize(const Board& board)
+{
+    return 6 + (board.numCells * 2 + 7) / 8;
+}
+
+static void EncodeRecord(const Board& board, s32 score, u8* out)
+{
+    out[0] = (u8) board.playerIndex;
+    out[1] = 0; // Result is filled in when the game ends
+    PutU32(out + 2, (u32) score);
+
+    u8* cells = out + 6;
+    memset(cells, 0, (board.numCells * 2 + 7) / 8);
+    for (s32 i = 0; i < board.numCells; i++)
+        cells[i / 4] |= (u8) board.cells[i] << (2 * (i % 4));
+}
+
+// Fixed size records to the shard format above
+static void CompressShard(const std::vector<u8>& raw, u32 recordSize, s32 numCells, std::vector<u8>& out)
+{
+    u32 packedSize = recordSize - 6;
+    s32 changed[MAX_DELTA];
+
+    for (size_t offset = 0; offset < raw.size(); offset += recordSize)
+    {
+        const u8* record = &raw[offset];
+        const u8* cells = record + 6;
+
+        s32 numChanged = MAX_DELTA + 1;
+        if (offset > 0)
+        {
+            const u8* last = cells - recordSize;
+            numChanged = 0;
+            for (s32 i = 0; i < numCells && numChanged <= MAX_DELTA; i++)
+            {
+                if (GetCell(cells, i) == GetCell(last, i))
+                    continue;
+                if (numChanged < MAX_DELTA)
+                    changed[numChanged] = i;
+                numChanged++;
+            }
+        }
+
+        bool full = numChanged > MAX_DELTA;
+        s32 score = (s32) (record[2] | record[3] << 8 | record[4] << 16 | (u32) record[5] << 24);
+
+        out.push_back((u8) (record[0] | ((s8) record[1] + 1) << 1 | (full ? FLAG_FULL : 0)));
+        PutVarint(out, ZigZag(score));
+
+        if (full)
+            out.insert(out.end(), cells, cells + packedSize);
+        else
+        {
+            PutVarint(out, (u32) numChanged);
+            for (s32 i = 0; i < numChanged; i++)
+                PutVarint(out, (u32) (changed[i] * 3 + GetCell(cells, changed[i])));
+        }
+    }
+}
+
+// Back to fixed size records, false if the data doesn't hold that many
+static bool DecompressShard(const u8* data, size_t size, u32 samples, u32 recordSize, s32 numCells, std::vector<u8>& raw)
+{
+    const u8* at = data;
+    const u8* end = data + size;
+    u32 packedSize = recordSize - 6;
+    raw.assign((size_t) samples * recordSize, 0);
+
+    for (u32 n = 0; n < samples; n++)
+    {
+        u8* record = &raw[(size_t) n * recordSize];
+        u32 value;
+        if (at >= end)
+            return false;
+
+        u8 flags = *at++;
+        if (!GetVarint(at, end, value))
+            return false;
+
+        record[0] = flags & 1;
+        record[1] = (u8) (s8) (((flags >> 1) & 3) - 1);
+        PutU32(record + 2, (u32) UnZigZag(value));
+
+        u8* cells = record + 6;
+        if (flags & FLAG_FULL)
+        {
+            if ((size_t) (end - at) < packedSize)
+                return false;
+            memcpy(cells, at, packedSize);
+            at += packedSize;
+            continue;
+        }
+
+        if (n == 0 || !GetVarint(at, end, value) || value > (u32) numCells)
+            return false;
+
+        memcpy(cells, cells - recordSize, packedSize);
+        for (u32 count = value; count > 0; count--)
+        {
+            if (!GetVarint(at, end, value) || value / 3 >= (u32) numCells)
+                return false;
+
+            s32 cell = value / 3;
+            cells[cell / 4] = (u8) ((cells[cell / 4] & ~(3 << (2 * (cell % 4)))) | (value % 3) << (2 * (cell % 4)));
+        }
+    }
+
+    return at == end;
+}
+
+// Workers copy finished games into the shard being filled, and full shards
+// queue up for the writer thread, which compresses and writes them. A
+// worker only waits when maxQueued shards are already waiting on the disk,
+// which is counted in stalls.
+struct ShardWriter
+{
+    std::string prefix;
+    u32 recordSize;
+    u32 samplesPerShard;
+    s32 numCells;
+    size_t maxQueued;
+    bool check;             // Decompress every shard again and compare
+    u8 header[16];
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<u8> filling;
+    std::deque<std::vector<u8>> queue;
+    std::vector<std::vector<u8>> spare;     // Written, kept for reuse
+    bool done;
+    u64 stalls;
+
+    std::atomic<u64> samplesAdded;
+    std::atomic<u64> bytesWritten;
+    std::atomic<u64> rawBytes;
+    std::thread thread;
+    FILE* index;
+    u32 numShards;
+    u64 mismatches;
+
+    bool Start(const std::string& outPrefix, const Board& board, u32 shardSamples, u32 queueDepth)
+    {
+        prefix = outPrefix;
+        recordSize = GetRecordSize(board);
+        samplesPerShard = shardSamples;
+        numCells = board.numCells;
+        maxQueued = queueDepth > 0 ? queueDepth : 1;
+
+        memset(header, 0, sizeof(header));
+        memcpy(header, "TTTS", 4);
+        PutU32(header + 4, SHARD_VERSION);
+        header[8] = (u8) board.size;
+        header[9] = (u8) board.winLength;
+
+        std::string indexPath = prefix + ".idx";
+        index = fopen(indexPath.c_str(), "w");
+        if (!index)
+            return false;
+
+        filling.reserve((size_t) recordSize * samplesPerShard);
+        done = false;
+        stalls = 0;
+        samplesAdded = bytesWritten = rawBytes = 0;
+        numShards = 0;
+        mismatches = 0;
+
+        thread = std::thread([this]() { WriterLoop(); });
+        return true;
+    }
+
+    void Add(const std::vector<u8>& records)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        for (size_t offset = 0; offset < records.size(); offset += recordSize)
+        {
+            filling.insert(filling.end(), records.begin() + offset, records.begin() + offset + recordSize);
+
+            if (filling.size() == (size_t) recordSize * samplesPerShard)
+                HandOff(lock);
+        }
+
+        samplesAdded += records.size() / recordSize;
+    }
+
+    void Finish()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!filling.empty())
+                HandOff(lock);
+
+            done = true;
+        }
+
+        cv.notify_all();
+        thread.join();
+        fclose(index);
+    }
+
+    // Queues the full shard and starts another. Must hold the lock.
+    void HandOff(std::unique_lock<std::mutex>& lock)
+    {
+        if (queue.size() >= maxQueued)
+        {
+            stalls++;
+            cv.wait(lock, [this]() { return queue.size() < maxQueued; });
+        }
+
+        queue.push_back(std::move(filling));
+        if (spare.empty())
+        {
+            filling = std::vector<u8>();
+            filling.reserve((size_t) recordSize * samplesPerShard);
+        }
+        else
+        {
+            filling = std::move(spare.back());
+            spare.pop_back();
+        }
+
+        cv.notify_all();
+    }
+
+    void WriterLoop()
+    {
+        std::vector<u8> compressed, decoded;
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true)
+        {
+            cv.wait(lock, [this]() { return !queue.empty() || done; });
+            if (queue.empty())
+                return;
+
+            std::vector<u8> buffer = std::move(queue.front());
+            queue.pop_front();
+            cv.notify_all();
+            lock.unlock();
+
+            compressed.clear();
+            CompressShard(buffer, recordSize, numCells, compressed);
+
+            u32 samples = (u32) (buffer.size() / recordSize);
+            if (check && (!DecompressShard(compressed.data(), compressed.size(), samples, recordSize, numCells, decoded) ||
+                          decoded != buffer))
+                mismatches++;
+
+            WriteShard(compressed, samples);
+            rawBytes += buffer.size();
+            buffer.clear();
+
+            lock.lock();
+            spare.push_back(std::move(buffer));
+        }
+    }
+
+    void WriteShard(const std::vector<u8>& data, u32 samples)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "_%05u.bin", numShards++);
+        std::string path = prefix + name;
+
+        PutU32(header + 12, samples);
+
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            printf("Failed to open '%s'\n", path.c_str());
+            return;
+        }
+
+        fwrite(header, 1, sizeof(header), file);
+        fwrite(data.data(), 1, data.size(), file);
+        fclose(file);
+
+        u64 bytes = sizeof(header) + data.size();
+        bytesWritten += bytes;
+        fprintf(index, "%s %u %llu\n", path.c_str(), samples, bytes);
+        fflush(index);
+    }
+};
+
+int RunSelfPlay(int argc, const char* argv[])
+{
+    s32 size         = (s32) GetFlagInt(argc, argv, "-size", 3);
+    s32 winLength    = (s32) GetFlagInt(argc, argv, "-win", size);
+    u64 numGames     = (u64) GetFlagInt(argc, argv, "-games", 10000);
+    s32 randomPlies  = (s32) GetFlagInt(argc, argv, "-random", 2);
+    u32 shardSamples = (u32) GetFlagInt(argc, argv, "-shard", 1 << 16);
+    u32 queueDepth   = (u32) GetFlagInt(argc, argv, "-queue", 8);
+    u64 seed         = (u64) GetFlagInt(argc, argv, "-seed", 1);
+    const char* out  = GetFlag(argc, argv, "-out", "selfplay");
+    s32 numThreads   = GetThreadCount(argc, argv);
+
+    SearchLimits limits;
+    limits.depth = (s32) GetFlagInt(argc, argv, "-depth", 0);
+    limits.nodes = (u64) GetFlagInt(argc, argv, "-nodes", 10000);
+
+    if (size < 1 || size > Board::MAX_SIZE || shardSamples == 0)
+    {
+        printf("Invalid size or shard size\n");
+        return 1;
+    }
+
+    Board root;
+    root.Init(size, winLength);
+
+    Network network = {};
+    const char* netPath = GetFlag(argc, argv, "-net", nullptr);
+    if (netPath && !network.Load(netPath))
+    {
+        printf("Failed to load network '%s'\n", netPath);
+        return 1;
+    }
+
+    ShardWriter writer;
+    writer.check = HasFlag(argc, argv, "-check");
+    if (!writer.Start(out, root, shardSamples, queueDepth))
+    {
+        printf("Failed to open '%s.idx'\n", out);
+        return 1;
+    }
+
+    std::atomic<u64> nextGame { 0 };
+    std::atomic<s32> running { numThreads };
+    std::vector<std::thread> threads;
+
+    for (s32 t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            Board board = root;
+            Random random;
+            random.Seed(seed * 0x9E3779B97F4A7C15ULL + t + 1);
+
+            TranspositionTable table;
+            table.Init(18);
+
+            Searcher searcher = {};
+            searcher.table = &table;
+            searcher.network = network.loaded ? &network : nullptr;
+
+            u32 recordSize = writer.recordSize;
+            std::vector<u8> records;
+            s32 moves[Board::MAX_MOVES];
+
+            while (nextGame++ < numGames)
+            {
+                board.Clear();
+                records.clear();
+                s32 winner = -1;
+
+                while (true)
+                {
+                    s32 move;
+                    if (board.moveCount < randomPlies)
+                    {
+                        s32 numMoves = board.GenerateMoves(moves);
+                        move = moves[random.Range(numMoves)];
+                    }
+                    else
+                    {
+                        SearchResult result = searcher.Search(board, limits);
+                        move = result.move;
+
+                        records.resize(records.size() + recordSize);
+                        EncodeRecord(board, result.score, &records[records.size() - recordSize]);
+                    }
+
+                    s32 player = board.playerIndex;
+                    board.MakeMove(move);
+
+                    if (board.WonThrough(move))
+                    {
+                        winner = player;
+                        break;
+                    }
+                    if (board.IsFull())
+                        break;
+                }
+
+                for (size_t offset = 0; offset < records.size(); offset += recordSize)
+                {
+                    s32 player = records[offset];
+                    s8 result = winner < 0 ? 0 : (winner == player ? 1 : -1);
+                    records[offset + 1] = (u8) result;
+                }
+
+                writer.Add(records);
+            }
+
+            running--;
+        });
+    }
+
+    // Live throughput while the workers run
+    f64 start = GetSeconds();
+    u64 lastSamples = 0, lastBytes = 0;
+    f64 lastTime = start;
+
+    while (running > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        f64 now = GetSeconds();
+        if (now - lastTime < 1.0)
+            continue;
+
+        u64 samples = writer.samplesAdded;
+        u64 bytes = writer.bytesWritten;
+        f64 interval = now - lastTime;
+
+        printf("%7.1f s  %llu samples  %.0f samples/sec  %.2f MB written  %.2f MB/s\n",
+               now - start, samples, (samples - lastSamples) / interval,
+               bytes / 1e6, (bytes - lastBytes) / 1e6 / interval);
+        fflush(stdout);
+
+        lastSamples = samples;
+        lastBytes = bytes;
+        lastTime = now;
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    writer.Finish();
+
+    f64 elapsed = GetSeconds() - start;
+    u64 samples = writer.samplesAdded;
+    u64 bytes = writer.bytesWritten;
+
+    printf("games       %llu\n", numGames);
+    printf("samples     %llu\n", samples);
+    printf("shards      %u\n", writer.numShards);
+    printf("bytes       %llu (%.1fx smaller than %llu packed)\n", bytes, (f64) writer.rawBytes / (bytes ? bytes : 1), writer.rawBytes.load());
+    printf("stalls      %llu\n", writer.stalls);
+    printf("time        %.3f s\n", elapsed);
+    printf("samples/sec %.0f\n", samples / elapsed);
+    printf("MB/s        %.2f\n", bytes / 1e6 / elapsed);
+    if (writer.check)
+        printf("mismatches  %llu\n", writer.mismatches);
+
+    return writer.mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include "tools.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "universal/types.h"
+#include "game/nnue.h"
+#include "net/server.h"
+
+int RunServer(int argc, const char* argv[])
+{
+    u16 port         = (u16) GetFlagInt(argc, argv, "-port", 7474);
+    s32 numWorkers   = GetThreadCount(argc, argv);
+    f64 seconds      = GetFlagFloat(argc, argv, "-seconds", 0.0);
+    bool localOnly   = HasFlag(argc, argv, "-local");
+
+    // Static, it's big and the loop and workers hang on to it
+    static Network network = {};
+    const char* netPath = GetFlag(argc, argv, "-net", nullptr);
+    if (netPath && !network.Load(netPath))
+    {
+        printf("Failed to load network '%s'\n", netPath);
+        return 1;
+    }
+
+    static GameServer server;
+    server.network = network.loaded ? &network : nullptr;
+    server.maxMatchesPerConnection = (u32) GetFlagInt(argc, argv, "-matches", 4096);
+    server.journalPath = GetFlag(argc, argv, "-journal", nullptr);
+    server.snapshotSeconds = GetFlagFloat(argc, argv, "-snapshot", 10.0);
+
+    f64 start = GetSeconds();
+    if (!server.Start(port, numWorkers, localOnly))
+    {
+        printf("Failed to listen on port %u or to read the journal\n", port);
+        return 1;
+    }
+
+    if (server.journalPath)
+        printf("Recovered %u matches from '%s' in %.3f s\n", server.recoveredMatches, server.journalPath, GetSeconds() - start);
+
+    printf("Listening on port %u with %d workers\n", server.GetPort(), numWorkers);
+    fflush(stdout);
+
+    // Stats once a second until -seconds runs out, or forever
+    start = GetSeconds();
+    f64 lastPrint = start;
+    u64 lastMoves = 0;
+    u64 lastAcks = 0;
+    u64 lastAckMicros = 0;
+
+    while (seconds <= 0.0 || GetSeconds() - start < seconds)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        f64 now = GetSeconds();
+        if (now - lastPrint < 1.0)
+            continue;
+
+        ServerStats& stats = server.stats;
+        u64 moves     = stats.moves;
+        u64 acks      = stats.acks;
+        u64 ackMicros = stats.ackMicros;
+        u64 ackMax    = stats.ackMaxMicros.exchange(0);
+
+        f64 ackMean = acks > lastAcks ? (f64) (ackMicros - lastAckMicros) / (acks - lastAcks) : 0.0;
+
+        printf("%7.1f s  %llu connections  %llu live matches  %.0f moves/sec  ack mean %.0f us  max %llu us\n",
+               now - start, stats.connections.load(), stats.liveMatches.load(),
+               (moves - lastMoves) / (now - lastPrint), ackMean, ackMax);
+        fflush(stdout);
+
+        lastPrint = now;
+        lastMoves = moves;
+        lastAcks = acks;
+        lastAckMicros = ackMicros;
+    }
+
+    server.Stop();
+
+    printf("matches     %llu\n", server.stats.matchesStarted.load());
+    printf("moves       %llu\n", server.stats.moves.load());
+    printf("errors      %llu\n", server.stats.errors.load());
+
+    if (server.journalPath)
+    {
+        Journal& journal = server.journal;
+        printf("journaled   %llu records in %llu syncs\n", journal.records.load(), journal.batches.load());
+        printf("snapshots   %llu\n", journal.snapshots.load());
+        printf("failed      %s\n", journal.failed ? "yes" : "no");
+    }
+    return 0;
+}
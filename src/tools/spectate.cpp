@@ -0,0 +1,499 @@
+#include "tools.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "universal/histogram.h"
+#include "platform/socket.h"
+#include "game/board.h"
+#include "game/match.h"
+#include "net/protocol.h"
+#include "net/server.h"
+
+// Spectators for a server in this process. One connection plays a few
+// long matches against the computer while thousands of viewers watch them,
+// some from the start and some joining part way through. Every viewer
+// rebuilds the board from what it's sent and has to end up with the same
+// one as the player. The server's counters show each move being encoded
+// once for all of its viewers. Last, a player leaves a match part way and
+// its viewer has to hear that it's over.
+
+struct Viewer
+{
+    Socket socket;
+    std::vector<u8> in;
+    s32 slot;
+    f64 joinAt;         // Seconds after play starts, 0 to watch from the start
+    Match match;
+    bool watching;
+    bool synced;        // Has had a BOARD
+    bool done;
+    bool tooLate;       // The match was over before it got to watch
+};
+
+struct ViewerThread
+{
+    std::vector<Viewer> viewers;
+    Histogram delivery;
+    u64 frames;
+    u64 gaps;           // A STATE that skipped a move
+};
+
+static std::unique_ptr<std::atomic<u32>[]> matchIds;
+static std::unique_ptr<std::atomic<f64>[]> sentAt;     // By slot and move number, for the player's moves
+static std::atomic<bool> idsReady;
+static std::atomic<s32> earlyWatching;
+static std::atomic<f64> playStart;
+
+static s32 GetMoveSlot(s32 slot, s32 moveNumber)
+{
+    return slot * (Board::MAX_MOVES + 1) + moveNumber;
+}
+
+static void SendMessage(Socket socket, const Message& message)
+{
+    std::vector<u8> out;
+    EncodeMessage(message, out);
+
+    // Small enough to always go out in one go on a fresh socket
+    SendSome(socket, out.data(), (s32) out.size());
+}
+
+static void RunPlayer(u16 port, s32 numMatches, s32 size, s32 winLength, s32 numEarly, f64 interval,
+                      std::vector<Match>& truth, u64& moves)
+{
+    Socket socket = ConnectTcp("127.0.0.1", port);
+    SetNonBlocking(socket);
+    SetNoDelay(socket);
+
+    Random random;
+    random.Seed(1);
+
+    for (s32 slot = 0; slot < numMatches; slot++)
+    {
+        Message message = {};
+        message.type      = MessageType::NEW_GAME;
+        message.size      = (u8) size;
+        message.winLength = (u8) winLength;
+        message.level     = 0;
+        message.player    = 0;
+        SendMessage(socket, message);
+
+        truth[slot].Start(size, winLength);
+    }
+
+    // Replies come back in the order the matches were asked for
+    std::vector<u8> in;
+    s32 started = 0;
+    s32 finished = 0;
+    bool playing = false;
+    f64 nextMove = 0.0;
+    moves = 0;
+
+    while (finished < numMatches)
+    {
+        u8 buffer[4096];
+        s32 received = RecvSome(socket, buffer, sizeof(buffer));
+        if (received < 0)
+            break;
+
+        in.insert(in.end(), buffer, buffer + received);
+
+        size_t offset = 0;
+        Message message;
+        s32 length;
+        while ((length = DecodeMessage(in.data() + offset, (s32) (in.size() - offset), message)) > 0)
+        {
+            offset += length;
+
+            if (message.type == MessageType::STARTED)
+            {
+                matchIds[started++] = message.match;
+                if (started == numMatches)
+                    idsReady = true;
+            }
+            else if (message.type == MessageType::STATE)
+            {
+                s32 slot = (s32) (std::find_if(&matchIds[0], &matchIds[0] + numMatches,
+                                               [&](const std::atomic<u32>& id) { return id == message.match; }) - &matchIds[0]);
+
+                // Ours were played when they were sent
+                Match& match = truth[slot];
+                if (message.moveNumber == match.board.moveCount + 1 && message.cell != NO_CELL)
+                    match.Play(message.cell);
+
+                if (message.status != (u8) MatchStatus::PLAYING)
+                    finished++;
+            }
+        }
+
+        in.erase(in.begin(), in.begin() + offset);
+
+        if (!playing)
+        {
+            // Moves start once everyone watching from the start is
+            if (!idsReady || earlyWatching < numEarly)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            playing = true;
+            playStart = GetSeconds();
+            nextMove = playStart;
+        }
+
+        f64 now = GetSeconds();
+        if (now < nextMove)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+
+        nextMove += interval;
+
+        // A move in every match that's waiting on us
+        for (s32 slot = 0; slot < numMatches; slot++)
+        {
+            Match& match = truth[slot];
+            if (match.IsOver() || match.board.playerIndex != 0)
+                continue;
+
+            s32 cell;
+            do
+            {
+                cell = random.Range(match.board.numCells);
+            } while (match.board.cells[cell] != CellElement::EMPTY);
+
+            Message place = {};
+            place.type       = MessageType::PLACE;
+            place.match      = matchIds[slot];
+            place.moveNumber = (u16) match.board.moveCount;
+            place.cell       = (u16) cell;
+
+            match.Play(cell);
+            sentAt[GetMoveSlot(slot, match.board.moveCount)] = GetSeconds();
+            SendMessage(socket, place);
+            moves++;
+        }
+    }
+
+    CloseSocket(socket);
+}
+
+static void RunViewers(ViewerThread& thread, u16 port, f64 seconds)
+{
+    Poller poller;
+    poller.Init();
+
+    for (u32 i = 0; i < thread.viewers.size(); i++)
+    {
+        Viewer& viewer = thread.viewers[i];
+        viewer.socket = ConnectTcp("127.0.0.1", port);
+        viewer.watching = viewer.synced = viewer.done = viewer.tooLate = false;
+
+        SetNonBlocking(viewer.socket);
+        poller.Add(viewer.socket, i);
+    }
+
+    thread.delivery.Clear();
+    thread.frames = thread.gaps = 0;
+
+    while (!idsReady)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    std::vector<CellElement> cells;
+    PollEvent events[256];
+    f64 deadline = GetSeconds() + seconds;
+
+    while (GetSeconds() < deadline)
+    {
+        // Late joiners watch once their time comes
+        bool allDone = true;
+        f64 started = playStart;
+
+        for (Viewer& viewer : thread.viewers)
+        {
+            allDone = allDone && viewer.done;
+
+            if (!viewer.watching && (viewer.joinAt == 0.0 || (started > 0.0 && GetSeconds() - started >= viewer.joinAt)))
+            {
+                Message watch = {};
+                watch.type  = MessageType::WATCH;
+                watch.match = matchIds[viewer.slot];
+                SendMessage(viewer.socket, watch);
+                viewer.watching = true;
+            }
+        }
+
+        if (allDone)
+            break;
+
+        s32 numEvents = poller.Wait(events, 256, 10);
+        f64 now = GetSeconds();
+
+        for (s32 e = 0; e < numEvents; e++)
+        {
+            Viewer& viewer = thread.viewers[(u32) events[e].data];
+
+            u8 buffer[4096];
+            s32 received;
+            while ((received = RecvSome(viewer.socket, buffer, sizeof(buffer))) > 0)
+                viewer.in.insert(viewer.in.end(), buffer, buffer + received);
+
+            size_t offset = 0;
+            Message message;
+            s32 length;
+            while ((length = DecodeMessage(viewer.in.data() + offset, (s32) (viewer.in.size() - offset), message)) > 0)
+            {
+                offset += length;
+                thread.frames++;
+
+                Board& board = viewer.match.board;
+
+                if (message.type == MessageType::BOARD)
+                {
+                    cells.resize(message.size * message.size);
+                    UnpackCells(message.cells, (s32) cells.size(), cells.data());
+
+                    viewer.match.Start(message.size, message.winLength);
+                    viewer.match.SetPosition(cells.data(), message.player);
+                    viewer.match.status = (MatchStatus) message.status;
+
+                    if (!viewer.synced && viewer.joinAt == 0.0)
+                        earlyWatching++;
+
+                    viewer.synced = true;
+                }
+                else if (message.type == MessageType::ERROR)
+                {
+                    viewer.tooLate = true;
+                }
+                else if (message.type == MessageType::STATE && viewer.synced)
+                {
+                    if (message.moveNumber > board.moveCount + 1)
+                        thread.gaps++;
+
+                    if (message.moveNumber == board.moveCount + 1 && message.cell != NO_CELL)
+                    {
+                        viewer.match.Play(message.cell);
+
+                        f64 sent = sentAt[GetMoveSlot(viewer.slot, message.moveNumber)];
+                        if (sent > 0.0)
+                            thread.delivery.Add((u64) ((now - sent) * 1e6));
+                    }
+
+                    viewer.match.status = (MatchStatus) message.status;
+                }
+
+                viewer.done = viewer.tooLate || (viewer.synced && viewer.match.IsOver());
+            }
+
+            viewer.in.erase(viewer.in.begin(), viewer.in.begin() + offset);
+        }
+    }
+
+    for (Viewer& viewer : thread.viewers)
+        CloseSocket(viewer.socket);
+
+    poller.Free();
+}
+
+// Next message on a non-blocking socket, false if none came in time
+static bool WaitForMessage(Socket socket, std::vector<u8>& in, Message& message, f64 timeout)
+{
+    f64 until = GetSeconds() + timeout;
+    while (true)
+    {
+        s32 length = DecodeMessage(in.data(), (s32) in.size(), message);
+        if (length > 0)
+        {
+            in.erase(in.begin(), in.begin() + length);
+            return true;
+        }
+
+        u8 buffer[1024];
+        s32 received = RecvSome(socket, buffer, sizeof(buffer));
+        if (received < 0 || length < 0 || GetSeconds() > until)
+            return false;
+
+        in.insert(in.end(), buffer, buffer + received);
+        if (received == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// A player who goes away part way through a match against the computer
+// loses it, and someone watching has to be told the match is over
+static bool CheckAbandoned(u16 port, s32 size, s32 winLength)
+{
+    Socket player = ConnectTcp("127.0.0.1", port);
+    Socket viewer = ConnectTcp("127.0.0.1", port);
+    SetNonBlocking(player);
+    SetNonBlocking(viewer);
+
+    Message message = {};
+    message.type      = MessageType::NEW_GAME;
+    message.size      = (u8) size;
+    message.winLength = (u8) winLength;
+    message.level     = 0;
+    message.player    = 0;
+    SendMessage(player, message);
+
+    std::vector<u8> playerIn, viewerIn;
+    bool ok = WaitForMessage(player, playerIn, message, 2.0) && message.type == MessageType::STARTED;
+    u32 match = message.match;
+
+    if (ok)
+    {
+        message = {};
+        message.type  = MessageType::WATCH;
+        message.match = match;
+        SendMessage(viewer, message);
+
+        ok = WaitForMessage(viewer, viewerIn, message, 2.0) && message.type == MessageType::BOARD;
+    }
+
+    CloseSocket(player);
+
+    bool over = false;
+    while (ok && !over && WaitForMessage(viewer, viewerIn, message, 2.0))
+        over = message.type == MessageType::STATE && message.match == match && message.status == (u8) MatchStatus::CIRCLE_WON;
+
+    CloseSocket(viewer);
+    return ok && over;
+}
+
+int RunSpectate(int argc, const char* argv[])
+{
+    s32 numMatches  = (s32) GetFlagInt(argc, argv, "-matches", 8);
+    s32 numViewers  = (s32) GetFlagInt(argc, argv, "-viewers", 2000);
+    f64 late        = GetFlagFloat(argc, argv, "-late", 0.5);
+    s32 size        = (s32) GetFlagInt(argc, argv, "-size", 15);
+    s32 winLength   = (s32) GetFlagInt(argc, argv, "-win", 5);
+    f64 interval    = GetFlagFloat(argc, argv, "-interval", 20.0) / 1000.0;
+    f64 seconds     = GetFlagFloat(argc, argv, "-seconds", 60.0);
+    s32 numThreads  = std::min(GetThreadCount(argc, argv), std::max(numViewers, 1));
+
+    if (numMatches < 1 || numViewers < 0 || size < 1 || size > Board::MAX_SIZE || winLength < 1 || winLength > size)
+    {
+        printf("Invalid matches, viewers, size or win length\n");
+        return 1;
+    }
+
+    static GameServer server;
+    server.network = nullptr;
+    server.maxMatchesPerConnection = 0;
+
+    if (!server.Start(0, (s32) GetFlagInt(argc, argv, "-workers", 2), true))
+    {
+        printf("Failed to start the server\n");
+        return 1;
+    }
+
+    u16 port = server.GetPort();
+
+    matchIds.reset(new std::atomic<u32>[numMatches]);
+    sentAt.reset(new std::atomic<f64>[GetMoveSlot(numMatches, 0)]);
+    for (s32 i = 0; i < GetMoveSlot(numMatches, 0); i++)
+        sentAt[i] = 0.0;
+
+    idsReady = false;
+    earlyWatching = 0;
+    playStart = 0.0;
+
+    // Late joiners come in over the first half of a game at most
+    Random random;
+    random.Seed(2);
+
+    s32 numEarly = 0;
+    s32 numLate = 0;
+    f64 lateWindow = interval * size * size / 4.0;
+
+    std::vector<ViewerThread> viewerThreads(numThreads);
+    for (s32 i = 0; i < numViewers; i++)
+    {
+        Viewer viewer = {};
+        viewer.slot = i % numMatches;
+        viewer.joinAt = random.Unit() < late ? 0.001 + random.Unit() * lateWindow : 0.0;
+
+        if (viewer.joinAt == 0.0)
+            numEarly++;
+        else
+            numLate++;
+
+        viewerThreads[i % numThreads].viewers.push_back(viewer);
+    }
+
+    std::vector<std::thread> threads;
+    for (ViewerThread& thread : viewerThreads)
+        threads.emplace_back(RunViewers, std::ref(thread), port, seconds);
+
+    std::vector<Match> truth(numMatches);
+    u64 moves = 0;
+    f64 start = GetSeconds();
+    std::thread player(RunPlayer, port, numMatches, size, winLength, numEarly, interval, std::ref(truth), std::ref(moves));
+
+    player.join();
+    f64 playTime = GetSeconds() - playStart;
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    bool abandonedOk = CheckAbandoned(port, size, winLength);
+
+    ServerStats& stats = server.stats;
+    u64 framesEncoded = stats.spectatorFrames;
+    u64 bytesSent = stats.spectatorBytes;
+    u64 catchUps = stats.catchUps;
+    server.Stop();
+
+    static Histogram delivery;
+    delivery.Clear();
+
+    u64 frames = 0, gaps = 0, mismatches = 0, unfinished = 0, tooLate = 0;
+    for (const ViewerThread& thread : viewerThreads)
+    {
+        delivery.Merge(thread.delivery);
+        frames += thread.frames;
+        gaps += thread.gaps;
+
+        for (const Viewer& viewer : thread.viewers)
+        {
+            if (viewer.tooLate)
+                tooLate++;
+            else if (!viewer.done)
+                unfinished++;
+            else if (viewer.match.board.cells != truth[viewer.slot].board.cells)
+                mismatches++;
+        }
+    }
+
+    u64 allMoves = 0;
+    for (const Match& match : truth)
+        allMoves += match.board.moveCount;
+
+    printf("matches       %d\n", numMatches);
+    printf("viewers       %d (%d joined late, %llu after the end)\n", numViewers, numLate, tooLate);
+    printf("moves         %llu (%llu by the player)\n", allMoves, moves);
+    printf("encoded       %llu frames, %.2f per move\n", framesEncoded, allMoves ? (f64) framesEncoded / allMoves : 0.0);
+    printf("received      %llu frames\n", frames);
+    printf("fanned out    %.1f KB\n", bytesSent / 1024.0);
+    printf("catch ups     %llu\n", catchUps);
+    printf("time          %.2f s (%.2f s with setup)\n", playTime, GetSeconds() - start);
+    printf("delivery p50  %llu us\n", delivery.Percentile(0.5));
+    printf("delivery p99  %llu us\n", delivery.Percentile(0.99));
+    printf("delivery max  %llu us\n", delivery.max);
+    printf("gaps          %llu\n", gaps);
+    printf("unfinished    %llu\n", unfinished);
+    printf("mismatches    %llu\n", mismatches);
+    printf("abandoned     %s\n", abandonedOk ? "ok" : "FAILED");
+
+    return gaps == 0 && unfinished == 0 && mismatches == 0 && abandonedOk ? 0 : 1;
+}
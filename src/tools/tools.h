@@ -0,0 +1,43 @@
+#pragma once
+
+#include "universal/types.h"
+
+// Headless commands run by tttcli. They take the arguments
+// after the command name and return the process exit code.
+struct Tool
+{
+    const char* name;
+    const char* usage;
+    int (*Run)(int argc, const char* argv[]);
+};
+
+int RunPerft(int argc, const char* argv[]);
+int RunBench(int argc, const char* argv[]);
+int RunSelfPlay(int argc, const char* argv[]);
+int RunTournament(int argc, const char* argv[]);
+int RunCalibrate(int argc, const char* argv[]);
+int RunPuzzles(int argc, const char* argv[]);
+int RunConnectFour(int argc, const char* argv[]);
+int RunInfinite(int argc, const char* argv[]);
+int RunEngine(int argc, const char* argv[]);
+int RunServer(int argc, const char* argv[]);
+int RunLoadGen(int argc, const char* argv[]);
+int RunMatchmaking(int argc, const char* argv[]);
+int RunJournal(int argc, const char* argv[]);
+int RunSpectate(int argc, const char* argv[]);
+int RunClocks(int argc, const char* argv[]);
+int RunReplays(int argc, const char* argv[]);
+int RunAnnotate(int argc, const char* argv[]);
+int RunNetworkCheck(int argc, const char* argv[]);
+
+// Flags are passed as "-name value" like the ones in clargs
+bool        HasFlag(int argc, const char* argv[], const char name[]);
+const char* GetFlag(int argc, const char* argv[], const char name[], const char defaultValue[]);
+s64         GetFlagInt(int argc, const char* argv[], const char name[], s64 defaultValue);
+f64         GetFlagFloat(int argc, const char* argv[], const char name[], f64 defaultValue);
+
+// Number of worker threads for -threads, 0 or missing means all cores
+s32 GetThreadCount(int argc, const char* argv[]);
+
+// Seconds since an arbitrary point, for throughput numbers
+f64 GetSeconds();
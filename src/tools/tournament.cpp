@@ -0,0 +1,388 @@
+#include "tools.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "universal/types.h"
+#include "universal/random.h"
+#include "game/board.h"
+#include "game/search.h"
+#include "game/nnue.h"
+#include "game/player.h"
+
+// Pits computer player configurations against each other. Games are played
+// in pairs from the same random opening with colours swapped, so neither
+// side gets a better set of openings or more games as cross.
+
+struct Pairing
+{
+    s32 a, b;
+    u64 wins, draws, losses;    // For a
+};
+
+struct EloEstimate
+{
+    f64 elo;
+    f64 error;      // 95% confidence
+    f64 llr;        // SPRT log likelihood ratio
+    bool hasVariance;
+};
+
+static f64 EloFromScore(f64 score)
+{
+    if (score < 1e-6)
+        score = 1e-6;
+    if (score > 1.0 - 1e-6)
+        score = 1.0 - 1e-6;
+
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+static f64 ScoreFromElo(f64 elo)
+{
+    return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+// Normal approximation of the per game scores, like most SPRT tools use
+static EloEstimate Estimate(u64 wins, u64 draws, u64 losses, f64 elo0, f64 elo1)
+{
+    EloEstimate estimate = {};
+
+    f64 n = (f64) (wins + draws + losses);
+    if (n == 0.0)
+        return estimate;
+
+    f64 score = (wins + 0.5 * draws) / n;
+    f64 variance = (wins * (1.0 - score) * (1.0 - score) +
+                    draws * (0.5 - score) * (0.5 - score) +
+                    losses * score * score) / n;
+
+    estimate.elo = EloFromScore(score);
+    estimate.hasVariance = variance > 0.0;
+    if (!estimate.hasVariance)
+        return estimate;
+
+    f64 margin = 1.96 * sqrt(variance / n);
+    estimate.error = (EloFromScore(score + margin) - EloFromScore(score - margin)) / 2.0;
+
+    f64 s0 = ScoreFromElo(elo0);
+    f64 s1 = ScoreFromElo(elo1);
+    f64 total = wins + 0.5 * draws;
+    estimate.llr = (s1 - s0) * (2.0 * total - n * (s0 + s1)) / (2.0 * variance);
+
+    return estimate;
+}
+
+// Returns the winner, -1 for a draw
+static s32 PlayGame(Board& board, const ComputerPlayer* players[2],
+                    Searcher searchers[2], Random& random)
+{
+    while (true)
+    {
+        s32 player = board.playerIndex;
+        s32 move = players[player]->ChooseMove(board, searchers[player], random);
+        board.MakeMove(move);
+
+        if (board.WonThrough(move))
+            return player;
+        if (board.IsFull())
+            return -1;
+    }
+}
+
+// Random moves that don't end the game. Same seed, same opening.
+static void PlayOpening(Board& board, s32 plies, u64 seed)
+{
+    Random random;
+    random.Seed(seed);
+    s32 moves[Board::MAX_MOVES];
+
+    for (s32 attempt = 0; attempt < 100; attempt++)
+    {
+        board.Clear();
+
+        bool ended = false;
+        for (s32 i = 0; i < plies && !ended; i++)
+        {
+            s32 numMoves = board.GenerateMoves(moves);
+            s32 move = moves[random.Range(numMoves)];
+            board.MakeMove(move);
+            ended = board.WonThrough(move) || board.IsFull();
+        }
+
+        if (!ended)
+            return;
+    }
+
+    board.Clear();
+}
+
+// Plays gamePairs pairs of games for every pairing on numThreads threads
+static void PlayPairings(const std::vector<ComputerPlayer>& players, std::vector<Pairing>& pairings,
+                         const Board& root, u64 gamePairs, s32 openingPlies, u64 seed, s32 numThreads)
+{
+    u64 numTasks = pairings.size() * gamePairs;
+    std::atomic<u64> nextTask { 0 };
+    std::mutex resultsMutex;
+    std::vector<std::thread> threads;
+
+    for (s32 t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([&]()
+        {
+            Board board = root;
+            Random random;
+
+            TranspositionTable tables[2];
+            Searcher searchers[2] = {};
+            for (int i = 0; i < 2; i++)
+            {
+                tables[i].Init(16);
+                searchers[i].table = &tables[i];
+            }
+
+            for (u64 task = nextTask++; task < numTasks; task = nextTask++)
+            {
+                Pairing& pairing = pairings[task / gamePairs];
+                u64 openingSeed = seed * 0x9E3779B97F4A7C15ULL + task % gamePairs + 1;
+                u64 wins = 0, draws = 0, losses = 0;
+
+                for (int swap = 0; swap < 2; swap++)
+                {
+                    const ComputerPlayer* sides[2] = {
+                        &players[swap ? pairing.b : pairing.a],
+                        &players[swap ? pairing.a : pairing.b],
+                    };
+
+                    // Fresh tables and random numbers so a game doesn't depend
+                    // on which thread played it or what came before
+                    tables[0].Clear();
+                    tables[1].Clear();
+                    random.Seed(openingSeed + swap);
+
+                    PlayOpening(board, openingPlies, openingSeed);
+                    s32 winner = PlayGame(board, sides, searchers, random);
+
+                    if (winner < 0)
+                        draws++;
+                    else if ((winner == 0) != (swap == 1))
+                        wins++;
+                    else
+                        losses++;
+                }
+
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                pairing.wins   += wins;
+                pairing.draws  += draws;
+                pairing.losses += losses;
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+int RunTournament(int argc, const char* argv[])
+{
+    s32 size         = (s32) GetFlagInt(argc, argv, "-size", 3);
+    s32 winLength    = (s32) GetFlagInt(argc, argv, "-win", size);
+    u64 gamePairs    = (u64) GetFlagInt(argc, argv, "-pairs", 50);
+    s32 openingPlies = (s32) GetFlagInt(argc, argv, "-opening", 2);
+    u64 seed         = (u64) GetFlagInt(argc, argv, "-seed", 1);
+    f64 elo0         = GetFlagFloat(argc, argv, "-elo0", 0.0);
+    f64 elo1         = GetFlagFloat(argc, argv, "-elo1", 10.0);
+    f64 alpha        = GetFlagFloat(argc, argv, "-alpha", 0.05);
+    f64 beta         = GetFlagFloat(argc, argv, "-beta", 0.05);
+    bool gauntlet    = HasFlag(argc, argv, "-gauntlet");
+    const char* list = GetFlag(argc, argv, "-players", "search,random");
+    s32 numThreads   = GetThreadCount(argc, argv);
+
+    if (size < 1 || size > Board::MAX_SIZE)
+    {
+        printf("Invalid size\n");
+        return 1;
+    }
+
+    Network network = {};
+    const char* netPath = GetFlag(argc, argv, "-net", nullptr);
+    if (netPath && !network.Load(netPath))
+    {
+        printf("Failed to load network '%s'\n", netPath);
+        return 1;
+    }
+
+    // Comma separated player specs
+    std::vector<ComputerPlayer> players;
+    std::string specs = list;
+    for (size_t start = 0; start <= specs.size();)
+    {
+        size_t end = specs.find(',', start);
+        if (end == std::string::npos)
+            end = specs.size();
+
+        ComputerPlayer player;
+        std::string spec = specs.substr(start, end - start);
+        if (!player.Parse(spec.c_str()))
+        {
+            printf("Player '%s' not recognised\n", spec.c_str());
+            return 1;
+        }
+
+        player.network = network.loaded ? &network : nullptr;
+        players.push_back(player);
+        start = end + 1;
+    }
+
+    if (players.size() < 2)
+    {
+        printf("Need at least two players\n");
+        return 1;
+    }
+
+    // Round robin plays everyone against everyone, gauntlet
+    // only the first player against the rest
+    std::vector<Pairing> pairings;
+    for (s32 a = 0; a < (s32) players.size(); a++)
+        for (s32 b = a + 1; b < (s32) players.size(); b++)
+        {
+            if (gauntlet && a != 0)
+                continue;
+            pairings.push_back(Pairing { a, b, 0, 0, 0 });
+        }
+
+    Board root;
+    root.Init(size, winLength);
+
+    u64 numTasks = pairings.size() * gamePairs;
+    f64 start = GetSeconds();
+    PlayPairings(players, pairings, root, gamePairs, openingPlies, seed, numThreads);
+
+    f64 elapsed = GetSeconds() - start;
+
+    f64 lower = log(beta / (1.0 - alpha));
+    f64 upper = log((1.0 - beta) / alpha);
+
+    printf("%llu games on %dx%d (%d in a row), %d thread(s), %.3f s, %.0f games/sec\n",
+           numTasks * 2, size, size, winLength, numThreads, elapsed, numTasks * 2 / elapsed);
+    printf("SPRT elo0 %.1f elo1 %.1f, LLR bounds [%.2f, %.2f]\n\n", elo0, elo1, lower, upper);
+
+    for (const Pairing& pairing : pairings)
+    {
+        EloEstimate estimate = Estimate(pairing.wins, pairing.draws, pairing.losses, elo0, elo1);
+
+        printf("%s vs %s\n", players[pairing.a].name.c_str(), players[pairing.b].name.c_str());
+        printf("    W %llu  D %llu  L %llu  ", pairing.wins, pairing.draws, pairing.losses);
+
+        if (!estimate.hasVariance)
+        {
+            printf("Elo %+.1f  SPRT n/a (every game had the same result)\n", estimate.elo);
+            continue;
+        }
+
+        const char* verdict = "inconclusive";
+        if (estimate.llr >= upper)
+            verdict = "pass";
+        else if (estimate.llr <= lower)
+            verdict = "fail";
+
+        printf("Elo %+.1f +/- %.1f  LLR %.2f  SPRT %s\n", estimate.elo, estimate.error, estimate.llr, verdict);
+    }
+
+    // Overall standings against everyone each player met
+    if (!gauntlet && players.size() > 2)
+    {
+        printf("\nStandings\n");
+        for (s32 i = 0; i < (s32) players.size(); i++)
+        {
+            u64 wins = 0, draws = 0, losses = 0;
+            for (const Pairing& pairing : pairings)
+            {
+                if (pairing.a == i)
+                {
+                    wins += pairing.wins;
+                    losses += pairing.losses;
+                    draws += pairing.draws;
+                }
+                else if (pairing.b == i)
+                {
+                    wins += pairing.losses;
+                    losses += pairing.wins;
+                    draws += pairing.draws;
+                }
+            }
+
+            EloEstimate estimate = Estimate(wins, draws, losses, elo0, elo1);
+            printf("    %-32s W %llu  D %llu  L %llu  Elo %+.1f +/- %.1f\n", players[i].name.c_str(),
+                   wins, draws, losses, estimate.elo, estimate.error);
+        }
+    }
+
+    return 0;
+}
+
+
+// Plays every difficulty level against a fixed reference player so the
+// levels can be kept at the same strength as the engine changes
+int RunCalibrate(int argc, const char* argv[])
+{
+    s32 size         = (s32) GetFlagInt(argc, argv, "-size", 3);
+    s32 winLength    = (s32) GetFlagInt(argc, argv, "-win", size);
+    u64 gamePairs    = (u64) GetFlagInt(argc, argv, "-pairs", 200);
+    s32 openingPlies = (s32) GetFlagInt(argc, argv, "-opening", 1);
+    u64 seed         = (u64) GetFlagInt(argc, argv, "-seed", 1);
+    const char* spec = GetFlag(argc, argv, "-reference", "random");
+    s32 numThreads   = GetThreadCount(argc, argv);
+
+    if (size < 1 || size > Board::MAX_SIZE)
+    {
+        printf("Invalid size\n");
+        return 1;
+    }
+
+    std::vector<ComputerPlayer> players(NUM_LEVELS + 1);
+    std::vector<Pairing> pairings;
+
+    for (s32 level = 0; level < NUM_LEVELS; level++)
+    {
+        players[level].Parse(GetLevelSpec(level));
+        pairings.push_back(Pairing { level, NUM_LEVELS, 0, 0, 0 });
+    }
+
+    if (!players[NUM_LEVELS].Parse(spec))
+    {
+        printf("Player '%s' not recognised\n", spec);
+        return 1;
+    }
+
+    Board root;
+    root.Init(size, winLength);
+
+    f64 start = GetSeconds();
+    PlayPairings(players, pairings, root, gamePairs, openingPlies, seed, numThreads);
+    f64 elapsed = GetSeconds() - start;
+
+    printf("Levels against %s, %llu games each on %dx%d (%d in a row), %.3f s\n\n",
+           spec, gamePairs * 2, size, size, winLength, elapsed);
+
+    f64 previous = 0.0;
+    for (s32 level = 0; level < NUM_LEVELS; level++)
+    {
+        const Pairing& pairing = pairings[level];
+        EloEstimate estimate = Estimate(pairing.wins, pairing.draws, pairing.losses, 0.0, 0.0);
+
+        printf("%-8s %-40s W %llu  D %llu  L %llu  Elo %+.1f +/- %.1f%s\n",
+               GetLevelName(level), GetLevelSpec(level), pairing.wins, pairing.draws, pairing.losses,
+               estimate.elo, estimate.error,
+               level > 0 && estimate.elo <= previous ? "  (not stronger than the level below)" : "");
+
+        previous = estimate.elo;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "basic_types.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit, value can't be 0
+inline s32 LowestBit(u64 value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (s32) index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+inline s32 PopCount(u64 value)
+{
+#ifdef _MSC_VER
+    return (s32) __popcnt64(value);
+#else
+    return __builtin_popcountll(value);
+#endif
+}
+
+
+// Index of the highest set bit, value can't be 0
+inline s32 HighestBit(u64 value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (s32) index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "histogram.h"
+
+#include <cstring>
+#include "basic_types.h"
+#include "bits.h"
+
+s32 Histogram::BucketOf(u64 value)
+{
+    if (value < Histogram::SUB_BUCKETS)
+        return (s32) value;
+
+    s32 exponent = HighestBit(value);
+    s32 sub = (s32) (value >> (exponent - Histogram::SUB_BITS)) & (Histogram::SUB_BUCKETS - 1);
+    return (exponent - Histogram::SUB_BITS + 1) * Histogram::SUB_BUCKETS + sub;
+}
+
+// Middle of the range of values that land in bucket
+static u64 GetBucketValue(s32 bucket)
+{
+    if (bucket < Histogram::SUB_BUCKETS)
+        return (u64) bucket;
+
+    s32 shift = bucket / Histogram::SUB_BUCKETS - 1;
+    u64 lowest = (u64) (Histogram::SUB_BUCKETS + bucket % Histogram::SUB_BUCKETS) << shift;
+    return lowest + ((1ULL << shift) >> 1);
+}
+
+void Histogram::Clear()
+{
+    memset(counts, 0, sizeof(counts));
+    count = 0;
+    total = 0;
+    max   = 0;
+}
+
+void Histogram::Add(u64 value)
+{
+    counts[BucketOf(value)]++;
+    count++;
+    total += value;
+    max = value > max ? value : max;
+}
+
+void Histogram::Merge(const Histogram& other)
+{
+    for (s32 i = 0; i < NUM_BUCKETS; i++)
+        counts[i] += other.counts[i];
+
+    count += other.count;
+    total += other.total;
+    max = other.max > max ? other.max : max;
+}
+
+u64 Histogram::Percentile(f64 fraction) const
+{
+    if (count == 0)
+        return 0;
+
+    u64 target = (u64) (fraction * count + 0.5);
+    target = target < 1 ? 1 : target;
+
+    u64 seen = 0;
+    for (s32 i = 0; i < NUM_BUCKETS; i++)
+    {
+        seen += counts[i];
+        if (seen >= target)
+        {
+            // Never more than the biggest value actually added
+            u64 value = GetBucketValue(i);
+            return value < max ? value : max;
+        }
+    }
+
+    return max;
+}
+
+f64 Histogram::Mean() const
+{
+    return count ? (f64) total / count : 0.0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "basic_types.h"
+
+// Counts of values, usually latencies in microseconds, in buckets that are
+// 1/16 of a power of two wide. Percentiles come out within about 6% of the
+// real value with a fixed 8 KB, however many values go in.
+struct Histogram
+{
+    static constexpr s32 SUB_BITS    = 4;
+    static constexpr s32 SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr s32 NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    u64 counts[NUM_BUCKETS];
+    u64 count;
+    u64 total;
+    u64 max;
+
+    // Which of counts value goes in
+    static s32 BucketOf(u64 value);
+
+    void Clear();
+    void Add(u64 value);
+    void Merge(const Histogram& other);
+
+    // Smallest value at least fraction of the values are at or below,
+    // fraction is in [0, 1]. 0 if it's empty.
+    u64 Percentile(f64 fraction) const;
+    f64 Mean() const;
+};
@@ -0,0 +1,27 @@
+#include "random.h"
+
+#include "basic_types.h"
+
+void Random::Seed(u64 seed)
+{
+    // Zero is the one state xorshift can't leave
+    state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+}
+
+u64 Random::Next()
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+s32 Random::Range(s32 max)
+{
+    return (s32) (Next() % (u64) max);
+}
+
+f64 Random::Unit()
+{
+    return (f64) (Next() >> 11) * (1.0 / 9007199254740992.0);
+}
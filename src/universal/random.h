@@ -0,0 +1,15 @@
+#pragma once
+
+#include "basic_types.h"
+
+// xorshift64*, small and deterministic for a given seed.
+// Not thread safe, every thread should have its own.
+struct Random
+{
+    u64 state;
+
+    void Seed(u64 seed);
+    u64  Next();
+    s32  Range(s32 max);    // In [0, max)
+    f64  Unit();            // In [0, 1)
+};